@@ -0,0 +1,72 @@
+// Measures how parsing scales when several threads parse independent documents at once.
+// Build with -DBUILD_JSONPARSER_BENCH=ON and compare runs with and without -DJSONPARSER_POOL_ALLOCATOR=ON.
+
+#include "json/JsonParser.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace Json;
+
+static std::string buildDocument(int records) {
+    std::string json = "[";
+    for (int i = 0; i < records; i++) {
+        if (i > 0) json += ",";
+        json += "{\"id\":" + std::to_string(i) +
+                ",\"name\":\"record" + std::to_string(i) + "\"" +
+                ",\"active\":" + (i % 2 == 0 ? "true" : "false") +
+                ",\"score\":" + std::to_string(i * 0.25) +
+                ",\"tags\":[\"alpha\",\"beta\",\"gamma\"]" +
+                ",\"nested\":{\"x\":" + std::to_string(i) + ",\"y\":null}}";
+    }
+    json += "]";
+    return json;
+}
+
+static double runThreads(const std::string& json, unsigned threadCount, int docsPerThread) {
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned t = 0; t < threadCount; t++) {
+        threads.emplace_back([&json, docsPerThread]() {
+            for (int i = 0; i < docsPerThread; i++) {
+                JsonValue value = parseJson(json);
+                if (value.toArray().empty()) std::abort();
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return (threadCount * docsPerThread) / elapsed.count();
+}
+
+int main(int argc, char** argv) {
+    unsigned maxThreads = std::thread::hardware_concurrency();
+    if (argc > 1) maxThreads = static_cast<unsigned>(std::atoi(argv[1]));
+    if (maxThreads == 0) maxThreads = 1;
+    int docsPerThread = argc > 2 ? std::atoi(argv[2]) : 200;
+
+    std::string json = buildDocument(500);
+#ifdef JSONPARSER_POOL_ALLOCATOR
+    std::cout << "Payload allocator: pool" << std::endl;
+#else
+    std::cout << "Payload allocator: operator new" << std::endl;
+#endif
+    std::cout << "Document size: " << json.size() << " bytes, " << docsPerThread << " docs per thread" << std::endl;
+
+    double baseline = 0.0;
+    for (unsigned threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+        double docsPerSecond = runThreads(json, threadCount, docsPerThread);
+        if (threadCount == 1) baseline = docsPerSecond;
+        std::cout << std::setw(3) << threadCount << " threads: "
+                  << std::fixed << std::setprecision(1) << std::setw(10) << docsPerSecond << " docs/s, speedup "
+                  << std::setprecision(2) << docsPerSecond / baseline << "x" << std::endl;
+    }
+
+    std::cout << "Pooled bytes: " << pooledBytes() << ", trimmed: " << trimPools() << std::endl;
+    return 0;
+}
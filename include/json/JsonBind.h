@@ -0,0 +1,374 @@
+#ifndef JSONPARSER_BIND_H
+#define JSONPARSER_BIND_H
+
+#include "json/JsonParser.h"
+#include "json/JsonWriter.h"
+#include <map>
+
+#ifdef JSONPARSER_HAS_STRING_VIEW
+#define JSONPARSER_HAS_OPTIONAL 1
+#include <optional>
+#endif
+
+namespace Json {
+    namespace Detail {
+        // Pull parser over json text for the bound readers, nothing is allocated per value. Same grammar and
+        // exceptions as parseJson, except that skipped members are only matched for their brackets
+        class TextReader {
+        private:
+            const char* m_data;
+            size_t m_length;
+            size_t m_pos = 0;
+            std::string m_scratch; // Last key or string
+
+            void readLiteral(const char* literal, size_t length);
+            const std::string& readStringToken();
+
+        public:
+            TextReader(const char* data, size_t length) noexcept : m_data(data), m_length(length) {}
+
+            char peek(); // Next non whitespace character, throws at the end of the input
+            JsonType peekType();
+
+            bool readNull(); // Only consumes a null
+            bool readBool();
+            int readInt();
+            double readDouble(); // Integers as well
+            bool readNumber(int& intValue, double& doubleValue); // True for integers
+            const std::string& readString(); // Valid until the next read
+            JsonValue readValue(); // Whole subtree as a JsonValue, built while reading
+            void skipValue();
+
+            // Loop with first = true once, then false. Return false after consuming the closing bracket. Members
+            // leave the reader on their value, with the key in key()
+            void beginObject();
+            bool nextMember(bool first);
+            inline const std::string& key() const noexcept { return m_scratch; }
+            void beginArray();
+            bool nextElement(bool first);
+
+            void finish(); // Only whitespace may follow
+            [[noreturn]] void typeMismatch(const char* expected);
+        };
+
+        // hashKey evaluated at compile time, for the bound field names
+        constexpr size_t hashFieldName(const char* name, size_t length, uint64_t hash = 14695981039346656037ULL) {
+            return length == 0 ? static_cast<size_t>(hash) : hashFieldName(name + 1, length - 1, (hash ^ static_cast<unsigned char>(*name)) * 1099511628211ULL);
+        }
+
+        template <typename T>
+        struct BoundField {
+            const char* name;
+            size_t length;
+            size_t hash;
+            bool required;
+            void (*read)(TextReader& reader, T& object);
+            void (*write)(Writer& writer, const T& object); // Writes key and value, or nothing for an empty optional
+        };
+
+        template <typename T>
+        struct BoundFields {
+            const BoundField<T>* fields;
+            size_t count;
+
+            // Members usually arrive in declaration order, so the field after the last match is tried first
+            size_t find(const std::string& key, size_t expected) const noexcept {
+                size_t hash = hashKey(key.data(), key.length());
+                if (expected < count && fields[expected].hash == hash && key.compare(fields[expected].name) == 0)
+                    return expected;
+                for (size_t i = 0; i < count; i++) {
+                    if (fields[i].hash == hash && key.compare(fields[i].name) == 0)
+                        return i;
+                }
+                return count;
+            }
+        };
+
+        template <typename T>
+        struct IsOptional : std::false_type {};
+#ifdef JSONPARSER_HAS_OPTIONAL
+        template <typename T>
+        struct IsOptional<std::optional<T>> : std::true_type {};
+#endif
+
+        // jsonBinding is declared by JSON_BIND next to the struct and found through argument dependent lookup
+        template <typename T>
+        class HasBinding {
+        private:
+            template <typename U>
+            static auto test(int) -> decltype(jsonBinding(static_cast<U*>(nullptr)), std::true_type());
+            template <typename U>
+            static std::false_type test(...);
+
+        public:
+            static constexpr bool value = decltype(test<T>(0))::value;
+        };
+
+        // Declared up front, so nested containers find every overload
+        template <typename T, typename Allocator>
+        void readBound(TextReader& reader, std::vector<T, Allocator>& values);
+        template <typename Allocator>
+        void readBound(TextReader& reader, std::vector<bool, Allocator>& values);
+        template <typename T, typename Compare, typename Allocator>
+        void readBound(TextReader& reader, std::map<std::string, T, Compare, Allocator>& values);
+        template <typename T, typename Hash, typename Equal, typename Allocator>
+        void readBound(TextReader& reader, std::unordered_map<std::string, T, Hash, Equal, Allocator>& values);
+        template <typename T>
+        void readBound(TextReader& reader, T& object);
+        template <typename T, typename Allocator>
+        void writeBound(Writer& writer, const std::vector<T, Allocator>& values);
+        template <typename T, typename Compare, typename Allocator>
+        void writeBound(Writer& writer, const std::map<std::string, T, Compare, Allocator>& values);
+        template <typename T, typename Hash, typename Equal, typename Allocator>
+        void writeBound(Writer& writer, const std::unordered_map<std::string, T, Hash, Equal, Allocator>& values);
+        template <typename T>
+        void writeBound(Writer& writer, const T& object);
+#ifdef JSONPARSER_HAS_OPTIONAL
+        template <typename T>
+        void readBound(TextReader& reader, std::optional<T>& value);
+        template <typename T>
+        void writeBound(Writer& writer, const std::optional<T>& value);
+#endif
+
+        inline void readBound(TextReader& reader, bool& value) { value = reader.readBool(); }
+        inline void readBound(TextReader& reader, int& value) { value = reader.readInt(); }
+        inline void readBound(TextReader& reader, double& value) { value = reader.readDouble(); }
+        inline void readBound(TextReader& reader, float& value) { value = static_cast<float>(reader.readDouble()); }
+        inline void readBound(TextReader& reader, std::string& value) { value = reader.readString(); }
+        inline void readBound(TextReader& reader, JsonValue& value) { value = reader.readValue(); }
+
+        template <typename T, typename Allocator>
+        void readBound(TextReader& reader, std::vector<T, Allocator>& values) {
+            values.clear();
+            reader.beginArray();
+            for (bool first = true; reader.nextElement(first); first = false) {
+                values.emplace_back();
+                readBound(reader, values.back());
+            }
+        }
+
+        template <typename Allocator>
+        void readBound(TextReader& reader, std::vector<bool, Allocator>& values) {
+            values.clear();
+            reader.beginArray();
+            for (bool first = true; reader.nextElement(first); first = false) {
+                values.push_back(reader.readBool());
+            }
+        }
+
+        template <typename Map>
+        void readBoundMap(TextReader& reader, Map& values) {
+            values.clear();
+            reader.beginObject();
+            for (bool first = true; reader.nextMember(first); first = false) {
+                auto slot = values.emplace(reader.key(), typename Map::mapped_type());
+                if (slot.second) {
+                    readBound(reader, slot.first->second);
+                } else {
+                    reader.skipValue(); // First occurrence wins, like in parseJson
+                }
+            }
+        }
+
+        template <typename T, typename Compare, typename Allocator>
+        void readBound(TextReader& reader, std::map<std::string, T, Compare, Allocator>& values) { readBoundMap(reader, values); }
+        template <typename T, typename Hash, typename Equal, typename Allocator>
+        void readBound(TextReader& reader, std::unordered_map<std::string, T, Hash, Equal, Allocator>& values) { readBoundMap(reader, values); }
+
+#ifdef JSONPARSER_HAS_OPTIONAL
+        template <typename T>
+        void readBound(TextReader& reader, std::optional<T>& value) {
+            if (reader.readNull()) {
+                value.reset();
+            } else {
+                readBound(reader, value.emplace());
+            }
+        }
+#endif
+
+        // Bound structs. Unknown members are skipped, missing ones throw unless they are optional
+        template <typename T>
+        void readBound(TextReader& reader, T& object) {
+            static_assert(HasBinding<T>::value, "Type cannot be read from json, declare its fields with JSON_BIND");
+            const BoundFields<T>& bound = jsonBinding(static_cast<T*>(nullptr));
+            uint64_t seen = 0;
+            size_t expected = 0;
+            reader.beginObject();
+            for (bool first = true; reader.nextMember(first); first = false) {
+                size_t index = bound.find(reader.key(), expected);
+                if (index == bound.count || (seen & (1ULL << index))) {
+                    reader.skipValue();
+                    continue;
+                }
+                bound.fields[index].read(reader, object);
+                seen |= 1ULL << index;
+                expected = index + 1;
+            }
+            for (size_t i = 0; i < bound.count; i++) {
+                if (bound.fields[i].required && !(seen & (1ULL << i)))
+                    throw std::out_of_range(std::string("Key not found in json object: ") + bound.fields[i].name);
+            }
+        }
+
+        inline void writeBound(Writer& writer, bool value) { writer.value(value); }
+        inline void writeBound(Writer& writer, int value) { writer.value(value); }
+        inline void writeBound(Writer& writer, double value) { writer.value(value); }
+        inline void writeBound(Writer& writer, float value) { writer.value(static_cast<double>(value)); }
+        inline void writeBound(Writer& writer, const std::string& value) { writer.value(value); }
+        inline void writeBound(Writer& writer, const JsonValue& value) { writer.value(value); }
+
+        template <typename T, typename Allocator>
+        void writeBound(Writer& writer, const std::vector<T, Allocator>& values) {
+            writer.beginArray();
+            for (const auto& value : values) {
+                writeBound(writer, static_cast<const T&>(value)); // Unwraps the proxies of std::vector<bool>
+            }
+            writer.endArray();
+        }
+
+        template <typename Map>
+        void writeBoundMap(Writer& writer, const Map& values) {
+            writer.beginObject();
+            for (const auto& member : values) {
+                writer.key(member.first);
+                writeBound(writer, member.second);
+            }
+            writer.endObject();
+        }
+
+        template <typename T, typename Compare, typename Allocator>
+        void writeBound(Writer& writer, const std::map<std::string, T, Compare, Allocator>& values) { writeBoundMap(writer, values); }
+        template <typename T, typename Hash, typename Equal, typename Allocator>
+        void writeBound(Writer& writer, const std::unordered_map<std::string, T, Hash, Equal, Allocator>& values) { writeBoundMap(writer, values); }
+
+#ifdef JSONPARSER_HAS_OPTIONAL
+        template <typename T>
+        void writeBound(Writer& writer, const std::optional<T>& value) {
+            if (value) {
+                writeBound(writer, *value);
+            } else {
+                writer.value(nullptr);
+            }
+        }
+#endif
+
+        template <typename T>
+        void writeBound(Writer& writer, const T& object) {
+            static_assert(HasBinding<T>::value, "Type cannot be written as json, declare its fields with JSON_BIND");
+            const BoundFields<T>& bound = jsonBinding(static_cast<T*>(nullptr));
+            writer.beginObject();
+            for (size_t i = 0; i < bound.count; i++) {
+                bound.fields[i].write(writer, object);
+            }
+            writer.endObject();
+        }
+
+        template <typename T>
+        void writeBoundMember(Writer& writer, const char* name, const T& value) {
+            writer.key(name);
+            writeBound(writer, value);
+        }
+
+#ifdef JSONPARSER_HAS_OPTIONAL
+        template <typename T>
+        void writeBoundMember(Writer& writer, const char* name, const std::optional<T>& value) {
+            if (value) {
+                writer.key(name);
+                writeBound(writer, *value);
+            }
+        }
+#endif
+    }
+
+    // Parses json straight into a struct declared with JSON_BIND, or a vector, map or optional of them. No JsonValue
+    // is built on the way. Throws like parseJson, a JsonTypeException for values of the wrong type and
+    // std::out_of_range for missing required members. out is left partially assigned when an exception is thrown
+    template <typename T>
+    void fromJson(const std::string& json, T& out) {
+        Detail::TextReader reader(json.data(), json.length());
+        Detail::readBound(reader, out);
+        reader.finish();
+    }
+
+    template <typename T>
+    T fromJson(const std::string& json) {
+        T out{};
+        fromJson(json, out);
+        return out;
+    }
+
+    template <typename T>
+    void toJson(const T& value, Writer& writer) {
+        Detail::writeBound(writer, value);
+    }
+
+    template <typename T>
+    std::string toJson(const T& value, const WriteOptions& options = WriteOptions()) {
+        std::string out;
+        {
+            Writer writer(out, options);
+            Detail::writeBound(writer, value);
+        }
+        return out;
+    }
+}
+
+#define JSON_BIND_EXPAND(x) x
+#define JSON_BIND_CONCAT(a, b) JSON_BIND_CONCAT_(a, b)
+#define JSON_BIND_CONCAT_(a, b) a##b
+#define JSON_BIND_NARG(...) JSON_BIND_EXPAND(JSON_BIND_NARG_(__VA_ARGS__, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1))
+#define JSON_BIND_NARG_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, N, ...) N
+#define JSON_BIND_FOR_EACH_1(m, t, x) m(t, x)
+#define JSON_BIND_FOR_EACH_2(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_1(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_3(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_2(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_4(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_3(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_5(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_4(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_6(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_5(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_7(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_6(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_8(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_7(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_9(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_8(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_10(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_9(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_11(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_10(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_12(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_11(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_13(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_12(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_14(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_13(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_15(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_14(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_16(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_15(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_17(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_16(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_18(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_17(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_19(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_18(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_20(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_19(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_21(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_20(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_22(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_21(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_23(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_22(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_24(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_23(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_25(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_24(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_26(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_25(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_27(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_26(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_28(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_27(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_29(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_28(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_30(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_29(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_31(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_30(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH_32(m, t, x, ...) m(t, x) JSON_BIND_EXPAND(JSON_BIND_FOR_EACH_31(m, t, __VA_ARGS__))
+#define JSON_BIND_FOR_EACH(m, t, ...) JSON_BIND_EXPAND(JSON_BIND_CONCAT(JSON_BIND_FOR_EACH_, JSON_BIND_NARG(__VA_ARGS__))(m, t, __VA_ARGS__))
+
+#define JSON_BIND_FIELD(Type, field)                                                                                     \
+    { #field, sizeof(#field) - 1, std::integral_constant<size_t, ::Json::Detail::hashFieldName(#field, sizeof(#field) - 1)>::value, \
+      !::Json::Detail::IsOptional<decltype(Type::field)>::value,                                                        \
+      [](::Json::Detail::TextReader& reader, Type& object) { ::Json::Detail::readBound(reader, object.field); },         \
+      [](::Json::Writer& writer, const Type& object) { ::Json::Detail::writeBoundMember(writer, #field, object.field); } },
+
+// Declares the public members of Type that are read and written by fromJson and toJson, at most 32 of them. Use it
+// after the struct, in the same namespace:
+//     struct Point { int x; int y; };
+//     JSON_BIND(Point, x, y)
+// Members may be bool, int, double, float, std::string, JsonValue, other bound structs, std::vector, std::optional
+// and std::map or std::unordered_map with string keys of these. Non optional members are required when reading
+#define JSON_BIND(Type, ...)                                                                                             \
+    inline const ::Json::Detail::BoundFields<Type>& jsonBinding(Type*) {                                                 \
+        static const ::Json::Detail::BoundField<Type> fields[] = { JSON_BIND_FOR_EACH(JSON_BIND_FIELD, Type, __VA_ARGS__) }; \
+        static const ::Json::Detail::BoundFields<Type> bound = { fields, sizeof(fields) / sizeof(fields[0]) };         \
+        return bound;                                                                                                   \
+    }
+
+#endif
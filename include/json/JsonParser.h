@@ -1,11 +1,36 @@
 #ifndef JSONPARSER_H
 #define JSONPARSER_H
 
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iosfwd>
+#include <new>
+#include <type_traits>
 #include <unordered_map>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#define JSONPARSER_HAS_STRING_VIEW 1
+#include <string_view>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#define JSONPARSER_HAS_POSIX_IO 1
+#endif
+
+#if defined(JSONPARSER_MEMORY_RESOURCE) && defined(__has_include)
+#if __has_include(<memory_resource>) && defined(JSONPARSER_HAS_STRING_VIEW)
+#define JSONPARSER_HAS_PMR 1
+#include <memory_resource>
+#endif
+#endif
+
 namespace Json {
     class JsonMalformedException : public std::exception {
     private:
@@ -27,10 +52,230 @@ namespace Json {
         const char* what() const noexcept override { return m_message.c_str(); }
     };
 
+    class JsonWriteException : public std::exception {
+    private:
+        const std::string m_message;
+
+    public:
+        explicit JsonWriteException(const std::string& message = "") : m_message(message) {}
+
+        const char* what() const noexcept override { return m_message.c_str(); }
+    };
+
     class JsonValue;
-    using JsonObject = std::unordered_map<std::string, JsonValue>;
+    struct WriteOptions;
+
+    // FNV-1a hash used for all object keys
+    inline size_t hashKey(const char* data, size_t length) noexcept {
+        uint64_t hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < length; i++) {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 1099511628211ULL;
+        }
+        return static_cast<size_t>(hash);
+    }
+
+    // Object key with a precomputed hash, build it once and reuse it for lookups in hot loops
+    class Key {
+    private:
+        std::string m_name;
+        size_t m_hash;
+
+    public:
+        explicit Key(const char* name) : m_name(name), m_hash(hashKey(m_name.data(), m_name.length())) {}
+        explicit Key(std::string name) : m_name(std::move(name)), m_hash(hashKey(m_name.data(), m_name.length())) {}
+
+        inline const std::string& name() const noexcept { return m_name; }
+        inline size_t hash() const noexcept { return m_hash; }
+    };
+
+    // Transparent so lookups with string views do not need a temporary std::string where the standard library allows it
+    struct KeyHash {
+        using is_transparent = void;
+
+        size_t operator()(const std::string& key) const noexcept { return hashKey(key.data(), key.length()); }
+        size_t operator()(const Key& key) const noexcept { return key.hash(); }
+        size_t operator()(const char* key) const noexcept { return hashKey(key, std::strlen(key)); }
+#ifdef JSONPARSER_HAS_STRING_VIEW
+        size_t operator()(std::string_view key) const noexcept { return hashKey(key.data(), key.length()); }
+#endif
+    };
+
+    struct KeyEqual {
+        using is_transparent = void;
+
+        bool operator()(const std::string& lhs, const std::string& rhs) const noexcept { return lhs == rhs; }
+        bool operator()(const std::string& lhs, const char* rhs) const noexcept { return lhs == rhs; }
+        bool operator()(const char* lhs, const std::string& rhs) const noexcept { return rhs == lhs; }
+        bool operator()(const std::string& lhs, const Key& rhs) const noexcept { return lhs == rhs.name(); }
+        bool operator()(const Key& lhs, const std::string& rhs) const noexcept { return lhs.name() == rhs; }
+#ifdef JSONPARSER_HAS_STRING_VIEW
+        bool operator()(const std::string& lhs, std::string_view rhs) const noexcept { return lhs == rhs; }
+        bool operator()(std::string_view lhs, const std::string& rhs) const noexcept { return lhs == rhs; }
+#endif
+    };
+
+#ifdef JSONPARSER_MEMORY_RESOURCE
+    // Source of JsonValue payloads, container storage and shapes. Characters of strings and keys that do not fit
+    // the small string buffer still come from the global heap
+    class MemoryResource {
+    public:
+        virtual ~MemoryResource() = default;
+
+        virtual void* allocate(size_t size, size_t alignment) = 0;
+        virtual void deallocate(void* memory, size_t size, size_t alignment) noexcept = 0;
+    };
+
+    MemoryResource* defaultMemoryResource() noexcept; // Payload pool or operator new
+    MemoryResource* currentMemoryResource() noexcept; // Resource used by the calling thread for new allocations
+
+    // Makes a resource current for the calling thread until the scope ends. The resource has to outlive every value
+    // allocated from it
+    class MemoryResourceScope {
+    private:
+        MemoryResource* m_previous;
+
+    public:
+        explicit MemoryResourceScope(MemoryResource* resource) noexcept;
+        ~MemoryResourceScope();
+
+        MemoryResourceScope(const MemoryResourceScope&) = delete;
+        MemoryResourceScope& operator=(const MemoryResourceScope&) = delete;
+    };
+
+#ifdef JSONPARSER_HAS_PMR
+    // Forwards to a std::pmr::memory_resource
+    class PmrMemoryResource : public MemoryResource {
+    private:
+        std::pmr::memory_resource* m_upstream;
+
+    public:
+        explicit PmrMemoryResource(std::pmr::memory_resource* upstream) noexcept : m_upstream(upstream) {}
+
+        void* allocate(size_t size, size_t alignment) override { return m_upstream->allocate(size, alignment); }
+        void deallocate(void* memory, size_t size, size_t alignment) noexcept override { m_upstream->deallocate(memory, size, alignment); }
+        inline std::pmr::memory_resource* upstream() const noexcept { return m_upstream; }
+    };
+#endif
+
+    // Stateful allocator bound to the resource that was current when the container got created.
+    // Copies of a container pick up the resource current at that time, moves keep the original one
+    template <typename T>
+    class Allocator {
+    private:
+        template <typename U> friend class Allocator;
+        MemoryResource* m_resource;
+
+    public:
+        using value_type = T;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        Allocator() noexcept : m_resource(currentMemoryResource()) {}
+        Allocator(MemoryResource* resource) noexcept : m_resource(resource) {}
+        template <typename U>
+        Allocator(const Allocator<U>& other) noexcept : m_resource(other.m_resource) {}
+
+        T* allocate(size_t count) {
+            if (count > static_cast<size_t>(-1) / sizeof(T))
+                throw std::bad_alloc();
+            return static_cast<T*>(m_resource->allocate(count * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T* memory, size_t count) noexcept { m_resource->deallocate(memory, count * sizeof(T), alignof(T)); }
+
+        Allocator select_on_container_copy_construction() const noexcept { return Allocator(); }
+        inline MemoryResource* resource() const noexcept { return m_resource; }
+
+        template <typename U>
+        bool operator==(const Allocator<U>& other) const noexcept { return m_resource == other.m_resource; }
+        template <typename U>
+        bool operator!=(const Allocator<U>& other) const noexcept { return m_resource != other.m_resource; }
+    };
+#else
+    template <typename T>
+    using Allocator = std::allocator<T>;
+#endif
+
+    namespace Detail {
+        class Shape;
+        struct ShapedObject;
+        struct SharedNode;
+        struct PackedArray;
+        struct ValueAccess;
+        class UsageCollector;
+
+        enum class Layout : unsigned char {
+            Default,
+            Shaped, // Object values in a flat slot array, keys live in a shape shared between records
+            Shared, // Reference counted node, cloned by the first non const access
+            Packed // Array of numbers in contiguous int or double buffers
+        };
+
+#ifdef JSONPARSER_POOL_ALLOCATOR
+        // Thread caching size class pool, sizes above its largest class go to operator new
+        void* poolAllocate(size_t size);
+        void poolDeallocate(void* block, size_t size) noexcept;
+#endif
+
+        // Heap payloads of JsonValue. With JSONPARSER_MEMORY_RESOURCE every payload records the resource it came from
+#if defined(JSONPARSER_MEMORY_RESOURCE)
+        void* allocatePayload(size_t size);
+        void deallocatePayload(void* payload, size_t size) noexcept;
+        MemoryResource* payloadResource(const void* payload) noexcept;
+#elif defined(JSONPARSER_POOL_ALLOCATOR)
+        inline void* allocatePayload(size_t size) { return poolAllocate(size); }
+        inline void deallocatePayload(void* payload, size_t size) noexcept { poolDeallocate(payload, size); }
+#else
+        inline void* allocatePayload(size_t size) { return ::operator new(size); }
+        inline void deallocatePayload(void* payload, size_t) noexcept { ::operator delete(payload); }
+#endif
+
+        template <typename T, typename... Args>
+        T* createPayload(Args&&... args) {
+            void* memory = allocatePayload(sizeof(T));
+            try {
+                return new (memory) T(std::forward<Args>(args)...);
+            } catch (...) {
+                deallocatePayload(memory, sizeof(T));
+                throw;
+            }
+        }
+
+        template <typename T>
+        void destroyPayload(T* payload) noexcept {
+            if (payload) {
+                payload->~T();
+                deallocatePayload(payload, sizeof(T));
+            }
+        }
+
+        // Selects the C string key overloads without making integer literals like 0 ambiguous with array indices
+        template <typename T>
+        using EnableIfCString = typename std::enable_if<std::is_same<T, const char*>::value || std::is_same<T, char*>::value, int>::type;
+    }
+
+    // Read only view of contiguous elements
+    template <typename T>
+    class Span {
+    private:
+        const T* m_data;
+        size_t m_size;
+
+    public:
+        Span(const T* data, size_t size) noexcept : m_data(data), m_size(size) {}
+
+        inline const T* data() const noexcept { return m_data; }
+        inline size_t size() const noexcept { return m_size; }
+        inline bool empty() const noexcept { return m_size == 0; }
+        inline const T* begin() const noexcept { return m_data; }
+        inline const T* end() const noexcept { return m_data + m_size; }
+        inline const T& operator[](size_t index) const noexcept { return m_data[index]; }
+    };
+
+    using JsonObject = std::unordered_map<std::string, JsonValue, KeyHash, KeyEqual, Allocator<std::pair<const std::string, JsonValue>>>;
     using JsonObjectEntry = std::pair<std::string, JsonValue>;
-    using JsonArray = std::vector<JsonValue>;
+    using JsonArray = std::vector<JsonValue, Allocator<JsonValue>>;
 
     enum class JsonType {
         Bool,
@@ -51,24 +296,43 @@ namespace Json {
             std::string* s_value;
             JsonObject* o_value;
             JsonArray* a_value;
+            Detail::ShapedObject* r_value;
+            Detail::SharedNode* h_value;
+            Detail::PackedArray* n_value;
         };
 
         JsonType m_type;
+        Detail::Layout m_layout = Detail::Layout::Default;
 
+        inline bool hasLayout(Detail::Layout layout) const noexcept { return m_layout == layout; }
+        const JsonValue& resolved() const noexcept;
         void destroy();
+        void collectNested(std::vector<JsonValue>& pending) noexcept;
+        void detach();
+        void unshape();
+        void unpack();
+        const JsonValue* findMember(const std::string& key) const;
+        const JsonValue* findMember(const char* key, size_t length) const;
+        const JsonValue* findMember(const Key& key) const;
+        const JsonValue& atKey(const char* key, size_t length) const;
+        JsonValue& atKey(const char* key, size_t length);
+        JsonValue& subscriptKey(const char* key, size_t length);
+
+        friend struct Detail::ValueAccess;
+        friend class Detail::UsageCollector;
 
     public:
         JsonValue() noexcept : b_value(false), m_type(JsonType::Null) {}
         JsonValue(bool value) noexcept : b_value(value), m_type(JsonType::Bool) {}
         JsonValue(int value) noexcept : i_value(value), m_type(JsonType::Integer) {}
         JsonValue(double value) noexcept : d_value(value), m_type(JsonType::Double) {}
-        JsonValue(const char* value) : s_value(new std::string(value)), m_type(JsonType::String) {}
-        JsonValue(const std::string& value) : s_value(new std::string(value)), m_type(JsonType::String) {}
-        JsonValue(const JsonObject& value) : o_value(new JsonObject(value)), m_type(JsonType::Object) {}
-        JsonValue(const JsonArray& value) : a_value(new JsonArray(value)), m_type(JsonType::Array) {}
-        JsonValue(std::string&& value) : s_value(new std::string(std::move(value))), m_type(JsonType::String) {}
-        JsonValue(JsonObject&& value) : o_value(new JsonObject(std::move(value))), m_type(JsonType::Object) {}
-        JsonValue(JsonArray&& value) : a_value(new JsonArray(std::move(value))), m_type(JsonType::Array) {}
+        JsonValue(const char* value) : s_value(Detail::createPayload<std::string>(value)), m_type(JsonType::String) {}
+        JsonValue(const std::string& value) : s_value(Detail::createPayload<std::string>(value)), m_type(JsonType::String) {}
+        JsonValue(const JsonObject& value) : o_value(Detail::createPayload<JsonObject>(value)), m_type(JsonType::Object) {}
+        JsonValue(const JsonArray& value) : a_value(Detail::createPayload<JsonArray>(value)), m_type(JsonType::Array) {}
+        JsonValue(std::string&& value) : s_value(Detail::createPayload<std::string>(std::move(value))), m_type(JsonType::String) {}
+        JsonValue(JsonObject&& value) : o_value(Detail::createPayload<JsonObject>(std::move(value))), m_type(JsonType::Object) {}
+        JsonValue(JsonArray&& value) : a_value(Detail::createPayload<JsonArray>(std::move(value))), m_type(JsonType::Array) {}
         JsonValue(std::nullptr_t) noexcept : b_value(false), m_type(JsonType::Null) {}
 
         JsonValue(const JsonValue& other); // Copy constructor
@@ -84,15 +348,37 @@ namespace Json {
         inline bool isObject() const noexcept { return m_type == JsonType::Object; }
         inline bool isArray() const noexcept { return m_type == JsonType::Array; }
         inline bool isNull() const noexcept { return m_type == JsonType::Null; }
+        // Shaped objects fall back to a regular JsonObject when a new key is inserted or on non const toObject().
+        // Like std::vector::insert, that invalidates references into the record, mutable access to existing keys
+        // returns the value slot in place. A const toObject() copy does not see later writes through slot references
+        // obtained before it was built
+        bool isShaped() const noexcept;
+        // Packed arrays fall back to a regular JsonArray on the first mutable access
+        bool isPacked() const noexcept;
+        bool pack(); // Converts an array of numbers to the packed layout, returns false if any element is not a number
+        // Zero copy access to packed arrays, throws JsonTypeException if the value is not packed with that element type
+        Span<double> asDoubleSpan() const;
+        Span<int> asIntSpan() const;
+        // Shared values are copied in O(1) and only cloned along the path of non const accessors
+        inline bool isShared() const noexcept { return m_layout == Detail::Layout::Shared; }
+        void share();
         bool isEmpty() const;
+        size_t size() const; // Members or elements in any layout, throws JsonTypeException for other types
 
         // Cast methods might throw JsonTypeException when casting to the wrong type
         bool toBool() const;
         int toInt() const;
         double toDouble() const;
         const std::string& toString() const;
-        const JsonObject& toObject() const;
-        const JsonArray& toArray() const;
+        const JsonObject& toObject() const; // Builds a copy of a shaped record once, forEachMember reads it in place
+        const JsonArray& toArray() const; // Builds a copy of a packed array once, like const at() and operator[]
+
+        // Visits the members of an object in its iteration order until the visitor returns false, throws
+        // JsonTypeException for other types. Returns false if the visit was stopped
+        bool forEachMember(const std::function<bool(const std::string& key, const JsonValue& value)>& visit) const;
+        // Visits the elements of an array in order, like forEachMember. Elements of a packed array are read from its
+        // buffers and only live for the duration of the call
+        bool forEachElement(const std::function<bool(size_t index, const JsonValue& value)>& visit) const;
 
         // Read / Write casts
         std::string& toString();
@@ -111,9 +397,37 @@ namespace Json {
         JsonValue& operator[](const std::string& key); // Infers default value if non existent value is accessed
         JsonValue& operator[](size_t index);
 
+        // Lookups with a precomputed hash, no key hashing on the lookup path
+        const JsonValue& at(const Key& key) const;
+        JsonValue& at(const Key& key);
+        const JsonValue& operator[](const Key& key) const;
+        JsonValue& operator[](const Key& key);
+        const JsonValue* find(const Key& key) const; // Nullptr for missing keys and non objects, nothing thrown on a miss
+
+        // Key lookups without a temporary std::string, a key is only allocated when operator[] inserts it
+        template <typename T, Detail::EnableIfCString<T> = 0>
+        const JsonValue& at(T key) const { return atKey(key, std::strlen(key)); }
+        template <typename T, Detail::EnableIfCString<T> = 0>
+        JsonValue& at(T key) { return atKey(key, std::strlen(key)); }
+        template <typename T, Detail::EnableIfCString<T> = 0>
+        const JsonValue& operator[](T key) const { return atKey(key, std::strlen(key)); }
+        template <typename T, Detail::EnableIfCString<T> = 0>
+        JsonValue& operator[](T key) { return subscriptKey(key, std::strlen(key)); }
+#ifdef JSONPARSER_HAS_STRING_VIEW
+        const JsonValue& at(std::string_view key) const { return atKey(key.data(), key.length()); }
+        JsonValue& at(std::string_view key) { return atKey(key.data(), key.length()); }
+        const JsonValue& operator[](std::string_view key) const { return atKey(key.data(), key.length()); }
+        JsonValue& operator[](std::string_view key) { return subscriptKey(key.data(), key.length()); }
+#endif
+
         bool operator==(const JsonValue& other) const;
         bool operator!=(const JsonValue& other) const;
 
+        // Structural 64 bit hash, equal values hash equally regardless of layout and object member order.
+        // Only cached on shared nodes, which are immutable, so comparing shared snapshots is O(1) once hashed.
+        // Anything else is walked in full on every call
+        uint64_t hash() const;
+
         JsonValue& operator=(bool value) noexcept;
         JsonValue& operator=(int value) noexcept;
         JsonValue& operator=(double value) noexcept;
@@ -128,13 +442,115 @@ namespace Json {
         JsonValue& operator=(JsonValue&& other) noexcept;
         JsonValue& operator=(std::nullptr_t) noexcept;
 
-        friend std::string toJsonString(const JsonValue& value);
+        friend size_t serializedSize(const JsonValue& value, const WriteOptions& options);
     };
 
     std::ostream& operator<<(std::ostream& os, const JsonValue& value);
 
+    // Returns pooled payload memory that no thread holds anymore to the system, returns the number of released bytes.
+    // Does nothing unless built with JSONPARSER_POOL_ALLOCATOR
+    size_t trimPools();
+    size_t pooledBytes(); // Bytes currently reserved by the payload pool
+
+    // Heap memory owned by a JsonValue tree. Shapes and shared nodes referenced several times are counted once
+    struct MemoryUsage {
+        size_t nodes[7] = {}; // Values per JsonType, index with static_cast<size_t>(type)
+        size_t stringBytes = 0; // Heap buffers of string values and object keys
+        size_t containerOverhead = 0; // Map buckets and node links, unused vector capacity, shape lookup tables
+        size_t totalBytes = 0; // Everything above plus payload objects and used container storage
+
+        inline size_t count(JsonType type) const noexcept { return nodes[static_cast<size_t>(type)]; }
+        size_t nodeCount() const noexcept;
+    };
+
+    MemoryUsage memoryUsage(const JsonValue& value);
+
+    struct ParseOptions {
+        bool shareShapes = false; // Objects with the same key sequence share one shape, each distinct key is decoded once
+        bool packNumbers = false; // Arrays that only hold numbers are stored in packed buffers
+        MemoryUsage* stats = nullptr; // Collects the memoryUsage() of the document while parsing
+#ifdef JSONPARSER_MEMORY_RESOURCE
+        MemoryResource* memoryResource = nullptr; // Allocate the whole document from this resource instead of the current one
+#endif
+    };
+
+    // Hands a document to a background thread that frees it, keeps large free cascades off latency sensitive threads.
+    // Values from a memory resource require a resource that may be used from another thread
+    void releaseAsync(JsonValue&& value);
+    void waitForReleases(); // Blocks until everything passed to releaseAsync so far has been freed
+
+    struct WriteOptions {
+        bool escapeNonAscii = false; // Write characters above ASCII as \uXXXX escapes, the output is then pure ASCII
+        // RFC 8785 (JCS) canonical form: keys sorted by UTF-16 code units, numbers in their shortest round trip form,
+        // only mandatory escapes. Equal documents give identical bytes, escapeNonAscii and the formatting below are ignored.
+        // The member order is cached per shape, regular objects are sorted again on every write
+        bool canonical = false;
+
+        // Pretty printing, enabled by a non zero indent or indentWithTabs
+        unsigned int indent = 0; // Spaces per nesting level
+        bool indentWithTabs = false; // One tab per nesting level instead
+        const char* newline = "\n";
+        bool spaceAfterColon = false; // Also applies to single line output
+        size_t inlineWidth = 0; // Containers whose single line form is at most this long are not broken into lines
+
+        // Containers with many elements are split into chunks that are serialized on up to this many threads and
+        // joined in order, the output is identical. 0 uses one thread per core
+        unsigned int threads = 1;
+    };
+
     std::string toJsonString(const JsonValue& value);
+    std::string toJsonString(const JsonValue& value, const WriteOptions& options);
+    // Appends to out, so clearing and reusing one buffer avoids reallocations. reserveExact runs a sizing pass
+    // first and grows out at most once
+    void toJsonString(const JsonValue& value, std::string& out, bool reserveExact = false);
+    void toJsonString(const JsonValue& value, std::string& out, const WriteOptions& options, bool reserveExact = false);
+    size_t serializedSize(const JsonValue& value); // Exact length of toJsonString(value)
+    size_t serializedSize(const JsonValue& value, const WriteOptions& options);
+
+    // Streaming serialization through a fixed buffer, memory use is bounded by the buffer and the nesting depth
+    // instead of the document size. Failed writes throw a JsonWriteException
+    using WriteCallback = std::function<void(const char* data, size_t length)>;
+    constexpr size_t defaultWriteBufferSize = 64 * 1024;
+
+    void writeJson(const JsonValue& value, std::ostream& os, size_t bufferSize = defaultWriteBufferSize);
+    void writeJson(const JsonValue& value, std::FILE* file, size_t bufferSize = defaultWriteBufferSize);
+    void writeJson(const JsonValue& value, const WriteCallback& callback, size_t bufferSize = defaultWriteBufferSize);
+    void writeJson(const JsonValue& value, std::ostream& os, const WriteOptions& options, size_t bufferSize = defaultWriteBufferSize);
+    void writeJson(const JsonValue& value, std::FILE* file, const WriteOptions& options, size_t bufferSize = defaultWriteBufferSize);
+    void writeJson(const JsonValue& value, const WriteCallback& callback, const WriteOptions& options, size_t bufferSize = defaultWriteBufferSize);
+#ifdef JSONPARSER_HAS_POSIX_IO
+    void writeJsonToFd(const JsonValue& value, int fd, size_t bufferSize = defaultWriteBufferSize); // Uses writev for large chunks
+    void writeJsonToFd(const JsonValue& value, int fd, const WriteOptions& options, size_t bufferSize = defaultWriteBufferSize);
+#endif
+
+    // Digests of the canonical form, computed while serializing without building the string. Suitable as cache
+    // keys and ETags
+    using Sha256Digest = std::array<uint8_t, 32>;
+    Sha256Digest canonicalSha256(const JsonValue& value);
+    uint64_t canonicalXxHash64(const JsonValue& value, uint64_t seed = 0);
+
+    // MessagePack and CBOR (RFC 8949) encodings. Integers and doubles keep their binary form and containers are
+    // length prefixed, so decoders reserve capacity up front. Integers outside the int range decode to doubles when
+    // that is exact. Data without a json equivalent, like byte strings or non string keys, throws a
+    // JsonMalformedException
+    std::string toMessagePack(const JsonValue& value);
+    void toMessagePack(const JsonValue& value, std::string& out); // Appends to out
+    void writeMessagePack(const JsonValue& value, std::ostream& os, size_t bufferSize = defaultWriteBufferSize);
+    void writeMessagePack(const JsonValue& value, const WriteCallback& callback, size_t bufferSize = defaultWriteBufferSize);
+    JsonValue fromMessagePack(const std::string& data);
+    JsonValue fromMessagePack(const void* data, size_t length);
+    JsonValue fromMessagePack(std::istream& is); // Reads one value and leaves the stream right behind it
+
+    std::string toCbor(const JsonValue& value);
+    void toCbor(const JsonValue& value, std::string& out); // Appends to out
+    void writeCbor(const JsonValue& value, std::ostream& os, size_t bufferSize = defaultWriteBufferSize);
+    void writeCbor(const JsonValue& value, const WriteCallback& callback, size_t bufferSize = defaultWriteBufferSize);
+    JsonValue fromCbor(const std::string& data);
+    JsonValue fromCbor(const void* data, size_t length);
+    JsonValue fromCbor(std::istream& is); // Reads one value and leaves the stream right behind it
+
     JsonValue parseJson(const std::string& json);
+    JsonValue parseJson(const std::string& json, const ParseOptions& options);
 
     inline std::string jsonTypeToString(JsonType type) {
         switch (type) {
@@ -150,4 +566,11 @@ namespace Json {
     }
 }
 
+namespace std {
+    template <>
+    struct hash<Json::JsonValue> {
+        size_t operator()(const Json::JsonValue& value) const { return static_cast<size_t>(value.hash()); }
+    };
+}
+
 #endif
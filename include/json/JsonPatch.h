@@ -0,0 +1,29 @@
+#ifndef JSONPARSER_PATCH_H
+#define JSONPARSER_PATCH_H
+
+#include "json/JsonParser.h"
+
+namespace Json {
+    class JsonPatchException : public std::exception {
+    private:
+        const std::string m_message;
+
+    public:
+        explicit JsonPatchException(const std::string& message = "") : m_message(message) {}
+
+        const char* what() const noexcept override { return m_message.c_str(); }
+    };
+
+    // Applies an RFC 6902 patch in place. Nothing is copied that can be moved: move relocates the subtree and the
+    // rvalue overload takes added values out of the patch. All or nothing, a failing operation rolls back the ones
+    // before it. Malformed operations throw a JsonMalformedException before the document is touched, operations that
+    // do not apply to it a JsonPatchException, which includes a failed test
+    void applyPatch(JsonValue& document, const JsonValue& patch);
+    void applyPatch(JsonValue& document, JsonValue&& patch);
+
+    // Patch that turns from into to. Unchanged subtrees are skipped, equal shared nodes in O(1), and arrays only get
+    // operations between their common prefix and suffix
+    JsonValue diff(const JsonValue& from, const JsonValue& to);
+}
+
+#endif
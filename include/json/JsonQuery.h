@@ -0,0 +1,38 @@
+#ifndef JSONPARSER_QUERY_H
+#define JSONPARSER_QUERY_H
+
+#include "json/JsonParser.h"
+#include <memory>
+
+namespace Json {
+    // JSONPath query (RFC 9535), compiled once into segments with prehashed names, index and slice selectors,
+    // wildcards, recursive descent and filter predicates over relative @ paths. Results are the nodelist of the RFC:
+    // selector order within a segment, duplicates kept. Members of an object come in its iteration order for a tree and
+    // in text order for evaluateJson. Safe to evaluate from several threads
+    class Query {
+    private:
+        struct Program;
+        std::unique_ptr<const Program> m_program;
+
+        explicit Query(std::unique_ptr<const Program> program) noexcept;
+
+    public:
+        // Throws a JsonMalformedException with the position of the first syntax error
+        static Query compile(const std::string& expression);
+
+        Query(Query&& other) noexcept;
+        Query& operator=(Query&& other) noexcept;
+        ~Query();
+
+        // Pointers into the document, valid while it is neither modified nor destroyed
+        std::vector<const JsonValue*> evaluate(const JsonValue& document) const;
+
+        // Evaluates while parsing, subtrees no segment can match are skipped without being built. Matches, filter
+        // candidates and arrays that need their length (negative indices and slices) are parsed into a JsonValue.
+        // Matches are collected in document order and sorted into nodelist order at the end
+        // Skipped subtrees only need matching brackets, malformed json elsewhere throws like parseJson
+        std::vector<JsonValue> evaluateJson(const std::string& json) const;
+    };
+}
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef JSONPARSER_SCHEMA_H
+#define JSONPARSER_SCHEMA_H
+
+#include "json/JsonParser.h"
+#include <memory>
+
+namespace Json {
+    struct SchemaError {
+        std::string path; // Json pointer of the failing value, empty for the root
+        std::string message;
+    };
+
+    // JSON Schema validator, compiled once into a flat program: $refs resolved to node indices, property and required
+    // keys merged into one table per object schema, each distinct pattern compiled once and cheap checks ordered
+    // before nested ones. Supports the validation keywords of draft 7 and 2020-12 with local $refs, format and other
+    // annotations are ignored. Validation stops at the first violation and is safe to run from several threads
+    class Schema {
+    private:
+        struct Program;
+        std::unique_ptr<const Program> m_program;
+
+        explicit Schema(std::unique_ptr<const Program> program) noexcept;
+
+    public:
+        // Throws a JsonMalformedException for invalid keywords and for $refs outside the document
+        static Schema compile(const JsonValue& schema);
+
+        Schema(Schema&& other) noexcept;
+        Schema& operator=(Schema&& other) noexcept;
+        ~Schema();
+
+        bool validate(const JsonValue& value, SchemaError* error = nullptr) const;
+
+        // Validates while parsing, without building the document. Subtrees that need more than one look (enum, const,
+        // the combinators, uniqueItems and contains) are parsed into a JsonValue first. Malformed json throws like
+        // parseJson, nothing after the first violation is read
+        bool validateJson(const std::string& json, SchemaError* error = nullptr) const;
+    };
+}
+
+#endif
@@ -0,0 +1,152 @@
+#ifndef JSONPARSER_TAPE_H
+#define JSONPARSER_TAPE_H
+
+#include "json/JsonParser.h"
+#include <memory>
+
+namespace Json {
+    namespace Detail {
+        // Flat form of a document, one 64 bit word per value with the tag in the top byte. Doubles are followed by a
+        // word with their bits, containers store the index of their end word and their element count, strings an
+        // offset into the side buffer. No pointers, so the same bytes work at any address
+        struct TapeData {
+            const uint64_t* words = nullptr;
+            size_t wordCount = 0;
+            const char* strings = nullptr; // Each string is a 32 bit length, the bytes and a terminating zero
+            size_t stringBytes = 0;
+        };
+    }
+
+    // Read only handle to a value of a tape. Cheap to copy, valid as long as the document it points into
+    class ElementView {
+    private:
+
+        const Detail::TapeData* m_tape;
+        size_t m_index;
+
+        inline uint64_t word() const noexcept { return m_tape->words[m_index]; }
+        inline unsigned char tag() const noexcept { return static_cast<unsigned char>(word() >> 56); }
+        size_t endIndex() const; // Index of the end word of a container
+        ElementView member(const char* key, size_t length) const;
+        ElementView element(size_t index) const;
+
+    public:
+        ElementView(const Detail::TapeData* tape, size_t index) noexcept : m_tape(tape), m_index(index) {}
+
+        // Elements of an array, or the values of an object with their key()
+        class Iterator {
+        private:
+            const Detail::TapeData* m_tape;
+            size_t m_index;
+            bool m_object;
+
+        public:
+            Iterator(const Detail::TapeData* tape, size_t index, bool object) noexcept : m_tape(tape), m_index(index), m_object(object) {}
+
+            ElementView operator*() const noexcept { return ElementView(m_tape, m_object ? m_index + 1 : m_index); }
+            ElementView key() const noexcept { return ElementView(m_tape, m_index); } // Objects only, a string
+            Iterator& operator++();
+            inline bool operator==(const Iterator& other) const noexcept { return m_index == other.m_index; }
+            inline bool operator!=(const Iterator& other) const noexcept { return m_index != other.m_index; }
+        };
+
+        JsonType type() const;
+        inline bool isBool() const noexcept { return tag() == 't' || tag() == 'f'; }
+        inline bool isInt() const noexcept { return tag() == 'l'; }
+        inline bool isDouble() const noexcept { return tag() == 'd'; }
+        inline bool isString() const noexcept { return tag() == 's'; }
+        inline bool isObject() const noexcept { return tag() == '{'; }
+        inline bool isArray() const noexcept { return tag() == '['; }
+        inline bool isNull() const noexcept { return tag() == 'n'; }
+
+        // Same exceptions as the JsonValue accessors
+        bool toBool() const;
+        int toInt() const;
+        double toDouble() const;
+        std::string toString() const; // Copies, stringData() does not
+        const char* stringData() const; // Zero terminated
+        size_t stringLength() const;
+#ifdef JSONPARSER_HAS_STRING_VIEW
+        std::string_view toStringView() const;
+#endif
+
+        size_t size() const; // Elements or members, constant time below 16 million of them
+        bool isEmpty() const;
+
+        // Members are found by a linear scan, elements by skipping their predecessors. Iterate for sequential access
+        ElementView at(const std::string& key) const;
+        ElementView at(size_t index) const;
+        ElementView operator[](const std::string& key) const { return at(key); }
+        ElementView operator[](size_t index) const { return at(index); }
+        template <typename T, Detail::EnableIfCString<T> = 0>
+        ElementView at(T key) const { return member(key, std::strlen(key)); }
+        template <typename T, Detail::EnableIfCString<T> = 0>
+        ElementView operator[](T key) const { return member(key, std::strlen(key)); }
+#ifdef JSONPARSER_HAS_STRING_VIEW
+        ElementView at(std::string_view key) const { return member(key.data(), key.length()); }
+        ElementView operator[](std::string_view key) const { return member(key.data(), key.length()); }
+#endif
+
+        Iterator begin() const;
+        Iterator end() const;
+
+        JsonValue toJsonValue() const; // Deep copy into a mutable tree
+    };
+
+    // Immutable document in one word array and one string buffer. Iterating is a linear walk, skipping a subtree a
+    // single jump. Built straight from the text by parseTape, without allocating per value
+    class Tape {
+    private:
+        struct State;
+        std::unique_ptr<State> m_state;
+
+        explicit Tape(std::unique_ptr<State> state) noexcept;
+        friend Tape parseTape(const std::string& json);
+        friend std::string toSnapshot(const Tape& tape);
+        friend void writeSnapshot(const Tape& tape, std::ostream& os);
+        friend void writeSnapshot(const Tape& tape, const WriteCallback& callback);
+
+    public:
+        explicit Tape(const JsonValue& value);
+
+        Tape(Tape&& other) noexcept;
+        Tape& operator=(Tape&& other) noexcept;
+        ~Tape();
+
+        ElementView root() const noexcept;
+        size_t sizeBytes() const noexcept; // Words and strings
+    };
+
+    Tape parseTape(const std::string& json); // Same grammar and exceptions as parseJson
+
+    // Document stored as header, tape words and string buffer. Opening maps the file and only checks the header, the
+    // first accesses page the data in. Read only pages of one file are shared by every process that opens it.
+    // Snapshots are trusted input, only open files written by writeSnapshot
+    class Snapshot {
+    private:
+        struct State;
+        std::unique_ptr<State> m_state;
+
+        explicit Snapshot(std::unique_ptr<State> state) noexcept;
+
+    public:
+        static Snapshot open(const std::string& path); // mmap where available, otherwise the file is read
+        static Snapshot fromBuffer(const void* data, size_t length); // Copies the data
+
+        Snapshot(Snapshot&& other) noexcept;
+        Snapshot& operator=(Snapshot&& other) noexcept;
+        ~Snapshot();
+
+        ElementView root() const noexcept;
+        size_t sizeBytes() const noexcept;
+    };
+
+    std::string toSnapshot(const JsonValue& value);
+    void writeSnapshot(const JsonValue& value, std::ostream& os);
+    void writeSnapshot(const JsonValue& value, const WriteCallback& callback);
+    std::string toSnapshot(const Tape& tape);
+    void writeSnapshot(const Tape& tape, std::ostream& os);
+    void writeSnapshot(const Tape& tape, const WriteCallback& callback);
+}
+
+#endif
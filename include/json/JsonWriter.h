@@ -0,0 +1,62 @@
+#ifndef JSONPARSER_WRITER_H
+#define JSONPARSER_WRITER_H
+
+#include "json/JsonParser.h"
+#include <memory>
+
+namespace Json {
+    // Emits json directly into a string, stream or callback without building a JsonValue tree first. Escaping and
+    // number formatting are the ones of toJsonString, so equal content produces identical output.
+    // Debug builds verify the call sequence and throw a JsonWriteException on misuse. WriteOptions::canonical applies
+    // to numbers and escaping, keys keep the order of the calls. Pretty printed containers always break lines, the
+    // writer cannot know their length in advance
+    class Writer {
+    private:
+        struct State;
+        std::unique_ptr<State> m_state;
+
+        void beforeValue();
+        void afterValue();
+        void closeContainer(char delimiter);
+        Writer& writeKey(const char* name, size_t length);
+        Writer& writeString(const char* value, size_t length);
+
+    public:
+        explicit Writer(std::string& out); // Appends to out
+        explicit Writer(std::ostream& os, size_t bufferSize = defaultWriteBufferSize);
+        explicit Writer(const WriteCallback& callback, size_t bufferSize = defaultWriteBufferSize);
+        Writer(std::string& out, const WriteOptions& options);
+        Writer(std::ostream& os, const WriteOptions& options, size_t bufferSize = defaultWriteBufferSize);
+        Writer(const WriteCallback& callback, const WriteOptions& options, size_t bufferSize = defaultWriteBufferSize);
+        ~Writer(); // Flushes whatever is still buffered
+
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        Writer& beginObject();
+        Writer& endObject();
+        Writer& beginArray();
+        Writer& endArray();
+
+        Writer& key(const char* name);
+        Writer& key(const std::string& name);
+
+        Writer& value(bool value);
+        Writer& value(int value);
+        Writer& value(double value);
+        Writer& value(const char* value);
+        Writer& value(const std::string& value);
+        Writer& value(std::nullptr_t);
+        Writer& value(const JsonValue& value); // Embeds an existing tree
+
+#ifdef JSONPARSER_HAS_STRING_VIEW
+        Writer& key(std::string_view name);
+        Writer& value(std::string_view value);
+#endif
+
+        void flush(); // Done automatically once the root value is complete
+        bool isComplete() const noexcept; // Root value written and every container closed
+    };
+}
+
+#endif
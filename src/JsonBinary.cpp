@@ -0,0 +1,627 @@
+#include "json/JsonParser.h"
+#include "JsonOutput.h"
+#include <cmath>
+#include <istream>
+#include <limits>
+
+// MessagePack and CBOR (RFC 8949) encodings of JsonValue. Encoders are visitors, so every layout is written without
+// converting it first. Decoders build plain JsonObject and JsonArray containers
+
+namespace {
+
+// Binary documents come from other processes, nesting beyond this is rejected instead of exhausting the stack
+constexpr size_t maxBinaryDepth = 1024;
+
+// Every integer up to this magnitude is exactly representable as a double
+constexpr uint64_t maxExactDouble = 1ULL << 53;
+
+template <typename Output>
+class BinaryEncoder : public Json::Detail::ValueVisitor {
+protected:
+    Output& m_out;
+
+    // Header byte followed by the low bytes of value in big endian order
+    inline void writeHeader(unsigned char header, uint64_t value, int bytes) {
+        char buffer[9];
+        buffer[0] = static_cast<char>(header);
+        for (int i = 0; i < bytes; i++) {
+            buffer[bytes - i] = static_cast<char>(value >> (i * 8));
+        }
+        m_out.write(buffer, static_cast<size_t>(bytes) + 1);
+    }
+
+    inline void writeDouble(unsigned char header, double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        writeHeader(header, bits, 8);
+    }
+
+public:
+    explicit BinaryEncoder(Output& out) noexcept : m_out(out) {}
+
+    void key(const std::string& name) override { string(name); }
+    void endObject() override {}
+    void endArray() override {}
+};
+
+template <typename Output>
+class MessagePackEncoder : public BinaryEncoder<Output> {
+private:
+    using BinaryEncoder<Output>::m_out;
+    using BinaryEncoder<Output>::writeHeader;
+
+    // Fix formats up to fixLimit, then 8 (unless there is no 8 bit form), 16 and 32 bit lengths
+    inline void writeLength(unsigned char fix, size_t fixLimit, unsigned char header8, unsigned char header16, unsigned char header32, size_t length) {
+        if (length < fixLimit) {
+            m_out.put(static_cast<char>(fix | length));
+        } else if (header8 != 0 && length <= 0xFF) {
+            writeHeader(header8, length, 1);
+        } else if (length <= 0xFFFF) {
+            writeHeader(header16, length, 2);
+        } else if (length <= 0xFFFFFFFFULL) {
+            writeHeader(header32, length, 4);
+        } else {
+            throw Json::JsonWriteException("Value too large for MessagePack");
+        }
+    }
+
+public:
+    explicit MessagePackEncoder(Output& out) noexcept : BinaryEncoder<Output>(out) {}
+
+    void null() override { m_out.put(static_cast<char>(0xC0)); }
+    void boolean(bool value) override { m_out.put(static_cast<char>(value ? 0xC3 : 0xC2)); }
+
+    void integer(int value) override {
+        if (value >= -32 && value < 128) {
+            m_out.put(static_cast<char>(value)); // Positive and negative fixint
+        } else if (value > 0) {
+            uint64_t magnitude = static_cast<uint64_t>(value);
+            if (magnitude <= 0xFF) {
+                writeHeader(0xCC, magnitude, 1);
+            } else if (magnitude <= 0xFFFF) {
+                writeHeader(0xCD, magnitude, 2);
+            } else {
+                writeHeader(0xCE, magnitude, 4);
+            }
+        } else {
+            uint64_t bits = static_cast<uint64_t>(static_cast<int64_t>(value));
+            if (value >= -128) {
+                writeHeader(0xD0, bits, 1);
+            } else if (value >= -32768) {
+                writeHeader(0xD1, bits, 2);
+            } else {
+                writeHeader(0xD2, bits, 4);
+            }
+        }
+    }
+
+    void number(double value) override { this->writeDouble(0xCB, value); }
+
+    void string(const std::string& value) override {
+        writeLength(0xA0, 32, 0xD9, 0xDA, 0xDB, value.length());
+        m_out.write(value.data(), value.length());
+    }
+
+    void beginObject(size_t size) override { writeLength(0x80, 16, 0, 0xDE, 0xDF, size); }
+    void beginArray(size_t size) override { writeLength(0x90, 16, 0, 0xDC, 0xDD, size); }
+};
+
+template <typename Output>
+class CborEncoder : public BinaryEncoder<Output> {
+private:
+    using BinaryEncoder<Output>::m_out;
+    using BinaryEncoder<Output>::writeHeader;
+
+    // Major type in the high three bits, argument inline below 24 or in the following 1, 2, 4 or 8 bytes
+    inline void writeArgument(unsigned char major, uint64_t argument) {
+        unsigned char type = static_cast<unsigned char>(major << 5);
+        if (argument < 24) {
+            m_out.put(static_cast<char>(type | argument));
+        } else if (argument <= 0xFF) {
+            writeHeader(type | 24, argument, 1);
+        } else if (argument <= 0xFFFF) {
+            writeHeader(type | 25, argument, 2);
+        } else if (argument <= 0xFFFFFFFFULL) {
+            writeHeader(type | 26, argument, 4);
+        } else {
+            writeHeader(type | 27, argument, 8);
+        }
+    }
+
+public:
+    explicit CborEncoder(Output& out) noexcept : BinaryEncoder<Output>(out) {}
+
+    void null() override { m_out.put(static_cast<char>(0xF6)); }
+    void boolean(bool value) override { m_out.put(static_cast<char>(value ? 0xF5 : 0xF4)); }
+
+    void integer(int value) override {
+        if (value >= 0) {
+            writeArgument(0, static_cast<uint64_t>(value));
+        } else {
+            writeArgument(1, static_cast<uint64_t>(-(static_cast<int64_t>(value) + 1)));
+        }
+    }
+
+    void number(double value) override { this->writeDouble(0xFB, value); }
+
+    void string(const std::string& value) override {
+        writeArgument(3, value.length());
+        m_out.write(value.data(), value.length());
+    }
+
+    void beginObject(size_t size) override { writeArgument(5, size); }
+    void beginArray(size_t size) override { writeArgument(4, size); }
+};
+
+class BufferInput {
+private:
+    const unsigned char* m_data;
+    const unsigned char* m_end;
+    const char* m_format;
+
+    inline void require(size_t length) const {
+        if (static_cast<size_t>(m_end - m_data) < length)
+            throw Json::JsonMalformedException(std::string("Unexpected end of ") + m_format + " data");
+    }
+
+public:
+    BufferInput(const void* data, size_t length, const char* format) noexcept
+        : m_data(static_cast<const unsigned char*>(data)), m_end(m_data + length), m_format(format) {}
+
+    inline bool atEnd() const noexcept { return m_data == m_end; }
+
+    inline unsigned char byte() {
+        require(1);
+        return *m_data++;
+    }
+
+    inline void read(void* destination, size_t length) {
+        require(length);
+        std::memcpy(destination, m_data, length);
+        m_data += length;
+    }
+
+    inline void readString(std::string& out, size_t length) {
+        require(length);
+        out.append(reinterpret_cast<const char*>(m_data), length);
+        m_data += length;
+    }
+
+    // Every element takes at least one byte, so larger counts are malformed and never reserved
+    inline size_t reserveHint(size_t count) const {
+        require(count);
+        return count;
+    }
+};
+
+class StreamInput {
+private:
+    std::streambuf* m_buffer;
+    const char* m_format;
+
+    [[noreturn]] void unexpectedEnd() const { throw Json::JsonMalformedException(std::string("Unexpected end of ") + m_format + " data"); }
+
+public:
+    StreamInput(std::istream& is, const char* format) : m_buffer(is.rdbuf()), m_format(format) {
+        if (!m_buffer || !is.good())
+            unexpectedEnd();
+    }
+
+    inline unsigned char byte() {
+        std::streambuf::int_type c = m_buffer->sbumpc();
+        if (c == std::streambuf::traits_type::eof())
+            unexpectedEnd();
+        return static_cast<unsigned char>(c);
+    }
+
+    inline void read(void* destination, size_t length) {
+        if (m_buffer->sgetn(static_cast<char*>(destination), static_cast<std::streamsize>(length)) != static_cast<std::streamsize>(length))
+            unexpectedEnd();
+    }
+
+    // Grows with the data actually read, a corrupt length can not allocate more than one step ahead
+    void readString(std::string& out, size_t length) {
+        const size_t step = 64 * 1024;
+        while (length > 0) {
+            size_t part = length < step ? length : step;
+            size_t offset = out.size();
+            out.resize(offset + part);
+            read(&out[offset], part);
+            length -= part;
+        }
+    }
+
+    inline size_t reserveHint(size_t count) const noexcept { return count < 4096 ? count : 4096; }
+};
+
+template <typename Input>
+class BinaryDecoder {
+protected:
+    Input& m_input;
+    const char* m_format;
+
+    [[noreturn]] void malformed(const char* message) const { throw Json::JsonMalformedException(std::string(m_format) + ": " + message); }
+
+    inline uint64_t readBigEndian(int bytes) {
+        unsigned char buffer[8];
+        m_input.read(buffer, static_cast<size_t>(bytes));
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; i++) {
+            value = (value << 8) | buffer[i];
+        }
+        return value;
+    }
+
+    inline double readFloat() {
+        uint32_t bits = static_cast<uint32_t>(readBigEndian(4));
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    inline double readDouble() {
+        uint64_t bits = readBigEndian(8);
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // JsonValue integers are 32 bit, larger ones become doubles as long as that loses nothing
+    Json::JsonValue makeInteger(uint64_t magnitude, bool negative) const {
+        uint64_t maxInt = static_cast<uint64_t>(std::numeric_limits<int>::max());
+        if (negative ? magnitude <= maxInt + 1 : magnitude <= maxInt) {
+            return Json::JsonValue(negative ? static_cast<int>(-static_cast<int64_t>(magnitude)) : static_cast<int>(magnitude));
+        }
+        if (magnitude > maxExactDouble)
+            malformed("Integer not exactly representable");
+        double value = static_cast<double>(magnitude);
+        return Json::JsonValue(negative ? -value : value);
+    }
+
+    inline void enter(size_t depth) const {
+        if (depth >= maxBinaryDepth)
+            malformed("Nesting too deep");
+    }
+
+public:
+    BinaryDecoder(Input& input, const char* format) noexcept : m_input(input), m_format(format) {}
+};
+
+template <typename Input>
+class MessagePackDecoder : public BinaryDecoder<Input> {
+private:
+    using BinaryDecoder<Input>::m_input;
+    using BinaryDecoder<Input>::malformed;
+    using BinaryDecoder<Input>::readBigEndian;
+
+    Json::JsonValue readArray(size_t size, size_t depth) {
+        this->enter(depth);
+        Json::JsonArray array;
+        array.reserve(m_input.reserveHint(size));
+        for (size_t i = 0; i < size; i++) {
+            array.push_back(decode(depth + 1));
+        }
+        return Json::JsonValue(std::move(array));
+    }
+
+    Json::JsonValue readMap(size_t size, size_t depth) {
+        this->enter(depth);
+        Json::JsonObject object;
+        object.reserve(m_input.reserveHint(size));
+        for (size_t i = 0; i < size; i++) {
+            std::string key;
+            unsigned char type = m_input.byte();
+            if (type >= 0xA0 && type <= 0xBF) {
+                m_input.readString(key, type & 0x1F);
+            } else if (type >= 0xD9 && type <= 0xDB) {
+                m_input.readString(key, readBigEndian(1 << (type - 0xD9)));
+            } else {
+                malformed("Map keys must be strings");
+            }
+            object[std::move(key)] = decode(depth + 1);
+        }
+        return Json::JsonValue(std::move(object));
+    }
+
+    Json::JsonValue readString(size_t length) {
+        std::string value;
+        m_input.readString(value, length);
+        return Json::JsonValue(std::move(value));
+    }
+
+public:
+    explicit MessagePackDecoder(Input& input) noexcept : BinaryDecoder<Input>(input, "MessagePack") {}
+
+    Json::JsonValue decode(size_t depth) {
+        unsigned char type = m_input.byte();
+        if (type <= 0x7F)
+            return Json::JsonValue(static_cast<int>(type));
+        if (type >= 0xE0)
+            return Json::JsonValue(static_cast<int>(type) - 256);
+        if (type <= 0x8F)
+            return readMap(type & 0x0F, depth);
+        if (type <= 0x9F)
+            return readArray(type & 0x0F, depth);
+        if (type <= 0xBF)
+            return readString(type & 0x1F);
+
+        switch (type) {
+            case 0xC0: return Json::JsonValue(nullptr);
+            case 0xC2: return Json::JsonValue(false);
+            case 0xC3: return Json::JsonValue(true);
+            case 0xCA: return Json::JsonValue(this->readFloat());
+            case 0xCB: return Json::JsonValue(this->readDouble());
+            case 0xCC: case 0xCD: case 0xCE: case 0xCF:
+                return this->makeInteger(readBigEndian(1 << (type - 0xCC)), false);
+            case 0xD0: case 0xD1: case 0xD2: case 0xD3: {
+                int bytes = 1 << (type - 0xD0);
+                uint64_t bits = readBigEndian(bytes);
+                int shift = 64 - bytes * 8;
+                int64_t value = static_cast<int64_t>(bits << shift) >> shift; // Sign extend
+                return value < 0 ? this->makeInteger(0 - static_cast<uint64_t>(value), true) : this->makeInteger(static_cast<uint64_t>(value), false);
+            }
+            case 0xD9: case 0xDA: case 0xDB: return readString(readBigEndian(1 << (type - 0xD9)));
+            case 0xDC: return readArray(readBigEndian(2), depth);
+            case 0xDD: return readArray(readBigEndian(4), depth);
+            case 0xDE: return readMap(readBigEndian(2), depth);
+            case 0xDF: return readMap(readBigEndian(4), depth);
+            case 0xC4: case 0xC5: case 0xC6: malformed("Binary data has no json equivalent");
+            case 0xC1: malformed("Invalid type byte");
+            default: malformed("Extension types have no json equivalent");
+        }
+    }
+};
+
+template <typename Input>
+class CborDecoder : public BinaryDecoder<Input> {
+private:
+    using BinaryDecoder<Input>::m_input;
+    using BinaryDecoder<Input>::malformed;
+    using BinaryDecoder<Input>::readBigEndian;
+
+    static constexpr unsigned char indefinite = 31;
+    static constexpr unsigned char breakByte = 0xFF;
+
+    uint64_t readArgument(unsigned char info) {
+        if (info < 24)
+            return info;
+        if (info <= 27)
+            return readBigEndian(1 << (info - 24));
+        malformed("Invalid additional information");
+    }
+
+    inline size_t readLength(unsigned char info) {
+        uint64_t length = readArgument(info);
+        if (length > std::numeric_limits<size_t>::max())
+            malformed("Length too large");
+        return static_cast<size_t>(length);
+    }
+
+    // Indefinite strings are a sequence of definite chunks of the same major type
+    void readText(unsigned char info, std::string& out) {
+        if (info != indefinite) {
+            m_input.readString(out, readLength(info));
+            return;
+        }
+        unsigned char chunk;
+        while ((chunk = m_input.byte()) != breakByte) {
+            if ((chunk >> 5) != 3 || (chunk & 0x1F) == indefinite)
+                malformed("Invalid chunk in indefinite length string");
+            m_input.readString(out, readLength(chunk & 0x1F));
+        }
+    }
+
+    // Indefinite containers end with a break byte where the next item would start
+    Json::JsonValue readArray(unsigned char info, size_t depth) {
+        this->enter(depth);
+        Json::JsonArray array;
+        if (info == indefinite) {
+            unsigned char type;
+            while ((type = m_input.byte()) != breakByte) {
+                array.push_back(decode(type, depth + 1));
+            }
+        } else {
+            size_t size = readLength(info);
+            array.reserve(m_input.reserveHint(size));
+            for (size_t i = 0; i < size; i++) {
+                array.push_back(decode(m_input.byte(), depth + 1));
+            }
+        }
+        return Json::JsonValue(std::move(array));
+    }
+
+    void readMember(unsigned char type, Json::JsonObject& object, size_t depth) {
+        while ((type >> 5) == 6) {
+            readArgument(type & 0x1F); // Tagged keys keep their text
+            type = m_input.byte();
+        }
+        if ((type >> 5) != 3)
+            malformed("Map keys must be text strings");
+        std::string key;
+        readText(type & 0x1F, key);
+        object[std::move(key)] = decode(m_input.byte(), depth + 1);
+    }
+
+    Json::JsonValue readMap(unsigned char info, size_t depth) {
+        this->enter(depth);
+        Json::JsonObject object;
+        if (info == indefinite) {
+            unsigned char type;
+            while ((type = m_input.byte()) != breakByte) {
+                readMember(type, object, depth);
+            }
+        } else {
+            size_t size = readLength(info);
+            object.reserve(m_input.reserveHint(size));
+            for (size_t i = 0; i < size; i++) {
+                readMember(m_input.byte(), object, depth);
+            }
+        }
+        return Json::JsonValue(std::move(object));
+    }
+
+    double readHalf() {
+        // RFC 8949 appendix D
+        unsigned int half = static_cast<unsigned int>(readBigEndian(2));
+        int exponent = (half >> 10) & 0x1F;
+        int mantissa = half & 0x3FF;
+        double value;
+        if (exponent == 0) {
+            value = std::ldexp(mantissa, -24);
+        } else if (exponent != 31) {
+            value = std::ldexp(mantissa + 1024, exponent - 25);
+        } else {
+            value = mantissa == 0 ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
+        }
+        return (half & 0x8000) ? -value : value;
+    }
+
+public:
+    explicit CborDecoder(Input& input) noexcept : BinaryDecoder<Input>(input, "CBOR") {}
+
+    inline Json::JsonValue decode(size_t depth) { return decode(m_input.byte(), depth); }
+
+    // type is the initial byte of the item, already read
+    Json::JsonValue decode(unsigned char type, size_t depth) {
+        unsigned char info = type & 0x1F;
+        switch (type >> 5) {
+            case 0: return this->makeInteger(readArgument(info), false);
+            case 1: {
+                uint64_t argument = readArgument(info);
+                if (argument >= maxExactDouble) // -1 - argument
+                    malformed("Integer not exactly representable");
+                return this->makeInteger(argument + 1, true);
+            }
+            case 2: malformed("Byte strings have no json equivalent");
+            case 3: {
+                std::string value;
+                readText(info, value);
+                return Json::JsonValue(std::move(value));
+            }
+            case 4: return readArray(info, depth);
+            case 5: return readMap(info, depth);
+            case 6:
+                // Tags only add semantics to the item that follows, the item itself is kept
+                readArgument(info);
+                this->enter(depth);
+                return decode(m_input.byte(), depth + 1);
+            default:
+                switch (info) {
+                    case 20: return Json::JsonValue(false);
+                    case 21: return Json::JsonValue(true);
+                    case 22: case 23: return Json::JsonValue(nullptr); // null and undefined
+                    case 25: return Json::JsonValue(readHalf());
+                    case 26: return Json::JsonValue(this->readFloat());
+                    case 27: return Json::JsonValue(this->readDouble());
+                    case indefinite: malformed("Unexpected break");
+                    default: malformed("Simple values have no json equivalent");
+                }
+        }
+    }
+};
+
+template <template <typename> class Encoder>
+void encodeToString(const Json::JsonValue& value, std::string& out) {
+    Json::Detail::StringOutput output(out);
+    Encoder<Json::Detail::StringOutput> encoder(output);
+    Json::Detail::visitValue(value, encoder);
+}
+
+template <template <typename> class Encoder>
+void streamEncoded(const Json::JsonValue& value, Json::Detail::OutputSink& sink, size_t bufferSize) {
+    char stackBuffer[4096];
+    std::vector<char> heapBuffer;
+    char* buffer = stackBuffer;
+    if (bufferSize == 0) {
+        bufferSize = 1;
+    } else if (bufferSize > sizeof(stackBuffer)) {
+        heapBuffer.resize(bufferSize);
+        buffer = heapBuffer.data();
+    }
+
+    Json::Detail::BufferedOutput output(sink, buffer, bufferSize);
+    Encoder<Json::Detail::BufferedOutput> encoder(output);
+    Json::Detail::visitValue(value, encoder);
+    output.flush();
+}
+
+template <template <typename> class Decoder>
+Json::JsonValue decodeBuffer(const void* data, size_t length, const char* format) {
+    BufferInput input(data, length, format);
+    Json::JsonValue value = Decoder<BufferInput>(input).decode(0);
+    if (!input.atEnd())
+        throw Json::JsonMalformedException(std::string("Unexpected data after ") + format + " value");
+    return value;
+}
+
+template <template <typename> class Decoder>
+Json::JsonValue decodeStream(std::istream& is, const char* format) {
+    StreamInput input(is, format);
+    return Decoder<StreamInput>(input).decode(0);
+}
+
+} // namespace
+
+std::string Json::toMessagePack(const JsonValue& value) {
+    std::string out;
+    toMessagePack(value, out);
+    return out;
+}
+
+void Json::toMessagePack(const JsonValue& value, std::string& out) {
+    encodeToString<MessagePackEncoder>(value, out);
+}
+
+void Json::writeMessagePack(const JsonValue& value, std::ostream& os, size_t bufferSize) {
+    Json::Detail::StreamSink sink(os);
+    streamEncoded<MessagePackEncoder>(value, sink, bufferSize);
+}
+
+void Json::writeMessagePack(const JsonValue& value, const WriteCallback& callback, size_t bufferSize) {
+    Json::Detail::CallbackSink sink(callback);
+    streamEncoded<MessagePackEncoder>(value, sink, bufferSize);
+}
+
+Json::JsonValue Json::fromMessagePack(const std::string& data) {
+    return fromMessagePack(data.data(), data.length());
+}
+
+Json::JsonValue Json::fromMessagePack(const void* data, size_t length) {
+    return decodeBuffer<MessagePackDecoder>(data, length, "MessagePack");
+}
+
+Json::JsonValue Json::fromMessagePack(std::istream& is) {
+    return decodeStream<MessagePackDecoder>(is, "MessagePack");
+}
+
+std::string Json::toCbor(const JsonValue& value) {
+    std::string out;
+    toCbor(value, out);
+    return out;
+}
+
+void Json::toCbor(const JsonValue& value, std::string& out) {
+    encodeToString<CborEncoder>(value, out);
+}
+
+void Json::writeCbor(const JsonValue& value, std::ostream& os, size_t bufferSize) {
+    Json::Detail::StreamSink sink(os);
+    streamEncoded<CborEncoder>(value, sink, bufferSize);
+}
+
+void Json::writeCbor(const JsonValue& value, const WriteCallback& callback, size_t bufferSize) {
+    Json::Detail::CallbackSink sink(callback);
+    streamEncoded<CborEncoder>(value, sink, bufferSize);
+}
+
+Json::JsonValue Json::fromCbor(const std::string& data) {
+    return fromCbor(data.data(), data.length());
+}
+
+Json::JsonValue Json::fromCbor(const void* data, size_t length) {
+    return decodeBuffer<CborDecoder>(data, length, "CBOR");
+}
+
+Json::JsonValue Json::fromCbor(std::istream& is) {
+    return decodeStream<CborDecoder>(is, "CBOR");
+}
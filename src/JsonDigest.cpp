@@ -0,0 +1,257 @@
+#include "json/JsonParser.h"
+#include "JsonOutput.h"
+
+// Hashes of the canonical form. The serializer streams through a small buffer into a sink that feeds the hash, so
+// the canonical string is never built
+
+namespace {
+
+inline uint32_t rotateRight32(uint32_t value, int bits) noexcept {
+    return (value >> bits) | (value << (32 - bits));
+}
+
+inline uint64_t rotateLeft64(uint64_t value, int bits) noexcept {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline uint32_t readBigEndian32(const unsigned char* data) noexcept {
+    return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) | (static_cast<uint32_t>(data[2]) << 8) |
+           static_cast<uint32_t>(data[3]);
+}
+
+inline uint64_t readLittleEndian64(const unsigned char* data) noexcept {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--) {
+        value = (value << 8) | data[i];
+    }
+    return value;
+}
+
+inline uint32_t readLittleEndian32(const unsigned char* data) noexcept {
+    return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) | (static_cast<uint32_t>(data[2]) << 16) |
+           (static_cast<uint32_t>(data[3]) << 24);
+}
+
+// FIPS 180-4
+class Sha256Sink : public Json::Detail::OutputSink {
+private:
+    uint32_t m_state[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+    unsigned char m_block[64];
+    size_t m_blockUsed = 0;
+    uint64_t m_totalBytes = 0;
+
+    void compress(const unsigned char* block) noexcept {
+        static const uint32_t roundConstants[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+        };
+
+        uint32_t schedule[64];
+        for (int i = 0; i < 16; i++) {
+            schedule[i] = readBigEndian32(block + i * 4);
+        }
+        for (int i = 16; i < 64; i++) {
+            uint32_t s0 = rotateRight32(schedule[i - 15], 7) ^ rotateRight32(schedule[i - 15], 18) ^ (schedule[i - 15] >> 3);
+            uint32_t s1 = rotateRight32(schedule[i - 2], 17) ^ rotateRight32(schedule[i - 2], 19) ^ (schedule[i - 2] >> 10);
+            schedule[i] = schedule[i - 16] + s0 + schedule[i - 7] + s1;
+        }
+
+        uint32_t a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3];
+        uint32_t e = m_state[4], f = m_state[5], g = m_state[6], h = m_state[7];
+        for (int i = 0; i < 64; i++) {
+            uint32_t s1 = rotateRight32(e, 6) ^ rotateRight32(e, 11) ^ rotateRight32(e, 25);
+            uint32_t choice = (e & f) ^ (~e & g);
+            uint32_t temp1 = h + s1 + choice + roundConstants[i] + schedule[i];
+            uint32_t s0 = rotateRight32(a, 2) ^ rotateRight32(a, 13) ^ rotateRight32(a, 22);
+            uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+            uint32_t temp2 = s0 + majority;
+            h = g;
+            g = f;
+            f = e;
+            e = d + temp1;
+            d = c;
+            c = b;
+            b = a;
+            a = temp1 + temp2;
+        }
+        m_state[0] += a; m_state[1] += b; m_state[2] += c; m_state[3] += d;
+        m_state[4] += e; m_state[5] += f; m_state[6] += g; m_state[7] += h;
+    }
+
+public:
+    void write(const char* data, size_t length) override {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+        m_totalBytes += length;
+        if (m_blockUsed > 0) {
+            size_t take = length < 64 - m_blockUsed ? length : 64 - m_blockUsed;
+            std::memcpy(m_block + m_blockUsed, bytes, take);
+            m_blockUsed += take;
+            bytes += take;
+            length -= take;
+            if (m_blockUsed < 64) {
+                return;
+            }
+            compress(m_block);
+            m_blockUsed = 0;
+        }
+        for (; length >= 64; bytes += 64, length -= 64) {
+            compress(bytes);
+        }
+        std::memcpy(m_block, bytes, length);
+        m_blockUsed = length;
+    }
+    using OutputSink::write;
+
+    Json::Sha256Digest finish() noexcept {
+        uint64_t bitLength = m_totalBytes * 8;
+        m_block[m_blockUsed++] = 0x80;
+        if (m_blockUsed > 56) {
+            std::memset(m_block + m_blockUsed, 0, 64 - m_blockUsed);
+            compress(m_block);
+            m_blockUsed = 0;
+        }
+        std::memset(m_block + m_blockUsed, 0, 56 - m_blockUsed);
+        for (int i = 0; i < 8; i++) {
+            m_block[56 + i] = static_cast<unsigned char>(bitLength >> (56 - i * 8));
+        }
+        compress(m_block);
+
+        Json::Sha256Digest digest;
+        for (int i = 0; i < 8; i++) {
+            for (int j = 0; j < 4; j++) {
+                digest[i * 4 + j] = static_cast<uint8_t>(m_state[i] >> (24 - j * 8));
+            }
+        }
+        return digest;
+    }
+};
+
+// XXH64 as specified by the xxHash project
+class XxHash64Sink : public Json::Detail::OutputSink {
+private:
+    static constexpr uint64_t prime1 = 0x9E3779B185EBCA87ULL;
+    static constexpr uint64_t prime2 = 0xC2B2AE3D27D4EB4FULL;
+    static constexpr uint64_t prime3 = 0x165667B19E3779F9ULL;
+    static constexpr uint64_t prime4 = 0x85EBCA77C2B2AE63ULL;
+    static constexpr uint64_t prime5 = 0x27D4EB2F165667C5ULL;
+
+    uint64_t m_seed;
+    uint64_t m_lanes[4];
+    unsigned char m_stripe[32];
+    size_t m_stripeUsed = 0;
+    uint64_t m_totalBytes = 0;
+
+    static inline uint64_t round(uint64_t lane, uint64_t input) noexcept {
+        lane += input * prime2;
+        lane = rotateLeft64(lane, 31);
+        return lane * prime1;
+    }
+
+    static inline uint64_t mergeRound(uint64_t hash, uint64_t lane) noexcept {
+        hash ^= round(0, lane);
+        return hash * prime1 + prime4;
+    }
+
+    inline void consumeStripe(const unsigned char* stripe) noexcept {
+        for (int i = 0; i < 4; i++) {
+            m_lanes[i] = round(m_lanes[i], readLittleEndian64(stripe + i * 8));
+        }
+    }
+
+public:
+    explicit XxHash64Sink(uint64_t seed) noexcept : m_seed(seed) {
+        m_lanes[0] = seed + prime1 + prime2;
+        m_lanes[1] = seed + prime2;
+        m_lanes[2] = seed;
+        m_lanes[3] = seed - prime1;
+    }
+
+    void write(const char* data, size_t length) override {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+        m_totalBytes += length;
+        if (m_stripeUsed > 0) {
+            size_t take = length < 32 - m_stripeUsed ? length : 32 - m_stripeUsed;
+            std::memcpy(m_stripe + m_stripeUsed, bytes, take);
+            m_stripeUsed += take;
+            bytes += take;
+            length -= take;
+            if (m_stripeUsed < 32) {
+                return;
+            }
+            consumeStripe(m_stripe);
+            m_stripeUsed = 0;
+        }
+        for (; length >= 32; bytes += 32, length -= 32) {
+            consumeStripe(bytes);
+        }
+        std::memcpy(m_stripe, bytes, length);
+        m_stripeUsed = length;
+    }
+    using OutputSink::write;
+
+    uint64_t finish() const noexcept {
+        uint64_t hash;
+        if (m_totalBytes >= 32) {
+            hash = rotateLeft64(m_lanes[0], 1) + rotateLeft64(m_lanes[1], 7) + rotateLeft64(m_lanes[2], 12) + rotateLeft64(m_lanes[3], 18);
+            for (int i = 0; i < 4; i++) {
+                hash = mergeRound(hash, m_lanes[i]);
+            }
+        } else {
+            hash = m_seed + prime5;
+        }
+        hash += m_totalBytes;
+
+        const unsigned char* tail = m_stripe;
+        size_t remaining = m_stripeUsed;
+        for (; remaining >= 8; tail += 8, remaining -= 8) {
+            hash ^= round(0, readLittleEndian64(tail));
+            hash = rotateLeft64(hash, 27) * prime1 + prime4;
+        }
+        if (remaining >= 4) {
+            hash ^= static_cast<uint64_t>(readLittleEndian32(tail)) * prime1;
+            hash = rotateLeft64(hash, 23) * prime2 + prime3;
+            tail += 4;
+            remaining -= 4;
+        }
+        for (; remaining > 0; tail++, remaining--) {
+            hash ^= (*tail) * prime5;
+            hash = rotateLeft64(hash, 11) * prime1;
+        }
+
+        hash ^= hash >> 33;
+        hash *= prime2;
+        hash ^= hash >> 29;
+        hash *= prime3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+};
+
+} // namespace
+
+static void streamCanonical(const Json::JsonValue& value, Json::Detail::OutputSink& sink) {
+    char buffer[4096];
+    Json::Detail::BufferedOutput output(sink, buffer, sizeof(buffer));
+    Json::WriteOptions options;
+    options.canonical = true;
+    Json::Detail::serializeValue(value, output, options);
+    output.flush();
+}
+
+Json::Sha256Digest Json::canonicalSha256(const JsonValue& value) {
+    Sha256Sink sink;
+    streamCanonical(value, sink);
+    return sink.finish();
+}
+
+uint64_t Json::canonicalXxHash64(const JsonValue& value, uint64_t seed) {
+    XxHash64Sink sink(seed);
+    streamCanonical(value, sink);
+    return sink.finish();
+}
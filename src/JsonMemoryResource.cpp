@@ -0,0 +1,74 @@
+#include "json/JsonParser.h"
+
+#ifdef JSONPARSER_MEMORY_RESOURCE
+
+#include <cstddef>
+
+// Payloads start with a header naming their resource, keeps the payload itself at the strictest fundamental alignment
+static constexpr size_t payloadHeaderSize = alignof(std::max_align_t);
+static_assert(payloadHeaderSize >= sizeof(Json::MemoryResource*), "Payload header too small for the resource pointer");
+
+namespace {
+
+class DefaultMemoryResource : public Json::MemoryResource {
+public:
+    void* allocate(size_t size, size_t) override {
+#ifdef JSONPARSER_POOL_ALLOCATOR
+        return Json::Detail::poolAllocate(size);
+#else
+        return ::operator new(size);
+#endif
+    }
+
+    void deallocate(void* memory, size_t size, size_t) noexcept override {
+#ifdef JSONPARSER_POOL_ALLOCATOR
+        Json::Detail::poolDeallocate(memory, size);
+#else
+        (void)size;
+        ::operator delete(memory);
+#endif
+    }
+};
+
+} // namespace
+
+// Null means the default resource, keeps the thread local trivially initialized
+static thread_local Json::MemoryResource* threadResource = nullptr;
+
+Json::MemoryResource* Json::defaultMemoryResource() noexcept {
+    // Never destroyed, payloads of static JsonValues may still be released during shutdown
+    static DefaultMemoryResource* resource = new DefaultMemoryResource();
+    return resource;
+}
+
+Json::MemoryResource* Json::currentMemoryResource() noexcept {
+    return threadResource ? threadResource : defaultMemoryResource();
+}
+
+Json::MemoryResourceScope::MemoryResourceScope(MemoryResource* resource) noexcept : m_previous(threadResource) {
+    threadResource = resource;
+}
+
+Json::MemoryResourceScope::~MemoryResourceScope() {
+    threadResource = m_previous;
+}
+
+void* Json::Detail::allocatePayload(size_t size) {
+    MemoryResource* resource = currentMemoryResource();
+    char* block = static_cast<char*>(resource->allocate(size + payloadHeaderSize, alignof(std::max_align_t)));
+    *reinterpret_cast<MemoryResource**>(block) = resource;
+    return block + payloadHeaderSize;
+}
+
+void Json::Detail::deallocatePayload(void* payload, size_t size) noexcept {
+    char* block = static_cast<char*>(payload) - payloadHeaderSize;
+    MemoryResource* resource = *reinterpret_cast<MemoryResource**>(block);
+    resource->deallocate(block, size + payloadHeaderSize, alignof(std::max_align_t));
+}
+
+Json::MemoryResource* Json::Detail::payloadResource(const void* payload) noexcept {
+    const char* block = static_cast<const char*>(payload) - payloadHeaderSize;
+    return *reinterpret_cast<MemoryResource* const*>(block);
+}
+
+#endif
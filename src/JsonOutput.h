@@ -0,0 +1,631 @@
+#ifndef JSONPARSER_OUTPUT_H
+#define JSONPARSER_OUTPUT_H
+
+// Internal to the library: json syntax, escaping, number formatting and the output targets of the serializer
+
+#include "json/JsonParser.h"
+#include <cfloat>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#define JSON_NULL_LITERAL "null"
+#define JSON_BOOLTRUE_LITERAL "true"
+#define JSON_BOOLFALSE_LITERAL "false"
+#define JSONSTRING_DELIMITER '"'
+#define JSONKEYVALUE_SEPERATOR ':'
+#define JSONVALUE_DELIMITER ','
+#define JSONOBJECT_STARTDELIMITER '{'
+#define JSONOBJECT_ENDDELIMITER '}'
+#define JSONARRAY_STARTDELIMITER '['
+#define JSONARRAY_ENDDELIMITER ']'
+
+namespace Json {
+    namespace Detail {
+        inline const char* escapeSequence(char c) noexcept {
+            switch (c) {
+                case '\"': return "\\\"";
+                case '\\': return "\\\\";
+                case '/':  return "\\/";
+                case '\b': return "\\b";
+                case '\f': return "\\f";
+                case '\n': return "\\n";
+                case '\r': return "\\r";
+                case '\t': return "\\t";
+                default: return nullptr;
+            }
+        }
+
+        // Optional escapes on top of quotes, backslashes and control characters
+        struct Escaping {
+            bool slash;
+            bool nonAscii;
+        };
+
+        inline Escaping escapingOf(const WriteOptions& options) noexcept {
+            // The canonical form leaves '/' and non ASCII characters as they are
+            Escaping escaping = { !options.canonical, options.escapeNonAscii && !options.canonical };
+            return escaping;
+        }
+
+        inline bool needsEscape(unsigned char c, Escaping escaping) noexcept {
+            return c < 0x20 || c == '\"' || c == '\\' || (escaping.slash && c == '/') || (escaping.nonAscii && c >= 0x80);
+        }
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        inline unsigned int lowestSetBit(unsigned int mask) noexcept {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return static_cast<unsigned int>(index);
+#else
+            return static_cast<unsigned int>(__builtin_ctz(mask));
+#endif
+        }
+#endif
+
+        // Index of the first byte at or after from that needs escaping, length if the rest is clean
+        inline size_t findEscape(const char* data, size_t length, size_t from, Escaping escaping) noexcept {
+            size_t i = from;
+#if defined(__AVX2__)
+            const __m256i quotes32 = _mm256_set1_epi8('\"');
+            const __m256i backslashes32 = _mm256_set1_epi8('\\');
+            const __m256i slashes32 = _mm256_set1_epi8(escaping.slash ? '/' : '\"'); // Repeats the quote when slashes stay
+            const __m256i controlMax32 = _mm256_set1_epi8(0x1F);
+            const __m256i space32 = _mm256_set1_epi8(0x20);
+            for (; i + 32 <= length; i += 32) {
+                __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                __m256i special = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, quotes32), _mm256_cmpeq_epi8(chunk, backslashes32)),
+                                                  _mm256_cmpeq_epi8(chunk, slashes32));
+                // Signed compare also catches every byte above 0x7F, the unsigned form only control characters
+                __m256i control = escaping.nonAscii ? _mm256_cmpgt_epi8(space32, chunk)
+                                                 : _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, controlMax32), controlMax32);
+                unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_or_si256(special, control)));
+                if (mask != 0)
+                    return i + lowestSetBit(mask);
+            }
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+            const __m128i quotes = _mm_set1_epi8('\"');
+            const __m128i backslashes = _mm_set1_epi8('\\');
+            const __m128i slashes = _mm_set1_epi8(escaping.slash ? '/' : '\"');
+            const __m128i controlMax = _mm_set1_epi8(0x1F);
+            const __m128i space = _mm_set1_epi8(0x20);
+            for (; i + 16 <= length; i += 16) {
+                __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quotes), _mm_cmpeq_epi8(chunk, backslashes)),
+                                               _mm_cmpeq_epi8(chunk, slashes));
+                __m128i control = escaping.nonAscii ? _mm_cmplt_epi8(chunk, space)
+                                                 : _mm_cmpeq_epi8(_mm_max_epu8(chunk, controlMax), controlMax);
+                unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_or_si128(special, control)));
+                if (mask != 0)
+                    return i + lowestSetBit(mask);
+            }
+#else
+            // Eight bytes at a time, a hit only tells that the word has to be scanned byte by byte
+            const uint64_t ones = 0x0101010101010101ULL;
+            const uint64_t highBits = 0x8080808080808080ULL;
+            for (; i + 8 <= length; i += 8) {
+                uint64_t word;
+                std::memcpy(&word, data + i, sizeof(word));
+                uint64_t quote = word ^ (ones * '\"');
+                uint64_t backslash = word ^ (ones * '\\');
+                uint64_t slash = word ^ (ones * (escaping.slash ? '/' : '\"'));
+                uint64_t hits = ((quote - ones) & ~quote) | ((backslash - ones) & ~backslash) | ((slash - ones) & ~slash)
+                                | ((word - ones * 0x20) & ~word);
+                if (escaping.nonAscii)
+                    hits |= word;
+                if ((hits & highBits) != 0)
+                    break;
+            }
+#endif
+            for (; i < length; i++) {
+                if (needsEscape(static_cast<unsigned char>(data[i]), escaping))
+                    return i;
+            }
+            return length;
+        }
+
+        // Decodes the UTF-8 sequence at data, returns the consumed bytes. Invalid input consumes one byte as U+FFFD
+        inline size_t decodeUtf8(const char* data, size_t length, uint32_t& codePoint) noexcept {
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+            size_t count;
+            uint32_t minimum;
+            if (bytes[0] >= 0xC2 && bytes[0] <= 0xDF) {
+                count = 2; minimum = 0x80; codePoint = bytes[0] & 0x1F;
+            } else if (bytes[0] >= 0xE0 && bytes[0] <= 0xEF) {
+                count = 3; minimum = 0x800; codePoint = bytes[0] & 0x0F;
+            } else if (bytes[0] >= 0xF0 && bytes[0] <= 0xF4) {
+                count = 4; minimum = 0x10000; codePoint = bytes[0] & 0x07;
+            } else {
+                codePoint = 0xFFFD;
+                return 1;
+            }
+            if (count > length) {
+                codePoint = 0xFFFD;
+                return 1;
+            }
+            for (size_t i = 1; i < count; i++) {
+                if ((bytes[i] & 0xC0) != 0x80) {
+                    codePoint = 0xFFFD;
+                    return 1;
+                }
+                codePoint = (codePoint << 6) | (bytes[i] & 0x3F);
+            }
+            if (codePoint < minimum || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF)) {
+                codePoint = 0xFFFD;
+                return 1;
+            }
+            return count;
+        }
+
+        inline size_t encodeUtf8(uint32_t codePoint, char* buffer) noexcept {
+            if (codePoint < 0x80) {
+                buffer[0] = static_cast<char>(codePoint);
+                return 1;
+            }
+            if (codePoint < 0x800) {
+                buffer[0] = static_cast<char>(0xC0 | (codePoint >> 6));
+                buffer[1] = static_cast<char>(0x80 | (codePoint & 0x3F));
+                return 2;
+            }
+            if (codePoint < 0x10000) {
+                buffer[0] = static_cast<char>(0xE0 | (codePoint >> 12));
+                buffer[1] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                buffer[2] = static_cast<char>(0x80 | (codePoint & 0x3F));
+                return 3;
+            }
+            buffer[0] = static_cast<char>(0xF0 | (codePoint >> 18));
+            buffer[1] = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            buffer[2] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            buffer[3] = static_cast<char>(0x80 | (codePoint & 0x3F));
+            return 4;
+        }
+
+        inline size_t escapedLength(const char* data, size_t length, Escaping escaping) noexcept {
+            size_t result = length;
+            size_t i = findEscape(data, length, 0, escaping);
+            while (i < length) {
+                unsigned char c = static_cast<unsigned char>(data[i]);
+                if (c < 0x80) {
+                    result += escapeSequence(static_cast<char>(c)) ? 1 : 5; // \x or \u00XX
+                    i++;
+                } else {
+                    uint32_t codePoint;
+                    size_t consumed = decodeUtf8(data + i, length - i, codePoint);
+                    result += (codePoint >= 0x10000 ? 12 : 6) - consumed; // Surrogate pair or single \uXXXX
+                    i += consumed;
+                }
+                i = findEscape(data, length, i, escaping);
+            }
+            return result;
+        }
+
+        template <typename Output>
+        inline void appendUnicodeEscape(Output& out, uint32_t unit) {
+            static const char hexDigits[] = "0123456789abcdef";
+            char buffer[6] = { '\\', 'u', hexDigits[(unit >> 12) & 0xF], hexDigits[(unit >> 8) & 0xF], hexDigits[(unit >> 4) & 0xF], hexDigits[unit & 0xF] };
+            out.write(buffer, sizeof(buffer));
+        }
+
+        // Writes the escaped form of the character at data[i], returns the consumed input bytes
+        template <typename Output>
+        size_t appendEscapedCharacter(Output& out, const char* data, size_t length, size_t i) {
+            unsigned char c = static_cast<unsigned char>(data[i]);
+            if (c < 0x80) {
+                const char* escaped = escapeSequence(static_cast<char>(c));
+                if (escaped) {
+                    out.write(escaped, 2);
+                } else {
+                    appendUnicodeEscape(out, c);
+                }
+                return 1;
+            }
+            uint32_t codePoint;
+            size_t consumed = decodeUtf8(data + i, length - i, codePoint);
+            if (codePoint >= 0x10000) {
+                codePoint -= 0x10000;
+                appendUnicodeEscape(out, 0xD800 + (codePoint >> 10));
+                appendUnicodeEscape(out, 0xDC00 + (codePoint & 0x3FF));
+            } else {
+                appendUnicodeEscape(out, codePoint);
+            }
+            return consumed;
+        }
+
+        inline size_t stringLength(const std::string& value, Escaping escaping) noexcept {
+            return escapedLength(value.data(), value.length(), escaping) + 2;
+        }
+
+        inline size_t formatInt(int value, char* buffer) noexcept {
+            // Writes backwards from the end of a 12 character buffer, returns the offset of the first digit
+            unsigned int magnitude = value < 0 ? 0u - static_cast<unsigned int>(value) : static_cast<unsigned int>(value);
+            size_t pos = 12;
+            do {
+                buffer[--pos] = static_cast<char>('0' + magnitude % 10);
+                magnitude /= 10;
+            } while (magnitude != 0);
+            if (value < 0)
+                buffer[--pos] = '-';
+            return pos;
+        }
+
+        inline size_t formatDouble(double value, char* buffer, size_t bufferSize) noexcept {
+            // %g matches the default formatting of ostream, shortest of fixed and scientific without trailing zeros
+            int written = std::snprintf(buffer, bufferSize, "%g", value);
+            return written > 0 ? static_cast<size_t>(written) : 0;
+        }
+
+        // ECMAScript Number::toString as RFC 8785 requires: the shortest digits that round trip, written in fixed
+        // notation for decimal exponents from -6 to 20. Needs a buffer of 32 characters
+        inline size_t formatCanonicalDouble(double value, char* buffer) {
+            if (value != value || value > DBL_MAX || value < -DBL_MAX) {
+                throw JsonWriteException("Canonical json cannot represent NaN or infinite numbers");
+            }
+            if (value == 0) {
+                buffer[0] = '0'; // Negative zero as well
+                return 1;
+            }
+
+            // Every double round trips with 17 digits, for normal numbers the 15 digit form with trailing zeros removed
+            // is always the shortest. Subnormals have less precision and search upwards from one digit
+            char scientific[32];
+            int precision = (value >= DBL_MIN || value <= -DBL_MIN) ? 15 : 1;
+            std::snprintf(scientific, sizeof(scientific), "%.*e", precision - 1, value);
+            while (precision < 17 && std::strtod(scientific, nullptr) != value) {
+                precision++;
+                std::snprintf(scientific, sizeof(scientific), "%.*e", precision - 1, value);
+            }
+
+            const char* p = scientific;
+            bool negative = *p == '-';
+            char digits[17];
+            int digitCount = 0;
+            for (; *p != 'e'; p++) {
+                if (*p >= '0' && *p <= '9')
+                    digits[digitCount++] = *p;
+            }
+            while (digitCount > 1 && digits[digitCount - 1] == '0') {
+                digitCount--;
+            }
+            int exponent = std::atoi(p + 1) + 1; // Value is 0.digits * 10^exponent
+
+            size_t pos = 0;
+            if (negative)
+                buffer[pos++] = '-';
+            if (digitCount <= exponent && exponent <= 21) {
+                for (int i = 0; i < exponent; i++) {
+                    buffer[pos++] = i < digitCount ? digits[i] : '0';
+                }
+            } else if (0 < exponent && exponent <= 21) {
+                for (int i = 0; i < digitCount; i++) {
+                    if (i == exponent)
+                        buffer[pos++] = '.';
+                    buffer[pos++] = digits[i];
+                }
+            } else if (-6 < exponent && exponent <= 0) {
+                buffer[pos++] = '0';
+                buffer[pos++] = '.';
+                for (int i = exponent; i < 0; i++) {
+                    buffer[pos++] = '0';
+                }
+                std::memcpy(buffer + pos, digits, static_cast<size_t>(digitCount));
+                pos += static_cast<size_t>(digitCount);
+            } else {
+                buffer[pos++] = digits[0];
+                if (digitCount > 1) {
+                    buffer[pos++] = '.';
+                    std::memcpy(buffer + pos, digits + 1, static_cast<size_t>(digitCount - 1));
+                    pos += static_cast<size_t>(digitCount - 1);
+                }
+                buffer[pos++] = 'e';
+                buffer[pos++] = exponent - 1 < 0 ? '-' : '+';
+                pos += static_cast<size_t>(std::snprintf(buffer + pos, 8, "%d", exponent - 1 < 0 ? 1 - exponent : exponent - 1));
+            }
+            return pos;
+        }
+
+        // Order of RFC 8785 object keys: UTF-16 code units. Equals the UTF-8 byte order except that characters beyond
+        // U+FFFF (surrogate pairs in UTF-16) sort before U+E000 to U+FFFF
+        inline bool utf16Less(const std::string& a, const std::string& b) noexcept {
+            size_t length = a.length() < b.length() ? a.length() : b.length();
+            for (size_t i = 0; i < length; i++) {
+                unsigned char x = static_cast<unsigned char>(a[i]);
+                unsigned char y = static_cast<unsigned char>(b[i]);
+                if (x != y) {
+                    // Lead bytes 0xEE and 0xEF start U+E000 to U+FFFF, 0xF0 and above start surrogate pairs
+                    bool xHigh = x >= 0xEE && x <= 0xEF;
+                    bool yHigh = y >= 0xEE && y <= 0xEF;
+                    if (xHigh && y >= 0xF0)
+                        return false;
+                    if (yHigh && x >= 0xF0)
+                        return true;
+                    return x < y;
+                }
+            }
+            return a.length() < b.length();
+        }
+
+        inline size_t intLength(int value) noexcept {
+            char buffer[12];
+            return 12 - formatInt(value, buffer);
+        }
+
+        inline size_t doubleLength(double value, bool canonical) {
+            char buffer[32];
+            return canonical ? formatCanonicalDouble(value, buffer) : formatDouble(value, buffer, sizeof(buffer));
+        }
+
+        // Outputs provide put(char) and write(const char*, size_t)
+        template <typename Output>
+        void appendEscaped(Output& out, const char* data, size_t length, Escaping escaping) {
+            // Clean runs between two escapes are copied at once
+            size_t runStart = 0;
+            size_t i = findEscape(data, length, 0, escaping);
+            while (i < length) {
+                out.write(data + runStart, i - runStart);
+                i += appendEscapedCharacter(out, data, length, i);
+                runStart = i;
+                i = findEscape(data, length, i, escaping);
+            }
+            out.write(data + runStart, length - runStart);
+        }
+
+        template <typename Output>
+        inline void appendInt(Output& out, int value) {
+            char buffer[12];
+            size_t pos = formatInt(value, buffer);
+            out.write(buffer + pos, 12 - pos);
+        }
+
+        template <typename Output>
+        inline void appendDouble(Output& out, double value, bool canonical) {
+            char buffer[32];
+            out.write(buffer, canonical ? formatCanonicalDouble(value, buffer) : formatDouble(value, buffer, sizeof(buffer)));
+        }
+
+        template <typename Output>
+        inline void appendString(Output& out, const std::string& value, Escaping escaping) {
+            out.put(JSONSTRING_DELIMITER);
+            appendEscaped(out, value.data(), value.length(), escaping);
+            out.put(JSONSTRING_DELIMITER);
+        }
+
+        inline bool isPretty(const WriteOptions& options) noexcept {
+            // The canonical form never contains whitespace
+            return !options.canonical && (options.indent > 0 || options.indentWithTabs);
+        }
+
+        inline bool hasSpaceAfterColon(const WriteOptions& options) noexcept {
+            return !options.canonical && options.spaceAfterColon;
+        }
+
+        template <typename Output>
+        void appendLineBreak(Output& out, const WriteOptions& options, size_t depth) {
+            static const char spaces[] = "                                ";
+            static const char tabs[] = "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t";
+            out.write(options.newline, std::strlen(options.newline));
+            const char* fill = options.indentWithTabs ? tabs : spaces;
+            size_t fillLength = options.indentWithTabs ? sizeof(tabs) - 1 : sizeof(spaces) - 1;
+            size_t count = options.indentWithTabs ? depth : depth * options.indent;
+            while (count > 0) {
+                size_t chunk = count < fillLength ? count : fillLength;
+                out.write(fill, chunk);
+                count -= chunk;
+            }
+        }
+
+        // Comma and whitespace in front of an element, multiline containers put every element on its own line
+        template <typename Output>
+        inline void appendElementStart(Output& out, const WriteOptions& options, size_t depth, bool multiline, bool first) {
+            if (!first) {
+                out.put(JSONVALUE_DELIMITER);
+                if (!multiline && isPretty(options))
+                    out.put(' ');
+            }
+            if (multiline)
+                appendLineBreak(out, options, depth + 1);
+        }
+
+        template <typename Output>
+        inline void appendContainerEnd(Output& out, const WriteOptions& options, size_t depth, bool multiline, char delimiter) {
+            if (multiline)
+                appendLineBreak(out, options, depth);
+            out.put(delimiter);
+        }
+
+        template <typename Output>
+        inline void appendKeySeparator(Output& out, const WriteOptions& options) {
+            out.put(JSONKEYVALUE_SEPERATOR);
+            if (hasSpaceAfterColon(options))
+                out.put(' ');
+        }
+
+        class StringOutput {
+        private:
+            std::string& m_string;
+
+        public:
+            explicit StringOutput(std::string& string) noexcept : m_string(string) {}
+
+            inline void put(char c) { m_string += c; }
+            inline void write(const char* data, size_t length) { m_string.append(data, length); }
+
+            void writeChunks(const std::string* chunks, size_t count) {
+                size_t total = 0;
+                for (size_t i = 0; i < count; i++) {
+                    total += chunks[i].size();
+                }
+                m_string.reserve(m_string.size() + total);
+                for (size_t i = 0; i < count; i++) {
+                    m_string += chunks[i];
+                }
+            }
+        };
+
+        // Only measures, used for the exact size of formatted output
+        class CountingOutput {
+        public:
+            size_t count = 0;
+
+            inline void put(char) noexcept { count++; }
+            inline void write(const char*, size_t length) noexcept { count += length; }
+
+            void writeChunks(const std::string* chunks, size_t chunkCount) noexcept {
+                for (size_t i = 0; i < chunkCount; i++) {
+                    count += chunks[i].size();
+                }
+            }
+        };
+
+        // Destination of a streamed document
+        class OutputSink {
+        public:
+            virtual ~OutputSink() = default;
+
+            virtual void write(const char* data, size_t length) = 0;
+
+            // Buffered bytes followed by a large chunk that bypasses the buffer
+            virtual void write(const char* first, size_t firstLength, const char* second, size_t secondLength) {
+                if (firstLength > 0)
+                    write(first, firstLength);
+                write(second, secondLength);
+            }
+
+            // Consecutive chunks of a parallel serialization, sinks that support it write them with one call
+            virtual void writeChunks(const std::string* chunks, size_t count) {
+                for (size_t i = 0; i < count; i++) {
+                    write(chunks[i].data(), chunks[i].size());
+                }
+            }
+        };
+
+        class StringSink : public OutputSink {
+        private:
+            std::string& m_string;
+
+        public:
+            explicit StringSink(std::string& string) noexcept : m_string(string) {}
+
+            void write(const char* data, size_t length) override { m_string.append(data, length); }
+            using OutputSink::write;
+        };
+
+        class StreamSink : public OutputSink {
+        private:
+            std::ostream& m_os;
+
+        public:
+            explicit StreamSink(std::ostream& os) noexcept : m_os(os) {}
+
+            void write(const char* data, size_t length) override {
+                if (!m_os.write(data, static_cast<std::streamsize>(length)))
+                    throw JsonWriteException("Failed to write json to stream");
+            }
+            using OutputSink::write;
+        };
+
+        class CallbackSink : public OutputSink {
+        private:
+            const WriteCallback& m_callback;
+
+        public:
+            explicit CallbackSink(const WriteCallback& callback) noexcept : m_callback(callback) {}
+
+            void write(const char* data, size_t length) override { m_callback(data, length); }
+            using OutputSink::write;
+        };
+
+        // Collects output in a fixed buffer and hands it to the sink whenever it is full
+        class BufferedOutput {
+        private:
+            OutputSink& m_sink;
+            char* m_buffer;
+            size_t m_capacity;
+            size_t m_used = 0;
+
+        public:
+            BufferedOutput(OutputSink& sink, char* buffer, size_t capacity) noexcept : m_sink(sink), m_buffer(buffer), m_capacity(capacity) {}
+
+            inline void put(char c) {
+                if (m_used == m_capacity)
+                    flush();
+                m_buffer[m_used++] = c;
+            }
+
+            inline void write(const char* data, size_t length) {
+                if (length <= m_capacity - m_used) {
+                    std::memcpy(m_buffer + m_used, data, length);
+                    m_used += length;
+                    return;
+                }
+                if (length >= m_capacity / 2) {
+                    // Too large to be worth copying, goes out together with the buffered bytes
+                    m_sink.write(m_buffer, m_used, data, length);
+                    m_used = 0;
+                    return;
+                }
+                flush();
+                std::memcpy(m_buffer, data, length);
+                m_used = length;
+            }
+
+            void flush() {
+                if (m_used > 0) {
+                    m_sink.write(m_buffer, m_used);
+                    m_used = 0;
+                }
+            }
+
+            void writeChunks(const std::string* chunks, size_t count) {
+                flush();
+                m_sink.writeChunks(chunks, count);
+            }
+        };
+
+        // Parallel serialization, implemented with the worker pool
+        unsigned int serializationThreads(const WriteOptions& options) noexcept;
+        bool insideParallelSerialization() noexcept; // Nested containers of a chunk are written sequentially
+        void runParallel(size_t taskCount, unsigned int threads, const std::function<void(size_t)>& task);
+
+        // Receives a value in document order, independent of its layout. Shared nodes are transparent and packed
+        // arrays report their elements as plain numbers. Container sizes are 0 when the producer does not know them
+        // in advance, which is the case while parsing
+        class ValueVisitor {
+        public:
+            virtual ~ValueVisitor() = default;
+
+            virtual void null() = 0;
+            virtual void boolean(bool value) = 0;
+            virtual void integer(int value) = 0;
+            virtual void number(double value) = 0;
+            virtual void string(const std::string& value) = 0;
+            virtual void beginObject(size_t size) = 0; // Followed by pairs of key() and a value
+            virtual void key(const std::string& name) = 0;
+            virtual void endObject() = 0;
+            virtual void beginArray(size_t size) = 0;
+            virtual void endArray() = 0;
+        };
+
+        // Serializer entry points for other translation units, implemented next to JsonValue
+        // depth is the nesting level the value starts at, used for indentation
+        void serializeValue(const JsonValue& value, StringOutput& out, const WriteOptions& options, size_t depth = 0);
+        void serializeValue(const JsonValue& value, BufferedOutput& out, const WriteOptions& options, size_t depth = 0);
+        void visitValue(const JsonValue& value, ValueVisitor& visitor);
+        void parseEvents(const char* json, size_t length, ValueVisitor& visitor); // Same grammar and errors as parseJson
+    }
+}
+
+#endif
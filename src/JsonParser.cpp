@@ -1,26 +1,27 @@
 #include "json/JsonParser.h"
-#include <sstream>
-
-#define JSON_NULL_LITERAL "null"
-#define JSON_BOOLTRUE_LITERAL "true"
-#define JSON_BOOLFALSE_LITERAL "false"
-#define JSONSTRING_DELIMITER '"'
-#define JSONKEYVALUE_SEPERATOR ':'
-#define JSONVALUE_DELIMITER ','
-#define JSONOBJECT_STARTDELIMITER '{'
-#define JSONOBJECT_ENDDELIMITER '}'
-#define JSONARRAY_STARTDELIMITER '['
-#define JSONARRAY_ENDDELIMITER ']'
+#include "json/JsonBind.h"
+#include "JsonOutput.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <ostream>
+#include <unordered_set>
+
+#ifdef JSONPARSER_HAS_POSIX_IO
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
 
 static constexpr size_t nullLiteralEndIndex = sizeof(JSON_NULL_LITERAL) - 2; // Exclude \0
 static constexpr size_t trueLiteralEndIndex = sizeof(JSON_BOOLTRUE_LITERAL) - 2;
 static constexpr size_t falseLiteralEndIndex = sizeof(JSON_BOOLFALSE_LITERAL) - 2;
 
-struct ObjectElementResult {
-    Json::JsonObjectEntry entry;
-    const size_t nextSeparatorPos;
-};
-
 struct ArrayElementResult {
     Json::JsonValue value;
     const size_t nextSeparatorPos;
@@ -66,7 +67,567 @@ struct SubString {
     const char* end() const { return data + length; }
 };
 
-static Json::JsonValue internalParseJson(const SubString& json);
+struct ObjectElementSpan {
+    SubString key; // Without enclosing quotes, still escaped
+    SubString value;
+    const size_t nextSeparatorPos;
+};
+
+namespace Json {
+    namespace Detail {
+        template <typename T>
+        using Vector = std::vector<T, Allocator<T>>;
+
+        // Allocations inside the scope go to the resource the given payload came from, so lazily built caches and
+        // fallback containers end up next to their owner
+        struct OwnerResourceScope {
+#ifdef JSONPARSER_MEMORY_RESOURCE
+            MemoryResourceScope scope;
+            explicit OwnerResourceScope(const void* payload) noexcept : scope(payloadResource(payload)) {}
+#else
+            explicit OwnerResourceScope(const void*) noexcept {}
+#endif
+        };
+
+#ifndef __cpp_lib_generic_unordered_lookup
+        // Without heterogeneous lookup the map only finds std::string keys. The member is looked up in the bucket of
+        // the given hash instead, so no temporary key gets built and a precomputed hash is not computed again.
+        // Bucket functions of the known standard libraries are mirrored, other ones ask the map with a temporary key
+        static const Json::JsonValue* findInBucket(const Json::JsonObject& object, const char* key, size_t length, size_t hash) {
+            if (object.empty())
+                return nullptr;
+            size_t count = object.bucket_count();
+#if defined(__GLIBCXX__)
+            size_t bucket = hash % count;
+#elif defined(_LIBCPP_VERSION)
+            size_t bucket = (count & (count - 1)) == 0 ? hash & (count - 1) : (hash < count ? hash : hash % count);
+#elif defined(_MSC_VER)
+            size_t bucket = hash & (count - 1);
+#else
+            (void)count;
+            (void)hash;
+            size_t bucket = object.bucket(std::string(key, length));
+#endif
+            for (auto it = object.begin(bucket); it != object.end(bucket); ++it) {
+                if (it->first.length() == length && std::memcmp(it->first.data(), key, length) == 0)
+                    return &it->second;
+            }
+            return nullptr;
+        }
+#endif
+
+        class Shape {
+        private:
+            Vector<uint32_t> m_table; // Open addressing, holds slot + 1 and 0 for empty buckets
+            size_t m_mask;
+
+        public:
+            std::atomic<size_t> refs;
+            const Vector<std::string> keys;
+            const Vector<size_t> hashes;
+            mutable std::atomic<Vector<uint32_t>*> canonicalOrder; // Slots sorted for the canonical form, built on first use
+
+            Shape(Vector<std::string>&& shapeKeys, Vector<size_t>&& keyHashes)
+                : refs(1), keys(std::move(shapeKeys)), hashes(std::move(keyHashes)), canonicalOrder(nullptr) {
+                size_t capacity = 4;
+                while (capacity < keys.size() * 2) {
+                    capacity <<= 1;
+                }
+                m_table.assign(capacity, 0);
+                m_mask = capacity - 1;
+
+                for (size_t slot = 0; slot < keys.size(); slot++) {
+                    size_t bucket = hashes[slot] & m_mask;
+                    while (m_table[bucket] != 0) {
+                        bucket = (bucket + 1) & m_mask;
+                    }
+                    m_table[bucket] = static_cast<uint32_t>(slot + 1);
+                }
+            }
+
+            ~Shape() {
+                destroyPayload(canonicalOrder.load(std::memory_order_acquire));
+            }
+
+            inline size_t size() const noexcept { return keys.size(); }
+            inline size_t tableBytes() const noexcept {
+                const Vector<uint32_t>* order = canonicalOrder.load(std::memory_order_acquire);
+                return (m_table.capacity() + (order ? order->capacity() : 0)) * sizeof(uint32_t);
+            }
+
+            const Vector<uint32_t>& sortedSlots() const {
+                Vector<uint32_t>* cached = canonicalOrder.load(std::memory_order_acquire);
+                if (cached) {
+                    return *cached;
+                }
+
+                OwnerResourceScope owner(this);
+                Vector<uint32_t>* built = createPayload<Vector<uint32_t>>(keys.size());
+                for (size_t slot = 0; slot < keys.size(); slot++) {
+                    (*built)[slot] = static_cast<uint32_t>(slot);
+                }
+                std::sort(built->begin(), built->end(), [this](uint32_t a, uint32_t b) { return utf16Less(keys[a], keys[b]); });
+
+                if (!canonicalOrder.compare_exchange_strong(cached, built, std::memory_order_acq_rel)) {
+                    destroyPayload(built);
+                    return *cached;
+                }
+                return *built;
+            }
+
+            size_t find(const char* key, size_t length) const {
+                // Repeated lookups of one key on records of one shape skip hashing entirely.
+                // Direct mapped by the address of the key, a hit is still verified against the slot key
+                struct CachedSlot { const Shape* shape; const char* key; size_t slot; };
+                static thread_local CachedSlot cache[16] = {};
+                CachedSlot& cached = cache[(reinterpret_cast<uintptr_t>(key) >> 3) & 15];
+                if (cached.shape == this && cached.key == key && cached.slot < keys.size() && keyEquals(cached.slot, key, length)) {
+                    return cached.slot;
+                }
+
+                size_t slot = probe(key, length, hashKey(key, length));
+                if (slot != std::string::npos) {
+                    cached = { this, key, slot };
+                }
+                return slot;
+            }
+
+            inline size_t find(const std::string& key) const { return find(key.data(), key.length()); }
+            inline size_t find(const Key& key) const { return probe(key.name().data(), key.name().length(), key.hash()); }
+
+            size_t probe(const char* key, size_t length, size_t hash) const {
+                size_t bucket = hash & m_mask;
+                while (m_table[bucket] != 0) {
+                    size_t slot = m_table[bucket] - 1;
+                    if (keyEquals(slot, key, length)) {
+                        return slot;
+                    }
+                    bucket = (bucket + 1) & m_mask;
+                }
+                return std::string::npos;
+            }
+
+            inline bool keyEquals(size_t slot, const char* key, size_t length) const {
+                return keys[slot].length() == length && std::memcmp(keys[slot].data(), key, length) == 0;
+            }
+
+            static void release(Shape* shape) noexcept {
+                if (shape->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    destroyPayload(shape);
+                }
+            }
+        };
+
+        struct ShapedObject {
+            Shape* shape;
+            JsonArray values;
+            mutable std::atomic<JsonObject*> materialized; // Regular object built for const toObject()
+
+            ShapedObject(Shape* s, JsonArray&& v) : shape(s), values(std::move(v)), materialized(nullptr) {
+                shape->refs.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            ShapedObject(const ShapedObject& other) : shape(other.shape), values(other.values), materialized(nullptr) {
+                shape->refs.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            ~ShapedObject() {
+                destroyPayload(materialized.load(std::memory_order_acquire));
+                Shape::release(shape);
+            }
+
+            const JsonObject& materialize() const {
+                JsonObject* cached = materialized.load(std::memory_order_acquire);
+                if (cached) {
+                    return *cached;
+                }
+
+                OwnerResourceScope owner(this);
+                JsonObject* built = createPayload<JsonObject>();
+                built->reserve(values.size());
+                for (size_t i = 0; i < values.size(); i++) {
+                    built->emplace(shape->keys[i], values[i]);
+                }
+
+                // Another reader might have been faster, keep whichever object got published first
+                if (!materialized.compare_exchange_strong(cached, built, std::memory_order_acq_rel)) {
+                    destroyPayload(built);
+                    return *cached;
+                }
+                return *built;
+            }
+        };
+
+        struct SharedNode {
+            std::atomic<size_t> refs;
+            JsonValue value; // Only the last owner may move out of it, everyone else clones
+            mutable std::atomic<uint64_t> hash; // Structural hash of value, 0 until computed
+
+            explicit SharedNode(JsonValue&& v) : refs(1), value(std::move(v)), hash(0) {}
+
+            static void release(SharedNode* node) noexcept {
+                if (node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    destroyPayload(node);
+                }
+            }
+        };
+
+        struct PackedArray {
+            bool integral; // Elements live in ints, otherwise in doubles
+            Vector<int> ints;
+            Vector<double> doubles;
+            Vector<bool> integerMask; // Only used for mixed arrays, marks elements parsed as integers
+            mutable std::atomic<JsonArray*> materialized; // Regular array built for const element access
+
+            PackedArray(Vector<int>&& i) : integral(true), ints(std::move(i)), materialized(nullptr) {}
+            PackedArray(Vector<double>&& d, Vector<bool>&& mask)
+                : integral(false), doubles(std::move(d)), integerMask(std::move(mask)), materialized(nullptr) {}
+
+            PackedArray(const PackedArray& other)
+                : integral(other.integral), ints(other.ints), doubles(other.doubles), integerMask(other.integerMask), materialized(nullptr) {}
+
+            ~PackedArray() {
+                destroyPayload(materialized.load(std::memory_order_acquire));
+            }
+
+            inline size_t size() const noexcept { return integral ? ints.size() : doubles.size(); }
+
+            JsonValue element(size_t index) const {
+                if (integral)
+                    return JsonValue(ints[index]);
+                if (!integerMask.empty() && integerMask[index])
+                    return JsonValue(static_cast<int>(doubles[index]));
+                return JsonValue(doubles[index]);
+            }
+
+            JsonArray unpacked() const {
+                JsonArray array;
+                array.reserve(size());
+                for (size_t i = 0; i < size(); i++) {
+                    array.push_back(element(i));
+                }
+                return array;
+            }
+
+            const JsonArray& materialize() const {
+                JsonArray* cached = materialized.load(std::memory_order_acquire);
+                if (cached) {
+                    return *cached;
+                }
+
+                OwnerResourceScope owner(this);
+                JsonArray* built = createPayload<JsonArray>(unpacked());
+                if (!materialized.compare_exchange_strong(cached, built, std::memory_order_acq_rel)) {
+                    destroyPayload(built);
+                    return *cached;
+                }
+                return *built;
+            }
+
+            bool operator==(const PackedArray& other) const {
+                if (size() != other.size())
+                    return false;
+                if (integral && other.integral)
+                    return ints == other.ints;
+                for (size_t i = 0; i < size(); i++) {
+                    if (element(i) != other.element(i))
+                        return false;
+                }
+                return true;
+            }
+        };
+
+        struct ValueAccess {
+            static JsonValue makePacked(PackedArray* array) {
+                JsonValue value;
+                value.n_value = array;
+                value.m_type = JsonType::Array;
+                value.m_layout = Layout::Packed;
+                return value;
+            }
+
+            static JsonValue makeShaped(ShapedObject* object) {
+                JsonValue value;
+                value.r_value = object;
+                value.m_type = JsonType::Object;
+                value.m_layout = Layout::Shaped;
+                return value;
+            }
+
+            // Children of containers written on a single line are kept on one line as well
+            template <typename Output>
+            static void serialize(const JsonValue& value, Output& out, const WriteOptions& options, size_t depth, bool allowLineBreaks);
+
+            static bool breaksLines(const JsonValue& value, const WriteOptions& options);
+            static size_t singleLineLength(const JsonValue& value, const WriteOptions& options, size_t limit);
+            static void visit(const JsonValue& value, ValueVisitor& visitor);
+        };
+    }
+}
+
+struct InternedKey {
+    const std::string name;
+    const size_t hash;
+};
+
+// Keys seen during one shaped parse, each distinct key is decoded and validated only once. Shapes are looked up by
+// the identity of these entries
+class KeyTable {
+private:
+    std::deque<InternedKey> m_keys; // Deque keeps references stable while growing
+    std::unordered_multimap<size_t, const InternedKey*> m_index;
+
+public:
+    KeyTable() = default;
+    KeyTable(const KeyTable&) = delete;
+    KeyTable& operator=(const KeyTable&) = delete;
+
+    const InternedKey* find(const char* data, size_t length, size_t hash) const {
+        auto range = m_index.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            const std::string& name = it->second->name;
+            if (name.length() == length && name.compare(0, length, data, length) == 0) {
+                return it->second;
+            }
+        }
+        return nullptr;
+    }
+
+    const InternedKey& insert(std::string name, size_t hash) {
+        m_keys.push_back({ std::move(name), hash });
+        const InternedKey& key = m_keys.back();
+        m_index.emplace(hash, &key);
+        return key;
+    }
+};
+
+// Shapes created during one parse, keyed by the sequence of interned key pointers
+class ShapeCache {
+private:
+    struct Entry {
+        std::vector<const InternedKey*> keys;
+        Json::Detail::Shape* shape; // Nullptr if the key sequence can not be shaped
+    };
+
+    std::unordered_multimap<size_t, Entry> m_entries;
+
+public:
+    ShapeCache() = default;
+    ShapeCache(const ShapeCache&) = delete;
+    ShapeCache& operator=(const ShapeCache&) = delete;
+
+    ~ShapeCache() {
+        for (auto& entry : m_entries) {
+            if (entry.second.shape) {
+                Json::Detail::Shape::release(entry.second.shape);
+            }
+        }
+    }
+
+    Json::Detail::Shape* find(const std::vector<const InternedKey*>& keys) {
+        size_t hash = keys.size();
+        for (const InternedKey* key : keys) {
+            hash = (hash ^ reinterpret_cast<uintptr_t>(key)) * 1099511628211ULL;
+        }
+
+        auto range = m_entries.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second.keys == keys) {
+                return it->second.shape;
+            }
+        }
+
+        Json::Detail::Shape* shape = nullptr;
+        bool duplicates = false;
+        for (size_t i = 0; i < keys.size() && !duplicates; i++) {
+            for (size_t j = i + 1; j < keys.size(); j++) {
+                duplicates |= keys[i] == keys[j];
+            }
+        }
+
+        if (!duplicates) {
+            Json::Detail::Vector<std::string> names;
+            Json::Detail::Vector<size_t> hashes;
+            names.reserve(keys.size());
+            hashes.reserve(keys.size());
+            for (const InternedKey* key : keys) {
+                names.push_back(key->name);
+                hashes.push_back(key->hash);
+            }
+            shape = Json::Detail::createPayload<Json::Detail::Shape>(std::move(names), std::move(hashes));
+        }
+
+        m_entries.emplace(hash, Entry{ keys, shape });
+        return shape;
+    }
+};
+
+namespace Json {
+    namespace Detail {
+#ifdef JSONPARSER_MEMORY_RESOURCE
+        static constexpr size_t payloadOverhead = alignof(std::max_align_t); // Resource header in front of each payload
+#else
+        static constexpr size_t payloadOverhead = 0;
+#endif
+        // Approximation of the per entry bookkeeping of std::unordered_map, next pointer and cached hash
+        static constexpr size_t mapNodeLinkBytes = sizeof(void*) + sizeof(size_t);
+
+        class UsageCollector {
+        private:
+            MemoryUsage& m_usage;
+            std::unordered_set<const void*> m_seen; // Shapes and shared nodes
+            bool m_copiesOnly; // Walking a materialized cache, shared nodes in there are not duplicated
+
+            inline void addPayload(size_t size) { m_usage.totalBytes += size + payloadOverhead; }
+
+            void addString(const std::string& string) {
+                // Strings within the small string buffer own no heap memory
+                static const size_t inlineCapacity = std::string().capacity();
+                if (string.capacity() > inlineCapacity) {
+                    m_usage.stringBytes += string.capacity() + 1;
+                    m_usage.totalBytes += string.capacity() + 1;
+                }
+            }
+
+            template <typename T, typename A>
+            void addVector(const std::vector<T, A>& vector) {
+                size_t slack = (vector.capacity() - vector.size()) * sizeof(T);
+                m_usage.containerOverhead += slack;
+                m_usage.totalBytes += vector.capacity() * sizeof(T);
+            }
+
+            void addBits(const Vector<bool>& bits) {
+                m_usage.totalBytes += (bits.capacity() + 7) / 8;
+                m_usage.containerOverhead += (bits.capacity() - bits.size()) / 8;
+            }
+
+            void addObjectStorage(const JsonObject& object) {
+                size_t buckets = object.bucket_count() * sizeof(void*);
+                size_t links = object.size() * mapNodeLinkBytes;
+                m_usage.containerOverhead += buckets + links;
+                m_usage.totalBytes += buckets + links + object.size() * sizeof(JsonObject::value_type);
+                for (const auto& entry : object) {
+                    addString(entry.first);
+                }
+            }
+
+            void addShape(const Shape& shape) {
+                if (!m_seen.insert(&shape).second)
+                    return;
+                addPayload(sizeof(Shape));
+                addVector(shape.keys);
+                addVector(shape.hashes);
+                m_usage.containerOverhead += shape.tableBytes();
+                m_usage.totalBytes += shape.tableBytes();
+                for (const std::string& key : shape.keys) {
+                    addString(key);
+                }
+            }
+
+            // Materialized caches hold copies, they cost memory but add no nodes
+            void addCache(const JsonValue& value) {
+                MemoryUsage copies;
+                UsageCollector collector(copies, true);
+                collector.addDeep(value);
+                m_usage.stringBytes += copies.stringBytes;
+                m_usage.containerOverhead += copies.containerOverhead;
+                m_usage.totalBytes += copies.totalBytes;
+            }
+
+        public:
+            explicit UsageCollector(MemoryUsage& usage, bool copiesOnly = false) : m_usage(usage), m_copiesOnly(copiesOnly) {}
+
+            // Counts the value and the memory it owns directly, children are added separately.
+            // Returns false for shared nodes that were already counted
+            bool addShallow(const JsonValue& value) {
+                if (value.hasLayout(Layout::Shared)) {
+                    if (m_copiesOnly || !m_seen.insert(value.h_value).second)
+                        return false;
+                    addPayload(sizeof(SharedNode));
+                    return addShallow(value.h_value->value);
+                }
+
+                m_usage.nodes[static_cast<size_t>(value.m_type)]++;
+                switch (value.m_type) {
+                    case JsonType::String:
+                        addPayload(sizeof(std::string));
+                        addString(*value.s_value);
+                        break;
+                    case JsonType::Object:
+                        if (value.hasLayout(Layout::Shaped)) {
+                            addPayload(sizeof(ShapedObject));
+                            addVector(value.r_value->values);
+                            addShape(*value.r_value->shape);
+                            if (const JsonObject* cached = value.r_value->materialized.load(std::memory_order_acquire)) {
+                                addPayload(sizeof(JsonObject));
+                                addObjectStorage(*cached);
+                                for (const auto& entry : *cached) {
+                                    addCache(entry.second);
+                                }
+                            }
+                        } else {
+                            addPayload(sizeof(JsonObject));
+                            addObjectStorage(*value.o_value);
+                        }
+                        break;
+                    case JsonType::Array:
+                        if (value.hasLayout(Layout::Packed)) {
+                            const PackedArray& packed = *value.n_value;
+                            addPayload(sizeof(PackedArray));
+                            addVector(packed.ints);
+                            addVector(packed.doubles);
+                            addBits(packed.integerMask);
+                            for (size_t i = 0; i < packed.size(); i++) {
+                                bool isInteger = packed.integral || (!packed.integerMask.empty() && packed.integerMask[i]);
+                                m_usage.nodes[static_cast<size_t>(isInteger ? JsonType::Integer : JsonType::Double)]++;
+                            }
+                            if (const JsonArray* cached = packed.materialized.load(std::memory_order_acquire)) {
+                                addPayload(sizeof(JsonArray));
+                                addVector(*cached);
+                            }
+                        } else {
+                            addPayload(sizeof(JsonArray));
+                            addVector(*value.a_value);
+                        }
+                        break;
+                    default: break;
+                }
+                return true;
+            }
+
+            void addDeep(const JsonValue& value) {
+                if (!addShallow(value))
+                    return;
+
+                const JsonValue& resolved = value.resolved();
+                if (resolved.isObject()) {
+                    if (resolved.hasLayout(Layout::Shaped)) {
+                        for (const JsonValue& child : resolved.r_value->values) {
+                            addDeep(child);
+                        }
+                    } else {
+                        for (const auto& entry : *resolved.o_value) {
+                            addDeep(entry.second);
+                        }
+                    }
+                } else if (resolved.isArray() && !resolved.hasLayout(Layout::Packed)) {
+                    for (const JsonValue& child : *resolved.a_value) {
+                        addDeep(child);
+                    }
+                }
+            }
+        };
+    }
+}
+
+struct ParseContext {
+    KeyTable* keyTable;
+    ShapeCache* shapes;
+    bool packNumbers;
+    Json::Detail::UsageCollector* usage;
+};
+
+static Json::JsonValue internalParseJson(const SubString& json, ParseContext& ctx);
 
 static inline std::string subStrToString(const SubString& subStr) {
     return std::string(subStr.data, subStr.length);
@@ -78,10 +639,53 @@ static constexpr bool isJsonWhitespace(char c) noexcept {
     return c == ' ' || c == '\t' || c == '\n' || c == '\r';
 }
 
-static std::string parseJsonStringValue(const SubString& input) {
-    std::string result;
-    result.reserve(input.length);
+static inline int hexDigitValue(char c) noexcept {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static uint32_t parseUnicodeEscapeUnit(const SubString& input, size_t digitsStart) {
+    // Expects the four hex digits following a \u
+    if (digitsStart + 4 > input.length) {
+        throw Json::JsonMalformedException("Incomplete unicode escape sequence in json string");
+    }
+    uint32_t unit = 0;
+    for (size_t i = digitsStart; i < digitsStart + 4; i++) {
+        int digit = hexDigitValue(input[i]);
+        if (digit < 0) {
+            throw Json::JsonMalformedException("Invalid hex digit in unicode escape sequence in json string");
+        }
+        unit = (unit << 4) | static_cast<uint32_t>(digit);
+    }
+    return unit;
+}
 
+static size_t decodeUnicodeEscape(const SubString& input, size_t escapeStart, std::string& result) {
+    // Appends the UTF-8 form of the \uXXXX sequence (or surrogate pair) at escapeStart, returns its length
+    uint32_t codePoint = parseUnicodeEscapeUnit(input, escapeStart + 2);
+    size_t consumed = 6;
+    if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+        if (escapeStart + 12 > input.length || input[escapeStart + 6] != '\\' || input[escapeStart + 7] != 'u') {
+            throw Json::JsonMalformedException("Unpaired surrogate in unicode escape sequence in json string");
+        }
+        uint32_t low = parseUnicodeEscapeUnit(input, escapeStart + 8);
+        if (low < 0xDC00 || low > 0xDFFF) {
+            throw Json::JsonMalformedException("Unpaired surrogate in unicode escape sequence in json string");
+        }
+        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+        consumed = 12;
+    } else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF) {
+        throw Json::JsonMalformedException("Unpaired surrogate in unicode escape sequence in json string");
+    }
+
+    char buffer[4];
+    result.append(buffer, Json::Detail::encodeUtf8(codePoint, buffer));
+    return consumed;
+}
+
+static void appendJsonStringValue(const SubString& input, std::string& result) {
     size_t i = 0;
     while (i < input.length) {
         if (input[i] == '\\') {
@@ -96,6 +700,9 @@ static std::string parseJsonStringValue(const SubString& input) {
                     case 'n':  result += '\n'; break;
                     case 'r':  result += '\r'; break;
                     case 't':  result += '\t'; break;
+                    case 'u':
+                        i += decodeUnicodeEscape(input, i, result);
+                        continue;
                     default:
                         throw Json::JsonMalformedException("Unsupported or invalid escape sequence in json string");
                 }
@@ -104,34 +711,21 @@ static std::string parseJsonStringValue(const SubString& input) {
                 throw Json::JsonMalformedException("Standalone escape character in json string");
             }
         } else {
-            // Check for raw invalid characters, including control chars [0-31] and special chars
-            if (input[i] < 32 || input[i] == '\"' || input[i] == '\\') {
+            // Check for raw invalid characters, including control chars [0-31] and special chars. Bytes above 127 belong
+            // to UTF-8 sequences and are kept as they are
+            if (static_cast<unsigned char>(input[i]) < 32 || input[i] == '\"' || input[i] == '\\') {
                 throw Json::JsonMalformedException("Invalid unescaped raw character in json string");
             }
             result += input[i];
         }
         i++;
     }
-    return result;
 }
 
-static std::string escapeString(const SubString& input) {
+static std::string parseJsonStringValue(const SubString& input) {
     std::string result;
     result.reserve(input.length);
-
-    for (char c : input) {
-        switch (c) {
-            case '\"': result += "\\\""; break;
-            case '\\': result += "\\\\"; break;
-            case '/':  result += "\\/"; break;
-            case '\b': result += "\\b"; break;
-            case '\f': result += "\\f"; break;
-            case '\n': result += "\\n"; break;
-            case '\r': result += "\\r"; break;
-            case '\t': result += "\\t"; break;
-            default: result += c;
-        }
-    }
+    appendJsonStringValue(input, result);
     return result;
 }
 
@@ -147,8 +741,9 @@ static size_t findNextNonWSCharacter(const SubString& string, size_t off = 0) {
 static size_t findEndOfJsonString(const SubString& jsonString, size_t stringStart = 0) {
     // Expects index 0 to hold string start quotes
     for (size_t i = stringStart + 1; i < jsonString.length; i++) {
-        // If its not an escaped quote set it as delimiter
-        if (jsonString[i] == JSONSTRING_DELIMITER && jsonString[i - 1] != '\\') {
+        if (jsonString[i] == '\\') {
+            i++; // Skip the escaped character, so an escaped backslash cannot hide the closing quote
+        } else if (jsonString[i] == JSONSTRING_DELIMITER) {
             return i;
         }
     }
@@ -278,7 +873,7 @@ static ValueMetaInfo findNextJsonValue(const SubString& json, size_t from = 0) {
             }
         }
         throw Json::JsonMalformedException("Json array with missing closing bracket");
-    } else if (json[0] == JSON_NULL_LITERAL[0] && startsWith(json.subView(valueStart), JSON_NULL_LITERAL)) {
+    } else if (json[valueStart] == JSON_NULL_LITERAL[0] && startsWith(json.subView(valueStart), JSON_NULL_LITERAL)) {
         return { valueStart, valueStart + nullLiteralEndIndex, Json::JsonType::Null };
     }
     throw Json::JsonMalformedException("Unable to determine json type");
@@ -299,7 +894,7 @@ static KeyMetaInfo findNextKey(const SubString& json, size_t from = 0) {
     return { beginKey, endKey };
 }
 
-static ArrayElementResult parseNextJsonArrayValue(const SubString& jsonArray, size_t from = 0) {
+static ArrayElementResult parseNextJsonArrayValue(const SubString& jsonArray, ParseContext& ctx, size_t from = 0) {
     ValueMetaInfo valueInfo = findNextJsonValue(jsonArray, from);
     size_t commaPos = findNextNonWSCharacter(jsonArray, valueInfo.endIndex + 1);
     if (commaPos == std::string::npos)
@@ -313,11 +908,35 @@ static ArrayElementResult parseNextJsonArrayValue(const SubString& jsonArray, si
         commaPos = std::string::npos; // Signal for calling function that end of array is reached
     }
 
-    Json::JsonValue value = internalParseJson(jsonArray.subView(valueInfo.startIndex, valueInfo.endIndex));
+    Json::JsonValue value = internalParseJson(jsonArray.subView(valueInfo.startIndex, valueInfo.endIndex), ctx);
     return { { value } , commaPos };
 }
 
-static ObjectElementResult parseNextJsonKeyValuePair(const SubString& json, size_t from = 0) {
+static const InternedKey& internKey(const SubString& keyString, ParseContext& ctx) {
+    bool escaped = false;
+    for (char c : keyString) {
+        escaped |= c == '\\';
+    }
+
+    if (escaped) {
+        // Rare case, decode first so the table only ever sees decoded keys
+        std::string decoded = parseJsonStringValue(keyString);
+        size_t hash = Json::hashKey(decoded.data(), decoded.length());
+        const InternedKey* known = ctx.keyTable->find(decoded.data(), decoded.length(), hash);
+        return known ? *known : ctx.keyTable->insert(std::move(decoded), hash);
+    }
+
+    size_t hash = Json::hashKey(keyString.data, keyString.length);
+    const InternedKey* known = ctx.keyTable->find(keyString.data, keyString.length, hash);
+    if (known)
+        return *known;
+
+    // Still validates raw characters of keys that are seen the first time
+    parseJsonStringValue(keyString);
+    return ctx.keyTable->insert(std::string(keyString.data, keyString.length), hash);
+}
+
+static ObjectElementSpan findNextJsonKeyValuePair(const SubString& json, size_t from = 0) {
     KeyMetaInfo keyInfo = findNextKey(json, from);
     size_t colonPos = findNextNonWSCharacter(json, keyInfo.endIndex + 1);
     if (colonPos == std::string::npos || json[colonPos] != JSONKEYVALUE_SEPERATOR)
@@ -339,50 +958,298 @@ static ObjectElementResult parseNextJsonKeyValuePair(const SubString& json, size
 
     // Cutoff enclosing quotes
     SubString keyString = json.subView(keyInfo.startIndex + 1, keyInfo.endIndex - 1);
-    // Deserialize child value
-    SubString valueString = json.subView(valueInfo.startIndex, valueInfo.endIndex);
-    Json::JsonValue value = internalParseJson(valueString);
+    return { keyString, json.subView(valueInfo.startIndex, valueInfo.endIndex), commaPos };
+}
+
+// Duplicate keys lose to their first occurrence. Their values are still parsed for validation, but left out of the stats
+static Json::JsonValue parseDiscardedValue(const SubString& valueString, ParseContext& ctx) {
+    Json::Detail::UsageCollector* usage = ctx.usage;
+    ctx.usage = nullptr;
+    Json::JsonValue value = internalParseJson(valueString, ctx);
+    ctx.usage = usage;
+    return value;
+}
+
+// Containers with fewer elements are not worth handing to other threads
+static constexpr size_t parallelMinElements = 4096;
+static constexpr size_t parallelMinChunk = 512;
+
+static inline bool serializesInParallel(size_t count, const Json::WriteOptions& options) noexcept {
+    return count >= parallelMinElements && Json::Detail::serializationThreads(options) > 1 && !Json::Detail::insideParallelSerialization();
+}
 
-    return { { parseJsonStringValue(keyString), value }, commaPos };
+// Each chunk of elements is written into its own string by a worker, including the separators before them. Chunks
+// are handed to the output in order after each wave, so the result matches the sequential output byte for byte
+template <typename Output, typename Elements>
+static void serializeElementsParallel(const Elements& elements, size_t count, Output& out, const Json::WriteOptions& options, size_t depth,
+                                      bool multiline) {
+    unsigned int threads = Json::Detail::serializationThreads(options);
+    size_t chunkSize = std::max(parallelMinChunk, count / (static_cast<size_t>(threads) * 8));
+    size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+    size_t waveSize = static_cast<size_t>(threads) * 2; // Bounds the memory held by finished chunks
+    std::vector<std::string> chunks(std::min(waveSize, chunkCount));
+
+    for (size_t wave = 0; wave < chunkCount; wave += waveSize) {
+        size_t waveChunks = std::min(waveSize, chunkCount - wave);
+        std::function<void(size_t)> task = [&](size_t chunk) {
+            std::string& buffer = chunks[chunk];
+            buffer.clear();
+            Json::Detail::StringOutput chunkOut(buffer);
+            size_t begin = (wave + chunk) * chunkSize;
+            size_t end = std::min(begin + chunkSize, count);
+            for (size_t i = begin; i < end; i++) {
+                Json::Detail::appendElementStart(chunkOut, options, depth, multiline, i == 0);
+                elements.write(chunkOut, i, options, depth, multiline);
+            }
+        };
+        Json::Detail::runParallel(waveChunks, threads, task);
+        out.writeChunks(chunks.data(), waveChunks);
+    }
 }
 
-static std::string serializeArray(const Json::JsonArray& array) {
-    if (array.empty()) {
-        return { JSONARRAY_STARTDELIMITER, JSONARRAY_ENDDELIMITER };
+template <typename Output, typename Elements>
+static void serializeElements(const Elements& elements, size_t count, Output& out, const Json::WriteOptions& options, size_t depth,
+                              bool multiline) {
+    if (serializesInParallel(count, options)) {
+        serializeElementsParallel(elements, count, out, options, depth, multiline);
+        return;
     }
-    std::string result;
-    result += JSONARRAY_STARTDELIMITER;
-    size_t counter = 0;
-    for (const Json::JsonValue& entry : array) {
-        counter++;
-        result += Json::toJsonString(entry);
-        if (counter < array.size()) {
-            result += JSONVALUE_DELIMITER;
+    for (size_t i = 0; i < count; i++) {
+        Json::Detail::appendElementStart(out, options, depth, multiline, i == 0);
+        elements.write(out, i, options, depth, multiline);
+    }
+}
+
+template <typename Output>
+static inline void serializeMember(const std::string& key, const Json::JsonValue& value, Output& out, const Json::WriteOptions& options,
+                                   size_t depth, bool multiline) {
+    Json::Detail::appendString(out, key, Json::Detail::escapingOf(options));
+    Json::Detail::appendKeySeparator(out, options);
+    Json::Detail::ValueAccess::serialize(value, out, options, depth + 1, multiline);
+}
+
+static inline bool packedElementIsInt(const Json::Detail::PackedArray& array, size_t index) noexcept {
+    return array.integral || (!array.integerMask.empty() && array.integerMask[index]);
+}
+
+namespace {
+
+// Element access for serializeElements, one per container layout
+struct ArrayElements {
+    const Json::JsonArray& array;
+
+    template <typename Output>
+    inline void write(Output& out, size_t i, const Json::WriteOptions& options, size_t depth, bool multiline) const {
+        Json::Detail::ValueAccess::serialize(array[i], out, options, depth + 1, multiline);
+    }
+};
+
+struct PackedElements {
+    const Json::Detail::PackedArray& array;
+
+    template <typename Output>
+    inline void write(Output& out, size_t i, const Json::WriteOptions& options, size_t, bool) const {
+        if (array.integral) {
+            Json::Detail::appendInt(out, array.ints[i]);
+        } else if (packedElementIsInt(array, i)) {
+            Json::Detail::appendInt(out, static_cast<int>(array.doubles[i]));
+        } else {
+            Json::Detail::appendDouble(out, array.doubles[i], options.canonical);
         }
     }
-    result += JSONARRAY_ENDDELIMITER;
-    return result;
+};
+
+struct ShapedMembers {
+    const Json::Detail::ShapedObject& object;
+    const uint32_t* order; // Slot order, nullptr keeps the shape order
+
+    template <typename Output>
+    inline void write(Output& out, size_t i, const Json::WriteOptions& options, size_t depth, bool multiline) const {
+        size_t slot = order ? order[i] : i;
+        serializeMember(object.shape->keys[slot], object.values[slot], out, options, depth, multiline);
+    }
+};
+
+struct ObjectMembers {
+    const std::vector<const Json::JsonObject::value_type*>& entries;
+
+    template <typename Output>
+    inline void write(Output& out, size_t i, const Json::WriteOptions& options, size_t depth, bool multiline) const {
+        serializeMember(entries[i]->first, entries[i]->second, out, options, depth, multiline);
+    }
+};
+
+} // namespace
+
+template <typename Output>
+static void serializeArray(const Json::JsonArray& array, Output& out, const Json::WriteOptions& options, size_t depth, bool multiline) {
+    out.put(JSONARRAY_STARTDELIMITER);
+    serializeElements(ArrayElements{ array }, array.size(), out, options, depth, multiline);
+    Json::Detail::appendContainerEnd(out, options, depth, multiline, JSONARRAY_ENDDELIMITER);
+}
+
+template <typename Output>
+static void serializePackedArray(const Json::Detail::PackedArray& array, Output& out, const Json::WriteOptions& options, size_t depth, bool multiline) {
+    out.put(JSONARRAY_STARTDELIMITER);
+    serializeElements(PackedElements{ array }, array.size(), out, options, depth, multiline);
+    Json::Detail::appendContainerEnd(out, options, depth, multiline, JSONARRAY_ENDDELIMITER);
 }
 
-static std::string serializeObject(const Json::JsonObject& object) {
-    if (object.empty()) {
-        return { JSONOBJECT_STARTDELIMITER, JSONOBJECT_ENDDELIMITER };
+template <typename Output>
+static void serializeShapedObject(const Json::Detail::ShapedObject& object, Output& out, const Json::WriteOptions& options, size_t depth,
+                                  bool multiline) {
+    out.put(JSONOBJECT_STARTDELIMITER);
+    // The sorted order is computed once per shape and reused by every record
+    const uint32_t* order = options.canonical ? object.shape->sortedSlots().data() : nullptr;
+    serializeElements(ShapedMembers{ object, order }, object.values.size(), out, options, depth, multiline);
+    Json::Detail::appendContainerEnd(out, options, depth, multiline, JSONOBJECT_ENDDELIMITER);
+}
+
+template <typename Output>
+static void serializeObject(const Json::JsonObject& object, Output& out, const Json::WriteOptions& options, size_t depth, bool multiline) {
+    out.put(JSONOBJECT_STARTDELIMITER);
+    if (options.canonical || serializesInParallel(object.size(), options)) {
+        // Sorting and splitting into chunks both need indexed access to the entries. The sorted order is not cached,
+        // the keys of a regular object can change through any JsonObject reference handed out earlier
+        std::vector<const Json::JsonObject::value_type*> entries;
+        entries.reserve(object.size());
+        for (const auto& entry : object) {
+            entries.push_back(&entry);
+        }
+        if (options.canonical) {
+            std::sort(entries.begin(), entries.end(), [](const Json::JsonObject::value_type* a, const Json::JsonObject::value_type* b) {
+                return Json::Detail::utf16Less(a->first, b->first);
+            });
+        }
+        serializeElements(ObjectMembers{ entries }, entries.size(), out, options, depth, multiline);
+    } else {
+        bool first = true;
+        for (const auto& entry : object) {
+            Json::Detail::appendElementStart(out, options, depth, multiline, first);
+            first = false;
+            serializeMember(entry.first, entry.second, out, options, depth, multiline);
+        }
     }
-    std::string result;
-    result += JSONOBJECT_STARTDELIMITER;
-    size_t counter = 0;
-    for (const Json::JsonObjectEntry& entry : object) {
-        counter++;
-        result += JSONSTRING_DELIMITER + escapeString({ entry.first.c_str(), entry.first.length() }) + JSONSTRING_DELIMITER + JSONKEYVALUE_SEPERATOR + Json::toJsonString(entry.second);
-        if (counter < object.size()) {
-            result += JSONVALUE_DELIMITER;
+    Json::Detail::appendContainerEnd(out, options, depth, multiline, JSONOBJECT_ENDDELIMITER);
+}
+
+template <typename Output>
+void Json::Detail::ValueAccess::serialize(const JsonValue& value, Output& out, const WriteOptions& options, size_t depth, bool allowLineBreaks) {
+    if (value.hasLayout(Layout::Shared)) {
+        serialize(value.h_value->value, out, options, depth, allowLineBreaks);
+        return;
+    }
+    switch (value.m_type) {
+        case JsonType::Bool:
+            if (value.b_value) {
+                out.write(JSON_BOOLTRUE_LITERAL, sizeof(JSON_BOOLTRUE_LITERAL) - 1);
+            } else {
+                out.write(JSON_BOOLFALSE_LITERAL, sizeof(JSON_BOOLFALSE_LITERAL) - 1);
+            }
+            break;
+        case JsonType::Integer: appendInt(out, value.i_value); break;
+        case JsonType::Double: appendDouble(out, value.d_value, options.canonical); break;
+        case JsonType::String: appendString(out, *value.s_value, escapingOf(options)); break;
+        case JsonType::Object: {
+            bool multiline = allowLineBreaks && isPretty(options) && breaksLines(value, options);
+            if (value.hasLayout(Layout::Shaped)) {
+                serializeShapedObject(*value.r_value, out, options, depth, multiline);
+            } else {
+                serializeObject(*value.o_value, out, options, depth, multiline);
+            }
+            break;
+        }
+        case JsonType::Array: {
+            bool multiline = allowLineBreaks && isPretty(options) && breaksLines(value, options);
+            if (value.hasLayout(Layout::Packed)) {
+                serializePackedArray(*value.n_value, out, options, depth, multiline);
+            } else {
+                serializeArray(*value.a_value, out, options, depth, multiline);
+            }
+            break;
         }
+        case JsonType::Null: out.write(JSON_NULL_LITERAL, sizeof(JSON_NULL_LITERAL) - 1); break;
+        default: out.write("Unknown Json Value", sizeof("Unknown Json Value") - 1); break;
+    }
+}
+
+bool Json::Detail::ValueAccess::breaksLines(const JsonValue& value, const WriteOptions& options) {
+    // Empty containers always stay {} and []
+    size_t count;
+    if (value.m_type == JsonType::Object) {
+        count = value.hasLayout(Layout::Shaped) ? value.r_value->values.size() : value.o_value->size();
+    } else {
+        count = value.hasLayout(Layout::Packed) ? value.n_value->size() : value.a_value->size();
+    }
+    if (count == 0) {
+        return false;
+    }
+    return options.inlineWidth == 0 || singleLineLength(value, options, options.inlineWidth) > options.inlineWidth;
+}
+
+size_t Json::Detail::ValueAccess::singleLineLength(const JsonValue& value, const WriteOptions& options, size_t limit) {
+    // Stops measuring once the length exceeds limit, so deciding the layout of a large container stays cheap
+    if (value.hasLayout(Layout::Shared)) {
+        return singleLineLength(value.h_value->value, options, limit);
+    }
+
+    Escaping escaping = escapingOf(options);
+    size_t separator = isPretty(options) ? 2 : 1;
+    size_t colon = hasSpaceAfterColon(options) ? 2 : 1;
+    size_t length = 2; // Brackets or braces
+    switch (value.m_type) {
+        case JsonType::String:
+            // Escaping never shrinks a string, long ones are rejected without scanning them
+            if (value.s_value->length() + 2 > limit)
+                return limit + 1;
+            return stringLength(*value.s_value, escaping);
+        case JsonType::Object:
+            if (value.hasLayout(Layout::Shaped)) {
+                const ShapedObject& object = *value.r_value;
+                for (size_t i = 0; i < object.values.size() && length <= limit; i++) {
+                    const std::string& key = object.shape->keys[i];
+                    length += (i > 0 ? separator : 0) + colon;
+                    length += key.length() + 2 > limit ? limit + 1 : stringLength(key, escaping);
+                    length += singleLineLength(object.values[i], options, limit);
+                }
+            } else {
+                bool first = true;
+                for (const auto& entry : *value.o_value) {
+                    if (length > limit)
+                        break;
+                    length += (first ? 0 : separator) + colon;
+                    length += entry.first.length() + 2 > limit ? limit + 1 : stringLength(entry.first, escaping);
+                    length += singleLineLength(entry.second, options, limit);
+                    first = false;
+                }
+            }
+            return length;
+        case JsonType::Array:
+            if (value.hasLayout(Layout::Packed)) {
+                const PackedArray& array = *value.n_value;
+                for (size_t i = 0; i < array.size() && length <= limit; i++) {
+                    length += i > 0 ? separator : 0;
+                    if (array.integral) {
+                        length += intLength(array.ints[i]);
+                    } else if (packedElementIsInt(array, i)) {
+                        length += intLength(static_cast<int>(array.doubles[i]));
+                    } else {
+                        length += doubleLength(array.doubles[i], options.canonical);
+                    }
+                }
+            } else {
+                const JsonArray& array = *value.a_value;
+                for (size_t i = 0; i < array.size() && length <= limit; i++) {
+                    length += (i > 0 ? separator : 0) + singleLineLength(array[i], options, limit);
+                }
+            }
+            return length;
+        default:
+            return serializedSize(value, options);
     }
-    result += JSONOBJECT_ENDDELIMITER;
-    return result;
 }
 
-static Json::JsonArray deserializeArray(const SubString& jsonArray) {
+static Json::JsonArray deserializeArray(const SubString& jsonArray, ParseContext& ctx) {
     // This method assumes the input is already cropped and guranteed to be a json array!
     Json::JsonArray array;
     size_t index = findNextNonWSCharacter(jsonArray, 1);
@@ -394,7 +1261,7 @@ static Json::JsonArray deserializeArray(const SubString& jsonArray) {
     }
 
     while (index <= end) {
-        ArrayElementResult result = parseNextJsonArrayValue(jsonArray, index);
+        ArrayElementResult result = parseNextJsonArrayValue(jsonArray, ctx, index);
         array.push_back(std::move(result.value));
         if (result.nextSeparatorPos == std::string::npos) {
             break;
@@ -404,7 +1271,41 @@ static Json::JsonArray deserializeArray(const SubString& jsonArray) {
     return array;
 }
 
-static Json::JsonObject deserializeObject(const SubString& jsonObj) {
+static Json::JsonValue deserializeShapedObject(const SubString& jsonObj, ParseContext& ctx) {
+    // This method assumes the input is already cropped and guranteed to be a non empty json object!
+    std::vector<const InternedKey*> keys;
+    std::unordered_set<const InternedKey*> seen; // Only filled when collecting stats
+    Json::JsonArray values;
+    size_t index = findNextNonWSCharacter(jsonObj, 1);
+
+    while (index <= jsonObj.length - 1) {
+        ObjectElementSpan result = findNextJsonKeyValuePair(jsonObj, index);
+        const InternedKey& key = internKey(result.key, ctx);
+        keys.push_back(&key);
+        if (ctx.usage && !seen.insert(&key).second) {
+            values.push_back(parseDiscardedValue(result.value, ctx));
+        } else {
+            values.push_back(internalParseJson(result.value, ctx));
+        }
+        if (result.nextSeparatorPos == std::string::npos) {
+            break;
+        }
+        index = result.nextSeparatorPos + 1;
+    }
+
+    Json::Detail::Shape* shape = ctx.shapes->find(keys);
+    if (!shape) {
+        // Duplicate keys, regular object keeps the first occurrence like in the unshaped case
+        Json::JsonObject obj;
+        for (size_t i = 0; i < keys.size(); i++) {
+            obj.emplace(keys[i]->name, std::move(values[i]));
+        }
+        return Json::JsonValue(std::move(obj));
+    }
+    return Json::Detail::ValueAccess::makeShaped(Json::Detail::createPayload<Json::Detail::ShapedObject>(shape, std::move(values)));
+}
+
+static Json::JsonValue deserializeObject(const SubString& jsonObj, ParseContext& ctx) {
     // This method assumes the input is already cropped and guranteed to be a json object!
     Json::JsonObject obj;
 
@@ -416,30 +1317,225 @@ static Json::JsonObject deserializeObject(const SubString& jsonObj) {
         return obj;
     }
 
+    if (ctx.shapes) {
+        return deserializeShapedObject(jsonObj, ctx);
+    }
+
     while (index <= end) {
-        ObjectElementResult result = parseNextJsonKeyValuePair(jsonObj, index);
-        obj.insert(std::move(result.entry));
+        ObjectElementSpan result = findNextJsonKeyValuePair(jsonObj, index);
+        auto slot = obj.emplace(parseJsonStringValue(result.key), Json::JsonValue());
+        if (slot.second) {
+            slot.first->second = internalParseJson(result.value, ctx);
+        } else {
+            parseDiscardedValue(result.value, ctx);
+        }
         if (result.nextSeparatorPos == std::string::npos) {
             break;
         }
         index = result.nextSeparatorPos + 1;
     }
-    return obj;
+    return Json::JsonValue(std::move(obj));
 }
 
-static Json::JsonValue internalParseJson(const SubString& json) {
-    ValueMetaInfo valueInfo = findNextJsonValue(json);
-    SubString valueString = json.subView(valueInfo.startIndex, valueInfo.endIndex);
+struct NumberScan {
+    bool valid;
+    bool isDouble;
+    int intValue;
+    double doubleValue;
+    size_t end; // One past the last character of the number
+};
 
-    if (valueInfo.endIndex + 1 < json.length) {
-        // Check if there is anything after the value (outside of the value bounds) that isn't whitespace
-        size_t nextNonWS = findNextNonWSCharacter(json.subView(valueInfo.endIndex + 1));
-        if (nextNonWS != std::string::npos) {
-            throw Json::JsonMalformedException("Unexpected characters after json value");
+static inline bool isEightDigits(uint64_t chunk) noexcept {
+    return (((chunk & 0xF0F0F0F0F0F0F0F0ULL) | (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL);
+}
+
+static inline uint32_t parseEightDigits(uint64_t chunk) noexcept {
+    // SWAR conversion of eight little endian ascii digits, combines pairs, then quadruples, then both halves
+    chunk -= 0x3030303030303030ULL;
+    chunk = (chunk * 10) + (chunk >> 8);
+    chunk = (((chunk & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) + (((chunk >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+    return static_cast<uint32_t>(chunk);
+}
+
+static inline bool isLittleEndian() noexcept {
+    const uint16_t probe = 1;
+    unsigned char first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+static size_t consumeDigits(const SubString& json, size_t i, uint64_t& mantissa, int& digitCount) {
+    // Digits beyond 19 can not be held by the mantissa, they only count for the exponent
+    static const bool swarUsable = isLittleEndian();
+    while (swarUsable && i + 8 <= json.length && digitCount + 8 <= 19) {
+        uint64_t chunk;
+        std::memcpy(&chunk, json.data + i, 8);
+        if (!isEightDigits(chunk))
+            break;
+        mantissa = mantissa * 100000000ULL + parseEightDigits(chunk);
+        digitCount += 8;
+        i += 8;
+    }
+    while (i < json.length && isdigit(json[i])) {
+        if (digitCount < 19) {
+            mantissa = mantissa * 10 + static_cast<uint64_t>(json[i] - '0');
+        }
+        digitCount++;
+        i++;
+    }
+    return i;
+}
+
+static NumberScan scanNumber(const SubString& json, size_t start) {
+    // Same grammar as findNextJsonValue, anything unusual is reported invalid and left to the generic parser
+    static const double exactPowersOfTen[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    NumberScan result = { false, false, 0, 0.0, start };
+    size_t i = start;
+    bool negative = false;
+    if (i < json.length && json[i] == '-') {
+        negative = true;
+        i++;
+    }
+    if (i >= json.length || !isdigit(json[i]))
+        return result;
+    if (json[i] == '0' && i + 1 < json.length && isdigit(json[i + 1]))
+        return result;
+
+    uint64_t mantissa = 0;
+    int integerDigits = 0;
+    i = consumeDigits(json, i, mantissa, integerDigits);
+
+    int digitCount = integerDigits;
+    int fractionDigits = 0;
+    if (i < json.length && json[i] == '.') {
+        result.isDouble = true;
+        size_t fractionStart = ++i;
+        i = consumeDigits(json, i, mantissa, digitCount);
+        fractionDigits = static_cast<int>(i - fractionStart);
+        if (fractionDigits == 0)
+            return result;
+    }
+
+    int exponent = 0;
+    if (i < json.length && (json[i] == 'e' || json[i] == 'E')) {
+        result.isDouble = true;
+        i++;
+        bool negativeExponent = false;
+        if (i < json.length && (json[i] == '+' || json[i] == '-')) {
+            negativeExponent = json[i] == '-';
+            i++;
+        }
+        if (i >= json.length || !isdigit(json[i]))
+            return result;
+        while (i < json.length && isdigit(json[i])) {
+            if (exponent < 100000) {
+                exponent = exponent * 10 + (json[i] - '0');
+            }
+            i++;
+        }
+        if (negativeExponent) {
+            exponent = -exponent;
+        }
+    }
+    result.end = i;
+
+    if (!result.isDouble) {
+        // Out of range integers are left to the generic parser so they fail the same way
+        if (integerDigits > 10)
+            return result;
+        if (negative ? mantissa > static_cast<uint64_t>(INT_MAX) + 1 : mantissa > static_cast<uint64_t>(INT_MAX))
+            return result;
+        result.intValue = negative ? static_cast<int>(-static_cast<int64_t>(mantissa)) : static_cast<int>(mantissa);
+        result.valid = true;
+        return result;
+    }
+
+    // Clinger's fast path: both operands are exact doubles, so one rounding gives the correctly rounded result
+    int exponent10 = exponent - fractionDigits;
+    if (digitCount <= 19 && mantissa <= (1ULL << 53) && exponent10 >= -22 && exponent10 <= 22) {
+        double value = static_cast<double>(mantissa);
+        value = exponent10 < 0 ? value / exactPowersOfTen[-exponent10] : value * exactPowersOfTen[exponent10];
+        result.doubleValue = negative ? -value : value;
+        result.valid = true;
+        return result;
+    }
+
+    std::string text = subStrToString(json.subView(start, i - 1));
+    errno = 0;
+    double value = std::strtod(text.c_str(), nullptr);
+    if (errno == ERANGE)
+        return result;
+    result.doubleValue = value;
+    result.valid = true;
+    return result;
+}
+
+static bool parsePackedArray(const SubString& jsonArray, Json::JsonValue& out) {
+    // This method assumes the input is already cropped and guranteed to be a json array!
+    Json::Detail::Vector<int> ints;
+    Json::Detail::Vector<double> doubles;
+    Json::Detail::Vector<bool> integerMask;
+    bool sawDouble = false;
+
+    size_t index = findNextNonWSCharacter(jsonArray, 1);
+    if (index == jsonArray.length - 1)
+        return false; // Empty arrays stay regular
+
+    while (true) {
+        NumberScan number = scanNumber(jsonArray, index);
+        if (!number.valid)
+            return false;
+
+        if (number.isDouble && !sawDouble) {
+            // First double, everything so far moves to the double buffer
+            sawDouble = true;
+            doubles.assign(ints.begin(), ints.end());
+            integerMask.assign(ints.size(), true);
+            ints.clear();
+        }
+        if (sawDouble) {
+            doubles.push_back(number.isDouble ? number.doubleValue : static_cast<double>(number.intValue));
+            integerMask.push_back(!number.isDouble);
+        } else {
+            ints.push_back(number.intValue);
         }
+
+        size_t separator = findNextNonWSCharacter(jsonArray, number.end);
+        if (separator == std::string::npos)
+            return false;
+        if (jsonArray[separator] == JSONARRAY_ENDDELIMITER) {
+            if (separator != jsonArray.length - 1)
+                return false;
+            break;
+        }
+        if (jsonArray[separator] != JSONVALUE_DELIMITER)
+            return false;
+        index = findNextNonWSCharacter(jsonArray, separator + 1);
+        if (index == std::string::npos)
+            return false;
     }
 
-    switch (valueInfo.type) {
+    if (!sawDouble) {
+        out = Json::Detail::ValueAccess::makePacked(Json::Detail::createPayload<Json::Detail::PackedArray>(std::move(ints)));
+        return true;
+    }
+
+    bool mixed = false;
+    for (bool wasInteger : integerMask) {
+        mixed |= wasInteger;
+    }
+    if (!mixed) {
+        integerMask.clear();
+    }
+    out = Json::Detail::ValueAccess::makePacked(Json::Detail::createPayload<Json::Detail::PackedArray>(std::move(doubles), std::move(integerMask)));
+    return true;
+}
+
+static Json::JsonValue parseValue(const SubString& valueString, Json::JsonType type, ParseContext& ctx) {
+    switch (type) {
         case Json::JsonType::Bool: return Json::JsonValue(startsWith(valueString, JSON_BOOLTRUE_LITERAL));
         case Json::JsonType::Integer: return Json::JsonValue(std::stoi(subStrToString(valueString)));
         case Json::JsonType::Double: return Json::JsonValue(std::stod(subStrToString(valueString)));
@@ -448,37 +1544,442 @@ static Json::JsonValue internalParseJson(const SubString& json) {
             SubString str = valueString.subView(1, valueString.length - 2);
             return Json::JsonValue(parseJsonStringValue(str));
         }
-        case Json::JsonType::Object: return Json::JsonValue(deserializeObject(valueString));
-        case Json::JsonType::Array: return Json::JsonValue(deserializeArray(valueString));
+        case Json::JsonType::Object: return deserializeObject(valueString, ctx);
+        case Json::JsonType::Array: {
+            Json::JsonValue packed;
+            if (ctx.packNumbers && parsePackedArray(valueString, packed)) {
+                return packed;
+            }
+            return Json::JsonValue(deserializeArray(valueString, ctx));
+        }
         default: return Json::JsonValue(nullptr);
     }
 }
 
+static Json::JsonValue internalParseJson(const SubString& json, ParseContext& ctx) {
+    ValueMetaInfo valueInfo = findNextJsonValue(json);
+    SubString valueString = json.subView(valueInfo.startIndex, valueInfo.endIndex);
+
+    if (valueInfo.endIndex + 1 < json.length) {
+        // Check if there is anything after the value (outside of the value bounds) that isn't whitespace
+        size_t nextNonWS = findNextNonWSCharacter(json.subView(valueInfo.endIndex + 1));
+        if (nextNonWS != std::string::npos) {
+            throw Json::JsonMalformedException("Unexpected characters after json value");
+        }
+    }
+
+    Json::JsonValue value = parseValue(valueString, valueInfo.type, ctx);
+    if (ctx.usage) {
+        // Children were counted when they got parsed
+        ctx.usage->addShallow(value);
+    }
+    return value;
+}
+
+const Json::JsonValue& Json::JsonValue::resolved() const noexcept {
+    return hasLayout(Json::Detail::Layout::Shared) ? h_value->value : *this;
+}
+
 void Json::JsonValue::destroy() {
+    if (m_type == Json::JsonType::Object || m_type == Json::JsonType::Array) {
+        // Free nested containers from an explicit work list instead of recursing, deep trees cannot overflow the stack
+        std::vector<Json::JsonValue> pending;
+        collectNested(pending);
+        while (!pending.empty()) {
+            Json::JsonValue node = std::move(pending.back());
+            pending.pop_back();
+            node.collectNested(pending);
+        }
+    }
+
+    if (hasLayout(Json::Detail::Layout::Shared)) {
+        Json::Detail::SharedNode::release(h_value);
+        m_type = Json::JsonType::Null;
+        m_layout = Json::Detail::Layout::Default;
+        return;
+    }
+
     switch (m_type) { // Manual memory management for special cases
-        case Json::JsonType::String: delete s_value; break;
-        case Json::JsonType::Object: delete o_value; break;
-        case Json::JsonType::Array: delete a_value; break;
+        case Json::JsonType::String: Json::Detail::destroyPayload(s_value); break;
+        case Json::JsonType::Object:
+            if (hasLayout(Json::Detail::Layout::Shaped)) {
+                Json::Detail::destroyPayload(r_value);
+            } else {
+                Json::Detail::destroyPayload(o_value);
+            }
+            break;
+        case Json::JsonType::Array:
+            if (hasLayout(Json::Detail::Layout::Packed)) {
+                Json::Detail::destroyPayload(n_value);
+            } else {
+                Json::Detail::destroyPayload(a_value);
+            }
+            break;
         default: break;
     }
     m_type = Json::JsonType::Null;
+    m_layout = Json::Detail::Layout::Default;
+}
+
+void Json::JsonValue::collectNested(std::vector<Json::JsonValue>& pending) noexcept {
+    // Moves out children that own containers themselves, freeing this node afterwards no longer recurses
+    auto take = [&pending](Json::JsonValue& child) {
+        if ((child.m_type != Json::JsonType::Object && child.m_type != Json::JsonType::Array) || child.hasLayout(Json::Detail::Layout::Packed))
+            return;
+        try {
+            pending.push_back(std::move(child));
+        } catch (...) {
+            // Out of memory, this child gets freed recursively instead
+        }
+    };
+
+    if (hasLayout(Json::Detail::Layout::Shared)) {
+        // Only the last owner frees the content
+        if (h_value->refs.load(std::memory_order_acquire) == 1) {
+            take(h_value->value);
+        }
+        return;
+    }
+
+    if (m_type == Json::JsonType::Object) {
+        if (hasLayout(Json::Detail::Layout::Shaped)) {
+            for (Json::JsonValue& child : r_value->values) {
+                take(child);
+            }
+            Json::JsonObject* cached = r_value->materialized.exchange(nullptr, std::memory_order_acq_rel);
+            if (cached) {
+                for (auto& entry : *cached) {
+                    take(entry.second);
+                }
+                Json::Detail::destroyPayload(cached);
+            }
+        } else {
+            for (auto& entry : *o_value) {
+                take(entry.second);
+            }
+        }
+    } else if (m_type == Json::JsonType::Array && !hasLayout(Json::Detail::Layout::Packed)) {
+        for (Json::JsonValue& child : *a_value) {
+            take(child);
+        }
+    }
+}
+
+void Json::JsonValue::detach() {
+    if (!hasLayout(Json::Detail::Layout::Shared))
+        return;
+
+    // The sole owner may take the content, everyone else clones it. Children stay shared either way
+    Json::Detail::SharedNode* node = h_value;
+    Json::JsonValue inner = node->refs.load(std::memory_order_acquire) == 1
+        ? std::move(node->value)
+        : Json::JsonValue(node->value);
+    Json::Detail::SharedNode::release(node);
+
+    m_type = Json::JsonType::Null;
+    m_layout = Json::Detail::Layout::Default;
+    *this = std::move(inner);
+}
+
+void Json::JsonValue::share() {
+    if (hasLayout(Json::Detail::Layout::Shared))
+        return;
+
+    switch (m_type) {
+        case Json::JsonType::String: break;
+        case Json::JsonType::Object:
+            if (hasLayout(Json::Detail::Layout::Shaped)) {
+                for (Json::JsonValue& value : r_value->values) {
+                    value.share();
+                }
+            } else {
+                for (auto& entry : *o_value) {
+                    entry.second.share();
+                }
+            }
+            break;
+        case Json::JsonType::Array:
+            if (!hasLayout(Json::Detail::Layout::Packed)) {
+                for (Json::JsonValue& value : *a_value) {
+                    value.share();
+                }
+            }
+            break;
+        default: return; // Scalars are stored inline and always cheap to copy
+    }
+
+    Json::Detail::SharedNode* node = Json::Detail::createPayload<Json::Detail::SharedNode>(std::move(*this));
+    h_value = node;
+    m_type = node->value.m_type;
+    m_layout = Json::Detail::Layout::Shared;
+}
+
+bool Json::JsonValue::isShaped() const noexcept {
+    return resolved().hasLayout(Json::Detail::Layout::Shaped);
+}
+
+bool Json::JsonValue::isPacked() const noexcept {
+    return resolved().hasLayout(Json::Detail::Layout::Packed);
+}
+
+bool Json::JsonValue::pack() {
+    if (!isArray())
+        throw Json::JsonTypeException("Cannot pack non-array type");
+    if (isPacked())
+        return true;
+    detach();
+    if (a_value->empty())
+        return false;
+
+    bool integral = true;
+    bool mixed = false;
+    for (const Json::JsonValue& element : *a_value) {
+        if (!element.isInt() && !element.isDouble())
+            return false;
+        integral &= element.isInt();
+        mixed |= element.isInt();
+    }
+
+    Json::Detail::PackedArray* packed;
+    if (integral) {
+        Json::Detail::Vector<int> ints;
+        ints.reserve(a_value->size());
+        for (const Json::JsonValue& element : *a_value) {
+            ints.push_back(element.i_value);
+        }
+        packed = Json::Detail::createPayload<Json::Detail::PackedArray>(std::move(ints));
+    } else {
+        Json::Detail::Vector<double> doubles;
+        Json::Detail::Vector<bool> integerMask;
+        doubles.reserve(a_value->size());
+        for (const Json::JsonValue& element : *a_value) {
+            doubles.push_back(element.isInt() ? static_cast<double>(element.i_value) : element.d_value);
+            if (mixed) {
+                integerMask.push_back(element.isInt());
+            }
+        }
+        packed = Json::Detail::createPayload<Json::Detail::PackedArray>(std::move(doubles), std::move(integerMask));
+    }
+
+    Json::Detail::destroyPayload(a_value);
+    n_value = packed;
+    m_layout = Json::Detail::Layout::Packed;
+    return true;
+}
+
+Json::Span<double> Json::JsonValue::asDoubleSpan() const {
+    const Json::JsonValue& value = resolved();
+    if (!value.hasLayout(Json::Detail::Layout::Packed) || value.n_value->integral)
+        throw Json::JsonTypeException("Double span requires a packed array holding doubles");
+    return { value.n_value->doubles.data(), value.n_value->doubles.size() };
+}
+
+Json::Span<int> Json::JsonValue::asIntSpan() const {
+    const Json::JsonValue& value = resolved();
+    if (!value.hasLayout(Json::Detail::Layout::Packed) || !value.n_value->integral)
+        throw Json::JsonTypeException("Int span requires a packed array holding only integers");
+    return { value.n_value->ints.data(), value.n_value->ints.size() };
+}
+
+void Json::JsonValue::unpack() {
+    // Fallback to a regular array, keeps an array that was already handed out by const access
+    Json::Detail::PackedArray* packed = n_value;
+    Json::JsonArray* array = packed->materialized.exchange(nullptr, std::memory_order_acq_rel);
+    if (!array) {
+        Json::Detail::OwnerResourceScope owner(packed);
+        array = Json::Detail::createPayload<Json::JsonArray>(packed->unpacked());
+    }
+
+    Json::Detail::destroyPayload(packed);
+    a_value = array;
+    m_layout = Json::Detail::Layout::Default;
+}
+
+void Json::JsonValue::unshape() {
+    // Fallback to a regular object, keeps an object that was already handed out by const toObject()
+    Json::Detail::ShapedObject* shaped = r_value;
+    Json::JsonObject* object = shaped->materialized.exchange(nullptr, std::memory_order_acq_rel);
+    if (object) {
+        for (size_t i = 0; i < shaped->values.size(); i++) {
+            (*object)[shaped->shape->keys[i]] = std::move(shaped->values[i]);
+        }
+    } else {
+        Json::Detail::OwnerResourceScope owner(shaped);
+        object = Json::Detail::createPayload<Json::JsonObject>();
+        object->reserve(shaped->values.size());
+        for (size_t i = 0; i < shaped->values.size(); i++) {
+            object->emplace(shaped->shape->keys[i], std::move(shaped->values[i]));
+        }
+    }
+
+    Json::Detail::destroyPayload(shaped);
+    o_value = object;
+    m_layout = Json::Detail::Layout::Default;
+}
+
+const Json::JsonValue* Json::JsonValue::findMember(const std::string& key) const {
+    if (hasLayout(Json::Detail::Layout::Shared))
+        return h_value->value.findMember(key);
+    if (hasLayout(Json::Detail::Layout::Shaped)) {
+        size_t slot = r_value->shape->find(key);
+        return slot == std::string::npos ? nullptr : &r_value->values[slot];
+    }
+
+    auto it = o_value->find(key);
+    return it == o_value->end() ? nullptr : &it->second;
+}
+
+const Json::JsonValue* Json::JsonValue::findMember(const char* key, size_t length) const {
+    if (hasLayout(Json::Detail::Layout::Shared))
+        return h_value->value.findMember(key, length);
+    if (hasLayout(Json::Detail::Layout::Shaped)) {
+        size_t slot = r_value->shape->find(key, length);
+        return slot == std::string::npos ? nullptr : &r_value->values[slot];
+    }
+
+#ifdef __cpp_lib_generic_unordered_lookup
+    auto it = o_value->find(std::string_view(key, length));
+    return it == o_value->end() ? nullptr : &it->second;
+#else
+    return Json::Detail::findInBucket(*o_value, key, length, Json::hashKey(key, length));
+#endif
+}
+
+const Json::JsonValue* Json::JsonValue::findMember(const Json::Key& key) const {
+    if (hasLayout(Json::Detail::Layout::Shared))
+        return h_value->value.findMember(key);
+    if (hasLayout(Json::Detail::Layout::Shaped)) {
+        size_t slot = r_value->shape->find(key);
+        return slot == std::string::npos ? nullptr : &r_value->values[slot];
+    }
+
+#ifdef __cpp_lib_generic_unordered_lookup
+    auto it = o_value->find(key);
+    return it == o_value->end() ? nullptr : &it->second;
+#else
+    return Json::Detail::findInBucket(*o_value, key.name().data(), key.name().length(), key.hash());
+#endif
+}
+
+const Json::JsonValue* Json::JsonValue::find(const Json::Key& key) const {
+    return isObject() ? findMember(key) : nullptr;
+}
+
+const Json::JsonValue& Json::JsonValue::at(const Json::Key& key) const {
+    if (!isObject())
+        throw Json::JsonTypeException("Accessing key in non-object type");
+    const Json::JsonValue* member = findMember(key);
+    if (!member)
+        throw std::out_of_range("Key not found in json object");
+    return *member;
+}
+
+Json::JsonValue& Json::JsonValue::at(const Json::Key& key) {
+    if (!isObject())
+        throw Json::JsonTypeException("Accessing key in non-object type");
+    detach();
+    if (hasLayout(Json::Detail::Layout::Shaped) && r_value->materialized.load(std::memory_order_acquire))
+        unshape(); // Writes must go to the object const toObject() handed out
+    const Json::JsonValue* member = findMember(key);
+    if (!member)
+        throw std::out_of_range("Key not found in json object");
+    return const_cast<Json::JsonValue&>(*member);
+}
+
+const Json::JsonValue& Json::JsonValue::operator[](const Json::Key& key) const {
+    return at(key);
+}
+
+Json::JsonValue& Json::JsonValue::operator[](const Json::Key& key) {
+    if (!isObject())
+        throw Json::JsonTypeException("Accessing key in non-object type");
+    detach();
+    if (hasLayout(Json::Detail::Layout::Shaped)) {
+        size_t slot = r_value->shape->find(key);
+        if (slot != std::string::npos && !r_value->materialized.load(std::memory_order_acquire))
+            return r_value->values[slot];
+        unshape(); // Inserting a new key diverges from the shape
+    }
+
+    const Json::JsonValue* member = findMember(key);
+    if (member)
+        return const_cast<Json::JsonValue&>(*member);
+    return o_value->emplace(key.name(), Json::JsonValue()).first->second;
+}
+
+const Json::JsonValue& Json::JsonValue::atKey(const char* key, size_t length) const {
+    if (!isObject())
+        throw Json::JsonTypeException("Accessing key in non-object type");
+    const Json::JsonValue* member = findMember(key, length);
+    if (!member)
+        throw std::out_of_range("Key not found in json object");
+    return *member;
+}
+
+Json::JsonValue& Json::JsonValue::atKey(const char* key, size_t length) {
+    if (!isObject())
+        throw Json::JsonTypeException("Accessing key in non-object type");
+    detach();
+    if (hasLayout(Json::Detail::Layout::Shaped) && r_value->materialized.load(std::memory_order_acquire))
+        unshape(); // Writes must go to the object const toObject() handed out
+    const Json::JsonValue* member = findMember(key, length);
+    if (!member)
+        throw std::out_of_range("Key not found in json object");
+    return const_cast<Json::JsonValue&>(*member);
+}
+
+Json::JsonValue& Json::JsonValue::subscriptKey(const char* key, size_t length) {
+    if (!isObject())
+        throw Json::JsonTypeException("Accessing key in non-object type");
+    detach();
+    if (hasLayout(Json::Detail::Layout::Shaped)) {
+        size_t slot = r_value->shape->find(key, length);
+        if (slot != std::string::npos && !r_value->materialized.load(std::memory_order_acquire))
+            return r_value->values[slot];
+        unshape(); // Inserting a new key diverges from the shape
+    }
+
+    const Json::JsonValue* member = findMember(key, length);
+    if (member)
+        return const_cast<Json::JsonValue&>(*member);
+    return o_value->emplace(std::string(key, length), Json::JsonValue()).first->second;
 }
 
 Json::JsonValue::JsonValue(const Json::JsonValue& other) {
     m_type = other.m_type;
+    m_layout = other.m_layout;
+    if (other.hasLayout(Json::Detail::Layout::Shared)) {
+        h_value = other.h_value;
+        h_value->refs.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
     switch (m_type) {
         case Json::JsonType::Bool: b_value = other.b_value; break;
         case Json::JsonType::Integer: i_value = other.i_value; break;
         case Json::JsonType::Double: d_value = other.d_value; break;
-        case Json::JsonType::String: s_value = new std::string(*other.s_value); break;
-        case Json::JsonType::Object: o_value = new Json::JsonObject(*other.o_value); break;
-        case Json::JsonType::Array: a_value = new Json::JsonArray(*other.a_value); break;
+        case Json::JsonType::String: s_value = Json::Detail::createPayload<std::string>(*other.s_value); break;
+        case Json::JsonType::Object:
+            if (other.hasLayout(Json::Detail::Layout::Shaped)) {
+                r_value = Json::Detail::createPayload<Json::Detail::ShapedObject>(*other.r_value);
+            } else {
+                o_value = Json::Detail::createPayload<Json::JsonObject>(*other.o_value);
+            }
+            break;
+        case Json::JsonType::Array:
+            if (other.hasLayout(Json::Detail::Layout::Packed)) {
+                n_value = Json::Detail::createPayload<Json::Detail::PackedArray>(*other.n_value);
+            } else {
+                a_value = Json::Detail::createPayload<Json::JsonArray>(*other.a_value);
+            }
+            break;
         default: break;
     }
 }
 
 Json::JsonValue::JsonValue(Json::JsonValue&& other) noexcept {
     m_type = other.m_type;
+    m_layout = other.m_layout;
     switch (m_type) {
         case Json::JsonType::Bool: b_value = other.b_value; break;
         case Json::JsonType::Integer: i_value = other.i_value; break;
@@ -490,14 +1991,23 @@ Json::JsonValue::JsonValue(Json::JsonValue&& other) noexcept {
     }
 
     other.m_type = Json::JsonType::Null;
+    other.m_layout = Json::Detail::Layout::Default;
 }
 
 bool Json::JsonValue::isEmpty() const {
-    if (isObject()) return o_value->empty();
-    if (isArray()) return a_value->empty();
+    if (hasLayout(Json::Detail::Layout::Shared)) return h_value->value.isEmpty();
+    if (isObject()) return hasLayout(Json::Detail::Layout::Shaped) ? r_value->values.empty() : o_value->empty();
+    if (isArray()) return hasLayout(Json::Detail::Layout::Packed) ? n_value->size() == 0 : a_value->empty();
     throw Json::JsonTypeException("Cannot check emptiness for non-object/array types");
 }
 
+size_t Json::JsonValue::size() const {
+    if (hasLayout(Json::Detail::Layout::Shared)) return h_value->value.size();
+    if (isObject()) return hasLayout(Json::Detail::Layout::Shaped) ? r_value->values.size() : o_value->size();
+    if (isArray()) return hasLayout(Json::Detail::Layout::Packed) ? n_value->size() : a_value->size();
+    throw Json::JsonTypeException("Cannot get the size of non-object/array types");
+}
+
 bool Json::JsonValue::toBool() const {
     if (!isBool())
         throw Json::JsonTypeException("Cannot cast to C++ BOOL because underlying type is " + jsonTypeToString(m_type));
@@ -519,98 +2029,336 @@ double Json::JsonValue::toDouble() const {
 const std::string& Json::JsonValue::toString() const {
     if (!isString())
         throw Json::JsonTypeException("Cannot cast to C++ STRING because the underlying type is " + jsonTypeToString(m_type));
+    if (hasLayout(Json::Detail::Layout::Shared))
+        return h_value->value.toString();
     return *s_value;
 }
 
 const Json::JsonObject& Json::JsonValue::toObject() const {
     if (!isObject())
         throw Json::JsonTypeException("Cannot cast to C++ OBJECT because the underlying type is " + jsonTypeToString(m_type));
+    if (hasLayout(Json::Detail::Layout::Shared))
+        return h_value->value.toObject();
+    if (hasLayout(Json::Detail::Layout::Shaped))
+        return r_value->materialize();
     return *o_value;
 }
 
+bool Json::JsonValue::forEachMember(const std::function<bool(const std::string& key, const Json::JsonValue& value)>& visit) const {
+    if (!isObject())
+        throw Json::JsonTypeException("Cannot visit members because the underlying type is " + jsonTypeToString(m_type));
+    const Json::JsonValue& value = resolved();
+    if (value.hasLayout(Json::Detail::Layout::Shaped)) {
+        const Json::Detail::ShapedObject& record = *value.r_value;
+        for (size_t i = 0; i < record.values.size(); i++) {
+            if (!visit(record.shape->keys[i], record.values[i]))
+                return false;
+        }
+        return true;
+    }
+    for (const auto& entry : *value.o_value) {
+        if (!visit(entry.first, entry.second))
+            return false;
+    }
+    return true;
+}
+
+bool Json::JsonValue::forEachElement(const std::function<bool(size_t index, const Json::JsonValue& value)>& visit) const {
+    if (!isArray())
+        throw Json::JsonTypeException("Cannot visit elements because the underlying type is " + jsonTypeToString(m_type));
+    const Json::JsonValue& value = resolved();
+    if (value.hasLayout(Json::Detail::Layout::Packed)) {
+        const Json::Detail::PackedArray& packed = *value.n_value;
+        for (size_t i = 0; i < packed.size(); i++) {
+            if (!visit(i, packed.element(i)))
+                return false;
+        }
+        return true;
+    }
+    for (size_t i = 0; i < value.a_value->size(); i++) {
+        if (!visit(i, (*value.a_value)[i]))
+            return false;
+    }
+    return true;
+}
+
 const Json::JsonArray& Json::JsonValue::toArray() const {
     if (!isArray())
         throw Json::JsonTypeException("Cannot cast to C++ ARRAY because the underlying type is " + jsonTypeToString(m_type));
+    if (hasLayout(Json::Detail::Layout::Shared))
+        return h_value->value.toArray();
+    if (hasLayout(Json::Detail::Layout::Packed))
+        return n_value->materialize();
     return *a_value;
 }
 
 std::string& Json::JsonValue::toString() {
     if (!isString())
         throw Json::JsonTypeException("Cannot cast to C++ STRING because the underlying type is " + jsonTypeToString(m_type));
+    detach();
     return *s_value;
 }
 
 Json::JsonObject& Json::JsonValue::toObject() {
     if (!isObject())
         throw Json::JsonTypeException("Cannot cast to C++ OBJECT because the underlying type is " + jsonTypeToString(m_type));
+    detach();
+    if (hasLayout(Json::Detail::Layout::Shaped))
+        unshape();
     return *o_value;
 }
 
 Json::JsonArray& Json::JsonValue::toArray() {
     if (!isArray())
         throw Json::JsonTypeException("Cannot cast to C++ ARRAY because the underlying type is " + jsonTypeToString(m_type));
+    detach();
+    if (hasLayout(Json::Detail::Layout::Packed))
+        unpack();
     return *a_value;
 }
 
 const Json::JsonValue &Json::JsonValue::at(const std::string& key) const {
     if (!isObject())
         throw Json::JsonTypeException("Accessing key in non-object type");
-    return static_cast<const Json::JsonObject*>(o_value)->at(key);
+    const Json::JsonValue* member = findMember(key);
+    if (!member)
+        throw std::out_of_range("Key not found in json object");
+    return *member;
 }
 
 const Json::JsonValue& Json::JsonValue::at(size_t index) const {
     if (!isArray())
         throw Json::JsonTypeException("Accessing index in non-array type");
+    if (hasLayout(Json::Detail::Layout::Shared))
+        return h_value->value.at(index);
+    if (hasLayout(Json::Detail::Layout::Packed))
+        return n_value->materialize().at(index);
     return static_cast<const Json::JsonArray*>(a_value)->at(index);
 }
 
 Json::JsonValue& Json::JsonValue::at(const std::string& key) {
     if (!isObject())
         throw Json::JsonTypeException("Accessing key in non-object type");
-    return o_value->at(key);
+    detach();
+    if (hasLayout(Json::Detail::Layout::Shaped) && r_value->materialized.load(std::memory_order_acquire))
+        unshape(); // Writes must go to the object const toObject() handed out
+    const Json::JsonValue* member = findMember(key);
+    if (!member)
+        throw std::out_of_range("Key not found in json object");
+    return const_cast<Json::JsonValue&>(*member);
 }
 
 Json::JsonValue& Json::JsonValue::at(size_t index) {
     if (!isArray())
         throw Json::JsonTypeException("Accessing index in non-array type");
+    detach();
+    if (hasLayout(Json::Detail::Layout::Packed))
+        unpack();
     return a_value->at(index);
 }
 
 const Json::JsonValue& Json::JsonValue::operator[](const std::string& key) const {
-    if (!isObject())
-        throw Json::JsonTypeException("Accessing key in non-object type");
-    return static_cast<const Json::JsonObject*>(o_value)->at(key);
+    return at(key);
 }
 
 const Json::JsonValue& Json::JsonValue::operator[](size_t index) const {
     if (!isArray())
         throw Json::JsonTypeException("Accessing index in non-array type");
+    if (hasLayout(Json::Detail::Layout::Shared))
+        return h_value->value[index];
+    if (hasLayout(Json::Detail::Layout::Packed))
+        return n_value->materialize()[index];
     return static_cast<const Json::JsonArray&>(*a_value)[index];
 }
 
 Json::JsonValue& Json::JsonValue::operator[](const std::string& key) {
     if (!isObject())
         throw Json::JsonTypeException("Accessing key in non-object type");
+    detach();
+    if (hasLayout(Json::Detail::Layout::Shaped)) {
+        size_t slot = r_value->shape->find(key);
+        if (slot != std::string::npos && !r_value->materialized.load(std::memory_order_acquire))
+            return r_value->values[slot];
+        unshape(); // Inserting a new key diverges from the shape
+    }
     return (*o_value)[key];
 }
 
 Json::JsonValue& Json::JsonValue::operator[](size_t index) {
     if (!isArray())
         throw Json::JsonTypeException("Accessing index in non-array type");
+    detach();
+    if (hasLayout(Json::Detail::Layout::Packed))
+        unpack();
     return (*a_value)[index];
 }
 
+// Finalizer of splitmix64
+static inline uint64_t mixHash(uint64_t h) noexcept {
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+static inline uint64_t combineHash(uint64_t seed, uint64_t h) noexcept {
+    return mixHash(seed ^ (h + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+}
+
+static inline uint64_t hashTag(Json::JsonType type) noexcept {
+    return mixHash(static_cast<uint64_t>(type) + 1);
+}
+
+static inline uint64_t hashBytes(const char* data, size_t length) noexcept {
+    uint64_t h = 14695981039346656037ULL; // 64 bit FNV-1a
+    for (size_t i = 0; i < length; i++) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static inline uint64_t hashInt(int value) noexcept {
+    return combineHash(hashTag(Json::JsonType::Integer), static_cast<uint64_t>(static_cast<int64_t>(value)));
+}
+
+static inline uint64_t hashDouble(double value) noexcept {
+    if (value == 0.0)
+        value = 0.0; // -0.0 compares equal to 0.0
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return combineHash(hashTag(Json::JsonType::Double), bits);
+}
+
+static inline uint64_t hashMember(const std::string& key, uint64_t valueHash) noexcept {
+    // Members are summed up, so the per member hash has to be well mixed on its own
+    return mixHash(combineHash(hashBytes(key.data(), key.length()), valueHash));
+}
+
+uint64_t Json::JsonValue::hash() const {
+    uint64_t h;
+    switch (m_type) {
+        case Json::JsonType::Bool: return combineHash(hashTag(m_type), b_value ? 1 : 0);
+        case Json::JsonType::Integer: return hashInt(i_value);
+        case Json::JsonType::Double: return hashDouble(d_value);
+        case Json::JsonType::Null: return hashTag(m_type);
+        default: break;
+    }
+
+    if (hasLayout(Json::Detail::Layout::Shared)) {
+        h = h_value->hash.load(std::memory_order_acquire);
+        if (h == 0) {
+            h = h_value->value.hash();
+            h_value->hash.store(h, std::memory_order_release);
+        }
+        return h;
+    }
+
+    if (m_type == Json::JsonType::String) {
+        h = combineHash(hashTag(m_type), hashBytes(s_value->data(), s_value->length()));
+    } else if (m_type == Json::JsonType::Object) {
+        // Order independent: sum of member hashes
+        uint64_t sum = 0;
+        size_t count;
+        if (hasLayout(Json::Detail::Layout::Shaped)) {
+            const Json::Detail::ShapedObject& record = *r_value;
+            count = record.values.size();
+            for (size_t i = 0; i < count; i++) {
+                sum += hashMember(record.shape->keys[i], record.values[i].hash());
+            }
+        } else {
+            count = o_value->size();
+            for (const auto& entry : *o_value) {
+                sum += hashMember(entry.first, entry.second.hash());
+            }
+        }
+        h = combineHash(combineHash(hashTag(m_type), count), sum);
+    } else {
+        h = hashTag(m_type);
+        size_t count;
+        if (hasLayout(Json::Detail::Layout::Packed)) {
+            const Json::Detail::PackedArray& numbers = *n_value;
+            count = numbers.size();
+            for (size_t i = 0; i < numbers.size(); i++) {
+                if (numbers.integral) {
+                    h = combineHash(h, hashInt(numbers.ints[i]));
+                } else if (!numbers.integerMask.empty() && numbers.integerMask[i]) {
+                    h = combineHash(h, hashInt(static_cast<int>(numbers.doubles[i])));
+                } else {
+                    h = combineHash(h, hashDouble(numbers.doubles[i]));
+                }
+            }
+        } else {
+            count = a_value->size();
+            for (const Json::JsonValue& element : *a_value) {
+                h = combineHash(h, element.hash());
+            }
+        }
+        h = combineHash(h, count);
+    }
+    return h == 0 ? 1 : h; // 0 marks an uncached hash on shared nodes
+}
+
 bool Json::JsonValue::operator==(const Json::JsonValue& other) const {
     if (m_type != other.m_type)
         return false;
+    if (hasLayout(Json::Detail::Layout::Shared) || other.hasLayout(Json::Detail::Layout::Shared)) {
+        if (hasLayout(Json::Detail::Layout::Shared) && other.hasLayout(Json::Detail::Layout::Shared)) {
+            if (h_value == other.h_value)
+                return true;
+            // Both sides are immutable, differing cached hashes settle inequality without a walk
+            if (hash() != other.hash())
+                return false;
+        }
+        return resolved() == other.resolved();
+    }
 
     switch (m_type) {
         case Json::JsonType::Bool: return b_value == other.b_value;
         case Json::JsonType::Integer: return i_value == other.i_value;
         case Json::JsonType::Double: return d_value == other.d_value;
         case Json::JsonType::String: return *s_value == *other.s_value;
-        case Json::JsonType::Object: return *o_value == *other.o_value;
-        case Json::JsonType::Array: return *a_value == *other.a_value;
+        case Json::JsonType::Object: {
+            if (!hasLayout(Json::Detail::Layout::Shaped) && !other.hasLayout(Json::Detail::Layout::Shaped))
+                return *o_value == *other.o_value;
+            if (hasLayout(Json::Detail::Layout::Shaped) && other.hasLayout(Json::Detail::Layout::Shaped) && r_value->shape == other.r_value->shape)
+                return r_value->values == other.r_value->values;
+
+            // Mixed layouts, compare member wise without materializing either side
+            const Json::JsonValue& shaped = hasLayout(Json::Detail::Layout::Shaped) ? *this : other;
+            const Json::JsonValue& counterpart = hasLayout(Json::Detail::Layout::Shaped) ? other : *this;
+            const Json::Detail::ShapedObject& record = *shaped.r_value;
+            size_t counterpartSize = counterpart.hasLayout(Json::Detail::Layout::Shaped) ? counterpart.r_value->values.size() : counterpart.o_value->size();
+            if (record.values.size() != counterpartSize)
+                return false;
+            for (size_t i = 0; i < record.values.size(); i++) {
+                const Json::JsonValue* member = counterpart.findMember(record.shape->keys[i]);
+                if (!member || *member != record.values[i])
+                    return false;
+            }
+            return true;
+        }
+        case Json::JsonType::Array: {
+            bool packed = hasLayout(Json::Detail::Layout::Packed);
+            bool otherPacked = other.hasLayout(Json::Detail::Layout::Packed);
+            if (!packed && !otherPacked)
+                return *a_value == *other.a_value;
+            if (packed && otherPacked)
+                return *n_value == *other.n_value;
+
+            // Mixed layouts, compare element wise without materializing the packed side
+            const Json::Detail::PackedArray& numbers = packed ? *n_value : *other.n_value;
+            const Json::JsonArray& array = packed ? *other.a_value : *a_value;
+            if (numbers.size() != array.size())
+                return false;
+            for (size_t i = 0; i < array.size(); i++) {
+                if (numbers.element(i) != array[i])
+                    return false;
+            }
+            return true;
+        }
         case Json::JsonType::Null: return true;
         default: return false;
     }
@@ -643,28 +2391,28 @@ Json::JsonValue& Json::JsonValue::operator=(double value) noexcept {
 
 Json::JsonValue& Json::JsonValue::operator=(const char* value) {
     destroy();
-    s_value = new std::string(value);
+    s_value = Json::Detail::createPayload<std::string>(value);
     m_type = Json::JsonType::String;
     return *this;
 }
 
 Json::JsonValue& Json::JsonValue::operator=(const std::string& value) {
     destroy();
-    s_value = new std::string(value);
+    s_value = Json::Detail::createPayload<std::string>(value);
     m_type = Json::JsonType::String;
     return *this;
 }
 
 Json::JsonValue& Json::JsonValue::operator=(const Json::JsonObject& value) {
     destroy();
-    o_value = new Json::JsonObject(value);
+    o_value = Json::Detail::createPayload<Json::JsonObject>(value);
     m_type = Json::JsonType::Object;
     return *this;
 }
 
 Json::JsonValue& Json::JsonValue::operator=(const Json::JsonArray& value) {
     destroy();
-    a_value = new Json::JsonArray(value);
+    a_value = Json::Detail::createPayload<Json::JsonArray>(value);
     m_type = Json::JsonType::Array;
     return *this;
 }
@@ -674,48 +2422,69 @@ Json::JsonValue& Json::JsonValue::operator=(const Json::JsonValue& other) {
 
     destroy();
 
+    if (other.hasLayout(Json::Detail::Layout::Shared)) {
+        h_value = other.h_value;
+        h_value->refs.fetch_add(1, std::memory_order_relaxed);
+        m_type = other.m_type;
+        m_layout = other.m_layout;
+        return *this;
+    }
+
     switch (other.m_type) {
         case JsonType::Bool: b_value = other.b_value; break;
         case JsonType::Integer: i_value = other.i_value; break;
         case JsonType::Double: d_value = other.d_value; break;
-        case Json::JsonType::String: s_value = new std::string(*other.s_value); break;
-        case Json::JsonType::Object: o_value = new Json::JsonObject(*other.o_value); break;
-        case Json::JsonType::Array: a_value = new Json::JsonArray(*other.a_value); break;
+        case Json::JsonType::String: s_value = Json::Detail::createPayload<std::string>(*other.s_value); break;
+        case Json::JsonType::Object:
+            if (other.hasLayout(Json::Detail::Layout::Shaped)) {
+                r_value = Json::Detail::createPayload<Json::Detail::ShapedObject>(*other.r_value);
+            } else {
+                o_value = Json::Detail::createPayload<Json::JsonObject>(*other.o_value);
+            }
+            break;
+        case Json::JsonType::Array:
+            if (other.hasLayout(Json::Detail::Layout::Packed)) {
+                n_value = Json::Detail::createPayload<Json::Detail::PackedArray>(*other.n_value);
+            } else {
+                a_value = Json::Detail::createPayload<Json::JsonArray>(*other.a_value);
+            }
+            break;
         default: break;
     }
 
     m_type = other.m_type;
+    m_layout = other.m_layout;
     return *this;
 }
 
 Json::JsonValue& Json::JsonValue::operator=(std::string&& value) {
-    if (isString()) {
+    if (isString() && hasLayout(Json::Detail::Layout::Default)) {
         *s_value = std::move(value);
     } else {
         destroy();
-        s_value = new std::string(std::move(value));
+        s_value = Json::Detail::createPayload<std::string>(std::move(value));
         m_type = JsonType::String;
     }
     return *this;
 }
 
 Json::JsonValue& Json::JsonValue::operator=(Json::JsonObject&& value) {
-    if (isObject()) {
+    if (isObject() && hasLayout(Json::Detail::Layout::Default)) {
         *o_value = std::move(value);
     } else {
         destroy();
-        o_value = new JsonObject(std::move(value));
+        o_value = Json::Detail::createPayload<JsonObject>(std::move(value));
         m_type = JsonType::Object;
     }
     return *this;
 }
 
 Json::JsonValue& Json::JsonValue::operator=(Json::JsonArray&& value) {
-    if (isArray()) {
+    if (isArray() && hasLayout(Json::Detail::Layout::Default)) {
         *a_value = std::move(value);
     } else {
         destroy();
-        a_value = new JsonArray(std::move(value));
+        a_value = Json::Detail::createPayload<JsonArray>(std::move(value));
         m_type = JsonType::Array;
     }
     return *this;
@@ -737,7 +2506,9 @@ Json::JsonValue& Json::JsonValue::operator=(Json::JsonValue&& other) noexcept {
     }
 
     m_type = other.m_type;
+    m_layout = other.m_layout;
     other.m_type = Json::JsonType::Null;
+    other.m_layout = Json::Detail::Layout::Default;
     return *this;
 }
 
@@ -748,29 +2519,577 @@ Json::JsonValue& Json::JsonValue::operator=(std::nullptr_t) noexcept {
 }
 
 std::ostream& Json::operator<<(std::ostream& os, const JsonValue& value) {
-    os << Json::toJsonString(value);
+    try {
+        writeJson(value, os, 4096);
+    } catch (const Json::JsonWriteException&) {
+        // The stream state already reports the failure
+    }
     return os;
 }
 
 std::string Json::toJsonString(const Json::JsonValue& value) {
+    return toJsonString(value, WriteOptions());
+}
+
+std::string Json::toJsonString(const Json::JsonValue& value, const WriteOptions& options) {
+    std::string result;
+    toJsonString(value, result, options);
+    return result;
+}
+
+void Json::toJsonString(const Json::JsonValue& value, std::string& out, bool reserveExact) {
+    toJsonString(value, out, WriteOptions(), reserveExact);
+}
+
+void Json::toJsonString(const Json::JsonValue& value, std::string& out, const WriteOptions& options, bool reserveExact) {
+    if (reserveExact) {
+        out.reserve(out.size() + serializedSize(value, options));
+    }
+    Json::Detail::StringOutput output(out);
+    Json::Detail::ValueAccess::serialize(value, output, options, 0, true);
+}
+
+namespace {
+
+class FileSink : public Json::Detail::OutputSink {
+private:
+    std::FILE* m_file;
+
+public:
+    explicit FileSink(std::FILE* file) noexcept : m_file(file) {}
+
+    void write(const char* data, size_t length) override {
+        if (std::fwrite(data, 1, length, m_file) != length)
+            throw Json::JsonWriteException("Failed to write json to file");
+    }
+    using OutputSink::write;
+};
+
+#ifdef JSONPARSER_HAS_POSIX_IO
+class FdSink : public Json::Detail::OutputSink {
+private:
+    int m_fd;
+
+    void writeAll(struct iovec* parts, int count) {
+        while (count > 0) {
+            ssize_t written = ::writev(m_fd, parts, count);
+            if (written < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw Json::JsonWriteException(std::string("Failed to write json to file descriptor: ") + std::strerror(errno));
+            }
+
+            // Skip what got written, a partial write may end within a part
+            size_t remaining = static_cast<size_t>(written);
+            while (count > 0 && remaining >= parts->iov_len) {
+                remaining -= parts->iov_len;
+                parts++;
+                count--;
+            }
+            if (count > 0) {
+                parts->iov_base = static_cast<char*>(parts->iov_base) + remaining;
+                parts->iov_len -= remaining;
+            }
+        }
+    }
+
+public:
+    explicit FdSink(int fd) noexcept : m_fd(fd) {}
+
+    void write(const char* data, size_t length) override {
+        struct iovec part = { const_cast<char*>(data), length };
+        writeAll(&part, 1);
+    }
+
+    void write(const char* first, size_t firstLength, const char* second, size_t secondLength) override {
+        struct iovec parts[2] = { { const_cast<char*>(first), firstLength }, { const_cast<char*>(second), secondLength } };
+        writeAll(firstLength > 0 ? parts : parts + 1, firstLength > 0 ? 2 : 1);
+    }
+
+    void writeChunks(const std::string* chunks, size_t count) override {
+        struct iovec parts[64];
+        while (count > 0) {
+            int batch = static_cast<int>(count < 64 ? count : 64);
+            for (int i = 0; i < batch; i++) {
+                parts[i].iov_base = const_cast<char*>(chunks[i].data());
+                parts[i].iov_len = chunks[i].size();
+            }
+            writeAll(parts, batch);
+            chunks += batch;
+            count -= batch;
+        }
+    }
+};
+#endif
+
+} // namespace
+
+void Json::Detail::serializeValue(const JsonValue& value, StringOutput& out, const WriteOptions& options, size_t depth) {
+    ValueAccess::serialize(value, out, options, depth, true);
+}
+
+void Json::Detail::serializeValue(const JsonValue& value, BufferedOutput& out, const WriteOptions& options, size_t depth) {
+    ValueAccess::serialize(value, out, options, depth, true);
+}
+
+void Json::Detail::ValueAccess::visit(const JsonValue& value, ValueVisitor& visitor) {
+    if (value.hasLayout(Layout::Shared)) {
+        visit(value.h_value->value, visitor);
+        return;
+    }
     switch (value.m_type) {
-        case Json::JsonType::Bool: return (value.b_value ? JSON_BOOLTRUE_LITERAL : JSON_BOOLFALSE_LITERAL);
-        case Json::JsonType::Integer: return std::to_string(value.i_value);
-        case Json::JsonType::Double: {
-            // ostringstream formats so that no wasted trailing zeros are appended
-            std::ostringstream ostr;
-            ostr << value.d_value;
-            return ostr.str();
+        case JsonType::Bool: visitor.boolean(value.b_value); break;
+        case JsonType::Integer: visitor.integer(value.i_value); break;
+        case JsonType::Double: visitor.number(value.d_value); break;
+        case JsonType::String: visitor.string(*value.s_value); break;
+        case JsonType::Object:
+            if (value.hasLayout(Layout::Shaped)) {
+                const ShapedObject& object = *value.r_value;
+                visitor.beginObject(object.values.size());
+                for (size_t i = 0; i < object.values.size(); i++) {
+                    visitor.key(object.shape->keys[i]);
+                    visit(object.values[i], visitor);
+                }
+            } else {
+                visitor.beginObject(value.o_value->size());
+                for (const auto& entry : *value.o_value) {
+                    visitor.key(entry.first);
+                    visit(entry.second, visitor);
+                }
+            }
+            visitor.endObject();
+            break;
+        case JsonType::Array:
+            if (value.hasLayout(Layout::Packed)) {
+                const PackedArray& array = *value.n_value;
+                visitor.beginArray(array.size());
+                for (size_t i = 0; i < array.size(); i++) {
+                    if (packedElementIsInt(array, i)) {
+                        visitor.integer(array.integral ? array.ints[i] : static_cast<int>(array.doubles[i]));
+                    } else {
+                        visitor.number(array.doubles[i]);
+                    }
+                }
+            } else {
+                visitor.beginArray(value.a_value->size());
+                for (const JsonValue& element : *value.a_value) {
+                    visit(element, visitor);
+                }
+            }
+            visitor.endArray();
+            break;
+        case JsonType::Null: visitor.null(); break;
+        default: break;
+    }
+}
+
+void Json::Detail::visitValue(const JsonValue& value, ValueVisitor& visitor) {
+    ValueAccess::visit(value, visitor);
+}
+
+static void streamJson(const Json::JsonValue& value, Json::Detail::OutputSink& sink, const Json::WriteOptions& options, size_t bufferSize) {
+    // Small buffers live on the stack, operator<< then needs no allocation at all
+    char stackBuffer[4096];
+    std::vector<char> heapBuffer;
+    char* buffer = stackBuffer;
+    if (bufferSize == 0) {
+        bufferSize = 1;
+    } else if (bufferSize > sizeof(stackBuffer)) {
+        heapBuffer.resize(bufferSize);
+        buffer = heapBuffer.data();
+    }
+
+    Json::Detail::BufferedOutput output(sink, buffer, bufferSize);
+    Json::Detail::ValueAccess::serialize(value, output, options, 0, true);
+    output.flush();
+}
+
+void Json::writeJson(const JsonValue& value, std::ostream& os, size_t bufferSize) {
+    writeJson(value, os, WriteOptions(), bufferSize);
+}
+
+void Json::writeJson(const JsonValue& value, std::FILE* file, size_t bufferSize) {
+    writeJson(value, file, WriteOptions(), bufferSize);
+}
+
+void Json::writeJson(const JsonValue& value, const WriteCallback& callback, size_t bufferSize) {
+    writeJson(value, callback, WriteOptions(), bufferSize);
+}
+
+void Json::writeJson(const JsonValue& value, std::ostream& os, const WriteOptions& options, size_t bufferSize) {
+    Json::Detail::StreamSink sink(os);
+    streamJson(value, sink, options, bufferSize);
+}
+
+void Json::writeJson(const JsonValue& value, std::FILE* file, const WriteOptions& options, size_t bufferSize) {
+    FileSink sink(file);
+    streamJson(value, sink, options, bufferSize);
+}
+
+void Json::writeJson(const JsonValue& value, const WriteCallback& callback, const WriteOptions& options, size_t bufferSize) {
+    Json::Detail::CallbackSink sink(callback);
+    streamJson(value, sink, options, bufferSize);
+}
+
+#ifdef JSONPARSER_HAS_POSIX_IO
+void Json::writeJsonToFd(const JsonValue& value, int fd, size_t bufferSize) {
+    writeJsonToFd(value, fd, WriteOptions(), bufferSize);
+}
+
+void Json::writeJsonToFd(const JsonValue& value, int fd, const WriteOptions& options, size_t bufferSize) {
+    FdSink sink(fd);
+    streamJson(value, sink, options, bufferSize);
+}
+#endif
+
+size_t Json::serializedSize(const Json::JsonValue& value) {
+    return serializedSize(value, WriteOptions());
+}
+
+size_t Json::serializedSize(const Json::JsonValue& value, const WriteOptions& options) {
+    if (Json::Detail::isPretty(options) || Json::Detail::hasSpaceAfterColon(options)) {
+        // Whitespace depends on the layout decisions, measure the real output instead of mirroring them
+        Json::Detail::CountingOutput counter;
+        Json::Detail::ValueAccess::serialize(value, counter, options, 0, true);
+        return counter.count;
+    }
+    if (value.hasLayout(Json::Detail::Layout::Shared))
+        return serializedSize(value.h_value->value, options);
+    switch (value.m_type) {
+        case Json::JsonType::Bool: return value.b_value ? sizeof(JSON_BOOLTRUE_LITERAL) - 1 : sizeof(JSON_BOOLFALSE_LITERAL) - 1;
+        case Json::JsonType::Integer: return Json::Detail::intLength(value.i_value);
+        case Json::JsonType::Double: return Json::Detail::doubleLength(value.d_value, options.canonical);
+        case Json::JsonType::String: return Json::Detail::stringLength(*value.s_value, Json::Detail::escapingOf(options));
+        case Json::JsonType::Object: {
+            size_t size = 2; // Braces
+            if (value.hasLayout(Json::Detail::Layout::Shaped)) {
+                const Json::Detail::ShapedObject& object = *value.r_value;
+                for (size_t i = 0; i < object.values.size(); i++) {
+                    size += Json::Detail::stringLength(object.shape->keys[i], Json::Detail::escapingOf(options)) + 1 + serializedSize(object.values[i], options);
+                }
+                return size + (object.values.empty() ? 0 : object.values.size() - 1);
+            }
+            for (const auto& entry : *value.o_value) {
+                size += Json::Detail::stringLength(entry.first, Json::Detail::escapingOf(options)) + 1 + serializedSize(entry.second, options);
+            }
+            return size + (value.o_value->empty() ? 0 : value.o_value->size() - 1);
+        }
+        case Json::JsonType::Array: {
+            size_t size = 2; // Brackets
+            size_t count;
+            if (value.hasLayout(Json::Detail::Layout::Packed)) {
+                const Json::Detail::PackedArray& array = *value.n_value;
+                count = array.size();
+                for (size_t i = 0; i < count; i++) {
+                    if (array.integral) {
+                        size += Json::Detail::intLength(array.ints[i]);
+                    } else if (packedElementIsInt(array, i)) {
+                        size += Json::Detail::intLength(static_cast<int>(array.doubles[i]));
+                    } else {
+                        size += Json::Detail::doubleLength(array.doubles[i], options.canonical);
+                    }
+                }
+            } else {
+                count = value.a_value->size();
+                for (const Json::JsonValue& element : *value.a_value) {
+                    size += serializedSize(element, options);
+                }
+            }
+            return size + (count == 0 ? 0 : count - 1);
+        }
+        case Json::JsonType::Null: return sizeof(JSON_NULL_LITERAL) - 1;
+        default: return sizeof("Unknown Json Value") - 1;
+    }
+}
+
+size_t Json::MemoryUsage::nodeCount() const noexcept {
+    size_t total = 0;
+    for (size_t count : nodes) {
+        total += count;
+    }
+    return total;
+}
+
+Json::MemoryUsage Json::memoryUsage(const JsonValue& value) {
+    Json::MemoryUsage usage;
+    Json::Detail::UsageCollector collector(usage);
+    collector.addDeep(value);
+    return usage;
+}
+
+char Json::Detail::TextReader::peek() {
+    while (m_pos < m_length && isJsonWhitespace(m_data[m_pos])) {
+        m_pos++;
+    }
+    if (m_pos >= m_length)
+        throw Json::JsonMalformedException("Unexpected end of json");
+    return m_data[m_pos];
+}
+
+Json::JsonType Json::Detail::TextReader::peekType() {
+    switch (peek()) {
+        case JSONOBJECT_STARTDELIMITER: return Json::JsonType::Object;
+        case JSONARRAY_STARTDELIMITER: return Json::JsonType::Array;
+        case JSONSTRING_DELIMITER: return Json::JsonType::String;
+        case 't':
+        case 'f': return Json::JsonType::Bool;
+        case 'n': return Json::JsonType::Null;
+        default: return findNextJsonValue(SubString{ m_data, m_length }, m_pos).type;
+    }
+}
+
+void Json::Detail::TextReader::typeMismatch(const char* expected) {
+    throw Json::JsonTypeException(std::string("Cannot cast to C++ ") + expected + " because the underlying type is " + jsonTypeToString(peekType()));
+}
+
+void Json::Detail::TextReader::readLiteral(const char* literal, size_t length) {
+    if (m_length - m_pos < length || std::memcmp(m_data + m_pos, literal, length) != 0)
+        throw Json::JsonMalformedException("Unable to determine json type");
+    m_pos += length;
+}
+
+const std::string& Json::Detail::TextReader::readStringToken() {
+    SubString json{ m_data, m_length };
+    size_t end = findEndOfJsonString(json, m_pos);
+    if (end == std::string::npos)
+        throw Json::JsonMalformedException("Json string with missing closing quotes");
+    m_scratch.clear();
+    appendJsonStringValue(json.subView(m_pos + 1, end - 1), m_scratch);
+    m_pos = end + 1;
+    return m_scratch;
+}
+
+bool Json::Detail::TextReader::readNull() {
+    if (peek() != 'n')
+        return false;
+    readLiteral(JSON_NULL_LITERAL, sizeof(JSON_NULL_LITERAL) - 1);
+    return true;
+}
+
+bool Json::Detail::TextReader::readBool() {
+    switch (peek()) {
+        case 't': readLiteral(JSON_BOOLTRUE_LITERAL, sizeof(JSON_BOOLTRUE_LITERAL) - 1); return true;
+        case 'f': readLiteral(JSON_BOOLFALSE_LITERAL, sizeof(JSON_BOOLFALSE_LITERAL) - 1); return false;
+        default: typeMismatch("BOOL");
+    }
+}
+
+bool Json::Detail::TextReader::readNumber(int& intValue, double& doubleValue) {
+    char c = peek();
+    if (c != '-' && !isdigit(c))
+        typeMismatch("NUMBER");
+    SubString json{ m_data, m_length };
+    NumberScan number = scanNumber(json, m_pos);
+    if (number.valid) {
+        m_pos = number.end;
+        intValue = number.intValue;
+        doubleValue = number.doubleValue;
+        return !number.isDouble;
+    }
+    // Malformed or out of range, fails exactly like parseJson
+    ValueMetaInfo info = findNextJsonValue(json, m_pos);
+    std::string text = subStrToString(json.subView(info.startIndex, info.endIndex));
+    bool isInteger = info.type == Json::JsonType::Integer;
+    if (isInteger) {
+        intValue = std::stoi(text);
+    } else {
+        doubleValue = std::stod(text);
+    }
+    m_pos = info.endIndex + 1;
+    return isInteger;
+}
+
+int Json::Detail::TextReader::readInt() {
+    char c = peek();
+    if (c != '-' && !isdigit(c))
+        typeMismatch("INTEGER");
+    int intValue = 0;
+    double doubleValue = 0.0;
+    if (!readNumber(intValue, doubleValue))
+        throw Json::JsonTypeException("Cannot cast to C++ INTEGER because the underlying type is DOUBLE");
+    return intValue;
+}
+
+double Json::Detail::TextReader::readDouble() {
+    char c = peek();
+    if (c != '-' && !isdigit(c))
+        typeMismatch("DOUBLE");
+    int intValue = 0;
+    double doubleValue = 0.0;
+    return readNumber(intValue, doubleValue) ? intValue : doubleValue;
+}
+
+const std::string& Json::Detail::TextReader::readString() {
+    if (peek() != JSONSTRING_DELIMITER)
+        typeMismatch("STRING");
+    return readStringToken();
+}
+
+Json::JsonValue Json::Detail::TextReader::readValue() {
+    // Built while reading, the text of the subtree is not copied or scanned twice
+    switch (peek()) {
+        case JSONOBJECT_STARTDELIMITER: {
+            beginObject();
+            Json::JsonObject object;
+            for (bool first = true; nextMember(first); first = false) {
+                // Duplicate keys keep their first value like parseJson, later ones are still read for validation
+                auto slot = object.emplace(m_scratch, Json::JsonValue());
+                if (slot.second) {
+                    slot.first->second = readValue();
+                } else {
+                    readValue();
+                }
+            }
+            return Json::JsonValue(std::move(object));
+        }
+        case JSONARRAY_STARTDELIMITER: {
+            beginArray();
+            Json::JsonArray array;
+            for (bool first = true; nextElement(first); first = false) {
+                array.push_back(readValue());
+            }
+            return Json::JsonValue(std::move(array));
+        }
+        case JSONSTRING_DELIMITER: return Json::JsonValue(readString());
+        case 't':
+        case 'f': return Json::JsonValue(readBool());
+        case 'n':
+            readNull();
+            return Json::JsonValue(nullptr);
+        default: {
+            if (peek() != '-' && !isdigit(peek()))
+                throw Json::JsonMalformedException("Unable to determine json type");
+            int intValue = 0;
+            double doubleValue = 0.0;
+            return readNumber(intValue, doubleValue) ? Json::JsonValue(intValue) : Json::JsonValue(doubleValue);
         }
-        case Json::JsonType::String: return JSONSTRING_DELIMITER + escapeString({ value.s_value->c_str(), value.s_value->length() }) + JSONSTRING_DELIMITER;
-        case Json::JsonType::Object: return serializeObject(*value.o_value);
-        case Json::JsonType::Array: return serializeArray(*value.a_value);
-        case Json::JsonType::Null: return JSON_NULL_LITERAL;
-        default: return "Unknown Json Value";
     }
 }
 
+void Json::Detail::TextReader::skipValue() {
+    peek();
+    m_pos = findNextJsonValue(SubString{ m_data, m_length }, m_pos).endIndex + 1;
+}
+
+void Json::Detail::TextReader::beginObject() {
+    if (peek() != JSONOBJECT_STARTDELIMITER)
+        typeMismatch("OBJECT");
+    m_pos++;
+}
+
+bool Json::Detail::TextReader::nextMember(bool first) {
+    char c = peek();
+    if (first && c == JSONOBJECT_ENDDELIMITER) {
+        m_pos++;
+        return false;
+    }
+    if (!first) {
+        m_pos++;
+        if (c == JSONOBJECT_ENDDELIMITER)
+            return false;
+        if (c != JSONVALUE_DELIMITER)
+            throw Json::JsonMalformedException("Unexpected character when searching for separator or closure in json object");
+        c = peek();
+    }
+    if (c != JSONSTRING_DELIMITER)
+        throw Json::JsonMalformedException("Unexpected character when searching for key in json object");
+    readStringToken();
+    if (peek() != JSONKEYVALUE_SEPERATOR)
+        throw Json::JsonMalformedException("Error finding json key value seperator");
+    m_pos++;
+    return true;
+}
+
+void Json::Detail::TextReader::beginArray() {
+    if (peek() != JSONARRAY_STARTDELIMITER)
+        typeMismatch("ARRAY");
+    m_pos++;
+}
+
+bool Json::Detail::TextReader::nextElement(bool first) {
+    char c = peek();
+    if (first)
+        return c == JSONARRAY_ENDDELIMITER ? (m_pos++, false) : true;
+    m_pos++;
+    if (c == JSONARRAY_ENDDELIMITER)
+        return false;
+    if (c != JSONVALUE_DELIMITER)
+        throw Json::JsonMalformedException("Unexpected character when searching for separator or closure in json array");
+    return true;
+}
+
+void Json::Detail::TextReader::finish() {
+    if (findNextNonWSCharacter(SubString{ m_data, m_length }, m_pos) != std::string::npos)
+        throw Json::JsonMalformedException("Unexpected characters after json value");
+}
+
+static void emitEvents(Json::Detail::TextReader& reader, Json::Detail::ValueVisitor& visitor) {
+    switch (reader.peek()) {
+        case JSONOBJECT_STARTDELIMITER:
+            reader.beginObject();
+            visitor.beginObject(0);
+            for (bool first = true; reader.nextMember(first); first = false) {
+                visitor.key(reader.key());
+                emitEvents(reader, visitor);
+            }
+            visitor.endObject();
+            break;
+        case JSONARRAY_STARTDELIMITER:
+            reader.beginArray();
+            visitor.beginArray(0);
+            for (bool first = true; reader.nextElement(first); first = false) {
+                emitEvents(reader, visitor);
+            }
+            visitor.endArray();
+            break;
+        case JSONSTRING_DELIMITER: visitor.string(reader.readString()); break;
+        case 't':
+        case 'f': visitor.boolean(reader.readBool()); break;
+        case 'n':
+            reader.readNull();
+            visitor.null();
+            break;
+        default: {
+            if (reader.peek() != '-' && !isdigit(reader.peek()))
+                throw Json::JsonMalformedException("Unable to determine json type");
+            int intValue = 0;
+            double doubleValue = 0.0;
+            if (reader.readNumber(intValue, doubleValue)) {
+                visitor.integer(intValue);
+            } else {
+                visitor.number(doubleValue);
+            }
+            break;
+        }
+    }
+}
+
+void Json::Detail::parseEvents(const char* json, size_t length, ValueVisitor& visitor) {
+    TextReader reader(json, length);
+    emitEvents(reader, visitor);
+    reader.finish();
+}
+
 Json::JsonValue Json::parseJson(const std::string& json) {
     SubString substrJson = { json.c_str(), json.length() };
-    return internalParseJson(substrJson);
+    ParseContext ctx = { nullptr, nullptr, false, nullptr };
+    return internalParseJson(substrJson, ctx);
+}
+
+Json::JsonValue Json::parseJson(const std::string& json, const ParseOptions& options) {
+    SubString substrJson = { json.c_str(), json.length() };
+    KeyTable keyTable; // Shapes are looked up by the identity of their interned keys
+
+    ShapeCache shapes;
+    Json::MemoryUsage unusedStats;
+    if (options.stats) {
+        *options.stats = Json::MemoryUsage();
+    }
+    Json::Detail::UsageCollector collector(options.stats ? *options.stats : unusedStats);
+
+    ParseContext ctx = { options.shareShapes ? &keyTable : nullptr, options.shareShapes ? &shapes : nullptr, options.packNumbers, options.stats ? &collector : nullptr };
+#ifdef JSONPARSER_MEMORY_RESOURCE
+    Json::MemoryResourceScope scope(options.memoryResource ? options.memoryResource : Json::currentMemoryResource());
+#endif
+    return internalParseJson(substrJson, ctx);
 }
\ No newline at end of file
@@ -0,0 +1,427 @@
+#include "json/JsonPatch.h"
+#include <algorithm>
+
+namespace {
+
+using Pointer = std::vector<std::string>;
+
+enum class PatchOp { Add, Remove, Replace, Move, Copy, Test };
+
+template <typename Value>
+struct Operation {
+    PatchOp op;
+    Pointer path;
+    Pointer from;
+    Value* value; // Inside the patch
+};
+
+std::string escapeToken(const std::string& token) {
+    std::string result;
+    for (char c : token) {
+        if (c == '~') {
+            result += "~0";
+        } else if (c == '/') {
+            result += "~1";
+        } else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+std::string formatPointer(const Pointer& pointer) {
+    std::string result;
+    for (const std::string& token : pointer) {
+        result += "/" + escapeToken(token);
+    }
+    return result;
+}
+
+[[noreturn]] void malformed(size_t index, const std::string& message) {
+    throw Json::JsonMalformedException("Patch operation " + std::to_string(index) + ": " + message);
+}
+
+Pointer parsePointer(const std::string& text, size_t index) {
+    Pointer pointer;
+    if (text.empty())
+        return pointer;
+    if (text[0] != '/')
+        malformed(index, "json pointer \"" + text + "\" does not start with '/'");
+    size_t pos = 0;
+    while (pos != std::string::npos) {
+        size_t end = text.find('/', pos + 1);
+        size_t limit = end == std::string::npos ? text.length() : end;
+        std::string token;
+        for (size_t i = pos + 1; i < limit; i++) {
+            if (text[i] != '~') {
+                token += text[i];
+            } else if (i + 1 < limit && (text[i + 1] == '0' || text[i + 1] == '1')) {
+                token += text[++i] == '0' ? '~' : '/';
+            } else {
+                malformed(index, "invalid escape in json pointer \"" + text + "\"");
+            }
+        }
+        pointer.push_back(std::move(token));
+        pos = end;
+    }
+    return pointer;
+}
+
+template <typename Value>
+std::vector<Operation<Value>> parsePatch(Value& patch) {
+    if (!patch.isArray())
+        throw Json::JsonMalformedException("Json patch has to be an array of operations");
+    static const char* names[] = { "add", "remove", "replace", "move", "copy", "test" };
+
+    std::vector<Operation<Value>> operations;
+    for (size_t i = 0; i < patch.toArray().size(); i++) {
+        Value& entry = patch.toArray()[i];
+        if (!entry.isObject())
+            malformed(i, "expected an object");
+        auto member = [&entry](const char* name) -> Value* {
+            auto it = entry.toObject().find(name);
+            return it == entry.toObject().end() ? nullptr : &it->second;
+        };
+
+        Value* name = member("op");
+        if (!name || !name->isString())
+            malformed(i, "missing \"op\"");
+        size_t op = 0;
+        while (op < 6 && name->toString() != names[op]) {
+            op++;
+        }
+        if (op == 6)
+            malformed(i, "unknown op \"" + name->toString() + "\"");
+
+        Operation<Value> operation = { static_cast<PatchOp>(op), Pointer(), Pointer(), nullptr };
+        Value* path = member("path");
+        if (!path || !path->isString())
+            malformed(i, "missing \"path\"");
+        operation.path = parsePointer(path->toString(), i);
+
+        if (operation.op == PatchOp::Move || operation.op == PatchOp::Copy) {
+            Value* from = member("from");
+            if (!from || !from->isString())
+                malformed(i, "missing \"from\"");
+            operation.from = parsePointer(from->toString(), i);
+            if (operation.op == PatchOp::Move && operation.from.size() < operation.path.size() &&
+                std::equal(operation.from.begin(), operation.from.end(), operation.path.begin()))
+                malformed(i, "cannot move a value into itself");
+        }
+        if (operation.op == PatchOp::Add || operation.op == PatchOp::Replace || operation.op == PatchOp::Test) {
+            operation.value = member("value");
+            if (!operation.value)
+                malformed(i, "missing \"value\"");
+        }
+        operations.push_back(std::move(operation));
+    }
+    return operations;
+}
+
+// Digits without leading zeros, "-" is the position past the end where adding allows it
+size_t arrayIndex(const std::string& token, size_t size, bool allowEnd) {
+    if (allowEnd && token == "-")
+        return size;
+    if (token.empty() || token.length() > 18 || (token.length() > 1 && token[0] == '0') ||
+        token.find_first_not_of("0123456789") != std::string::npos)
+        throw Json::JsonPatchException("Invalid array index \"" + token + "\"");
+    size_t index = static_cast<size_t>(std::stoull(token));
+    if (index > size || (!allowEnd && index == size))
+        throw Json::JsonPatchException("Array index " + token + " is out of range");
+    return index;
+}
+
+template <typename Value>
+Value& child(Value& parent, const std::string& token) {
+    if (parent.isObject()) {
+        // Const lookups read shaped records in place, mutable ones fall back to the regular object anyway
+        if (!parent.find(Json::Key(token)))
+            throw Json::JsonPatchException("Key \"" + token + "\" not found");
+        return parent.at(token);
+    }
+    if (parent.isArray())
+        return parent.toArray()[arrayIndex(token, parent.toArray().size(), false)];
+    throw Json::JsonPatchException("Cannot look up \"" + token + "\" in a " + Json::jsonTypeToString(parent.type()));
+}
+
+template <typename Value>
+Value& resolve(Value& root, const Pointer& pointer, size_t depth) {
+    Value* value = &root;
+    for (size_t i = 0; i < depth; i++) {
+        value = &child(*value, pointer[i]);
+    }
+    return *value;
+}
+
+// Json numbers compare by value at any depth, 1 equals 1.0
+bool jsonEquals(const Json::JsonValue& a, const Json::JsonValue& b) {
+    if (a == b)
+        return true;
+    bool aNumber = a.isInt() || a.isDouble();
+    bool bNumber = b.isInt() || b.isDouble();
+    if (aNumber && bNumber)
+        return (a.isInt() ? a.toInt() : a.toDouble()) == (b.isInt() ? b.toInt() : b.toDouble());
+    if (a.isArray() && b.isArray()) {
+        const Json::JsonArray& left = a.toArray();
+        const Json::JsonArray& right = b.toArray();
+        return left.size() == right.size() && std::equal(left.begin(), left.end(), right.begin(), jsonEquals);
+    }
+    if (a.isObject() && b.isObject()) {
+        return a.size() == b.size() && a.forEachMember([&b](const std::string& key, const Json::JsonValue& member) {
+            const Json::JsonValue* counterpart = b.find(Json::Key(key));
+            return counterpart && jsonEquals(member, *counterpart);
+        });
+    }
+    return false;
+}
+
+inline Json::JsonValue take(const Json::JsonValue& value) { return value; }
+inline Json::JsonValue take(Json::JsonValue& value) { return std::move(value); }
+
+// Applies operations one by one and records how to revert each of them. Reverting walks the log backwards, every path
+// then points into the same document state as when it was recorded
+class PatchApplier {
+private:
+    struct UndoEntry {
+        enum Kind { Inserted, Removed, Replaced } kind;
+        Pointer path; // Array positions resolved, never "-"
+        Json::JsonValue value; // Removed or replaced value
+        bool moved; // Removed value was moved to the next inserted or replaced one
+    };
+
+    Json::JsonValue& m_document;
+    std::vector<UndoEntry> m_undo;
+
+    // Only takes the value once the target is resolved, a failing insert leaves it with the caller
+    void insert(const Pointer& path, Json::JsonValue&& value) {
+        if (path.empty()) {
+            m_undo.push_back({ UndoEntry::Replaced, path, std::move(m_document), false });
+            m_document = std::move(value);
+            return;
+        }
+        Json::JsonValue& parent = resolve(m_document, path, path.size() - 1);
+        const std::string& token = path.back();
+        if (parent.isObject()) {
+            Json::JsonObject& object = parent.toObject();
+            auto it = object.find(token);
+            if (it != object.end()) {
+                m_undo.push_back({ UndoEntry::Replaced, path, std::move(it->second), false });
+                it->second = std::move(value);
+            } else {
+                object.emplace(token, std::move(value));
+                m_undo.push_back({ UndoEntry::Inserted, path, Json::JsonValue(), false });
+            }
+        } else if (parent.isArray()) {
+            Json::JsonArray& array = parent.toArray();
+            size_t index = arrayIndex(token, array.size(), true);
+            array.insert(array.begin() + static_cast<std::ptrdiff_t>(index), std::move(value));
+            Pointer position = path;
+            position.back() = std::to_string(index);
+            m_undo.push_back({ UndoEntry::Inserted, std::move(position), Json::JsonValue(), false });
+        } else {
+            throw Json::JsonPatchException("Cannot add \"" + token + "\" to a " + Json::jsonTypeToString(parent.type()));
+        }
+    }
+
+    // Takes the value out of the document. A moved value is not kept in the log, reverting takes it back from its target
+    Json::JsonValue erase(const Pointer& path, bool moved) {
+        if (path.empty())
+            throw Json::JsonPatchException("Cannot remove the document root");
+        Json::JsonValue& parent = resolve(m_document, path, path.size() - 1);
+        Json::JsonValue value = extract(parent, path.back());
+        if (moved) {
+            m_undo.push_back({ UndoEntry::Removed, path, Json::JsonValue(), true });
+            return value;
+        }
+        m_undo.push_back({ UndoEntry::Removed, path, std::move(value), false });
+        return Json::JsonValue();
+    }
+
+    static Json::JsonValue extract(Json::JsonValue& parent, const std::string& token) {
+        Json::JsonValue& value = child(parent, token);
+        Json::JsonValue result = std::move(value);
+        if (parent.isObject()) {
+            parent.toObject().erase(token);
+        } else {
+            Json::JsonArray& array = parent.toArray();
+            array.erase(array.begin() + (&value - array.data()));
+        }
+        return result;
+    }
+
+    void replace(const Pointer& path, Json::JsonValue value) {
+        Json::JsonValue& target = resolve(m_document, path, path.size());
+        m_undo.push_back({ UndoEntry::Replaced, path, std::move(target), false });
+        target = std::move(value);
+    }
+
+    void rollback() noexcept {
+        Json::JsonValue carry; // Value taken out by the last reverted step, for the move it came from
+        for (auto it = m_undo.rbegin(); it != m_undo.rend(); ++it) {
+            try {
+                const Pointer& path = it->path;
+                switch (it->kind) {
+                    case UndoEntry::Inserted: carry = extract(resolve(m_document, path, path.size() - 1), path.back()); break;
+                    case UndoEntry::Replaced: {
+                        Json::JsonValue& target = resolve(m_document, path, path.size());
+                        carry = std::move(target);
+                        target = std::move(it->value);
+                        break;
+                    }
+                    case UndoEntry::Removed: {
+                        Json::JsonValue& parent = resolve(m_document, path, path.size() - 1);
+                        Json::JsonValue value = it->moved ? std::move(carry) : std::move(it->value);
+                        if (parent.isObject()) {
+                            parent.toObject().emplace(path.back(), std::move(value));
+                        } else {
+                            Json::JsonArray& array = parent.toArray();
+                            array.insert(array.begin() + static_cast<std::ptrdiff_t>(std::stoull(path.back())), std::move(value));
+                        }
+                        break;
+                    }
+                }
+            } catch (...) {
+                // Only reached when out of memory, every path existed when it was recorded
+            }
+        }
+        m_undo.clear();
+    }
+
+public:
+    explicit PatchApplier(Json::JsonValue& document) noexcept : m_document(document) {}
+
+    template <typename Value>
+    void apply(const std::vector<Operation<Value>>& operations) {
+        size_t index = 0;
+        try {
+            for (; index < operations.size(); index++) {
+                const Operation<Value>& operation = operations[index];
+                switch (operation.op) {
+                    case PatchOp::Add: insert(operation.path, take(*operation.value)); break;
+                    case PatchOp::Remove: erase(operation.path, false); break;
+                    case PatchOp::Replace: replace(operation.path, take(*operation.value)); break;
+                    case PatchOp::Move:
+                        if (operation.from != operation.path) {
+                            Json::JsonValue value = erase(operation.from, true);
+                            try {
+                                insert(operation.path, std::move(value));
+                            } catch (...) {
+                                // The target did not take the value, the removal restores it from the log
+                                m_undo.back().value = std::move(value);
+                                m_undo.back().moved = false;
+                                throw;
+                            }
+                        }
+                        break;
+                    case PatchOp::Copy: {
+                        const Json::JsonValue& document = m_document;
+                        insert(operation.path, Json::JsonValue(resolve(document, operation.from, operation.from.size())));
+                        break;
+                    }
+                    case PatchOp::Test: {
+                        const Json::JsonValue& document = m_document;
+                        if (!jsonEquals(resolve(document, operation.path, operation.path.size()), *operation.value))
+                            throw Json::JsonPatchException("Test failed at \"" + formatPointer(operation.path) + "\"");
+                        break;
+                    }
+                }
+            }
+        } catch (const Json::JsonPatchException& e) {
+            rollback();
+            throw Json::JsonPatchException("Patch operation " + std::to_string(index) + ": " + e.what());
+        } catch (...) {
+            rollback();
+            throw;
+        }
+    }
+};
+
+Json::JsonValue makeOperation(const char* op, const std::string& path) {
+    Json::JsonObject operation;
+    operation.emplace("op", Json::JsonValue(op));
+    operation.emplace("path", Json::JsonValue(path));
+    return Json::JsonValue(std::move(operation));
+}
+
+Json::JsonValue makeOperation(const char* op, const std::string& path, const Json::JsonValue& value) {
+    Json::JsonValue operation = makeOperation(op, path);
+    operation.toObject().emplace("value", value);
+    return operation;
+}
+
+void diffInto(const Json::JsonValue& from, const Json::JsonValue& to, std::string& path, Json::JsonArray& operations) {
+    if (from.type() != to.type() || (!from.isObject() && !from.isArray())) {
+        if (!(from == to))
+            operations.push_back(makeOperation("replace", path, to));
+        return;
+    }
+    if (from.isShared() && to.isShared() && from == to)
+        return; // Same node or different cached hashes, no walk
+
+    size_t length = path.length();
+    if (from.isObject()) {
+        from.forEachMember([&](const std::string& key, const Json::JsonValue&) {
+            if (!to.find(Json::Key(key)))
+                operations.push_back(makeOperation("remove", path + "/" + escapeToken(key)));
+            return true;
+        });
+        to.forEachMember([&](const std::string& key, const Json::JsonValue& member) {
+            path += "/" + escapeToken(key);
+            const Json::JsonValue* previous = from.find(Json::Key(key));
+            if (!previous) {
+                operations.push_back(makeOperation("add", path, member));
+            } else {
+                diffInto(*previous, member, path, operations);
+            }
+            path.resize(length);
+            return true;
+        });
+        return;
+    }
+
+    const Json::JsonArray& before = from.toArray();
+    const Json::JsonArray& after = to.toArray();
+    size_t start = 0;
+    while (start < before.size() && start < after.size() && before[start] == after[start]) {
+        start++;
+    }
+    size_t beforeEnd = before.size();
+    size_t afterEnd = after.size();
+    while (beforeEnd > start && afterEnd > start && before[beforeEnd - 1] == after[afterEnd - 1]) {
+        beforeEnd--;
+        afterEnd--;
+    }
+
+    // Changed range: pairs are diffed in place, the rest is removed or added
+    size_t paired = std::min(beforeEnd, afterEnd) - start;
+    for (size_t i = start; i < start + paired; i++) {
+        path += "/" + std::to_string(i);
+        diffInto(before[i], after[i], path, operations);
+        path.resize(length);
+    }
+    for (size_t i = beforeEnd; i > start + paired; i--) {
+        operations.push_back(makeOperation("remove", path + "/" + std::to_string(i - 1)));
+    }
+    for (size_t i = start + paired; i < afterEnd; i++) {
+        operations.push_back(makeOperation("add", path + "/" + std::to_string(i), after[i]));
+    }
+}
+
+} // namespace
+
+void Json::applyPatch(JsonValue& document, const JsonValue& patch) {
+    std::vector<Operation<const JsonValue>> operations = parsePatch(patch);
+    PatchApplier(document).apply(operations);
+}
+
+void Json::applyPatch(JsonValue& document, JsonValue&& patch) {
+    std::vector<Operation<JsonValue>> operations = parsePatch(patch);
+    PatchApplier(document).apply(operations);
+}
+
+Json::JsonValue Json::diff(const JsonValue& from, const JsonValue& to) {
+    JsonArray operations;
+    std::string path;
+    diffInto(from, to, path, operations);
+    return JsonValue(std::move(operations));
+}
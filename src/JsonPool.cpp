@@ -0,0 +1,245 @@
+#include "json/JsonParser.h"
+
+#ifdef JSONPARSER_POOL_ALLOCATOR
+
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+// Size class pool for JsonValue payloads, also backs the default memory resource. Every thread keeps free lists per
+// size class and only touches the shared depot (behind a mutex) when a list runs empty or grows beyond its limit.
+
+static constexpr size_t poolGranularity = 16;
+static constexpr size_t poolClassCount = 16; // Blocks up to 256 bytes, bigger payloads use operator new
+static constexpr size_t poolChunkSize = 64 * 1024;
+static constexpr size_t poolBatchSize = 64; // Blocks moved between a thread and the depot at once
+static constexpr size_t poolMaxCachedBlocks = 4 * poolBatchSize;
+
+namespace {
+
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+struct FreeList {
+    FreeBlock* head = nullptr;
+    size_t count = 0;
+
+    inline void push(void* block) noexcept {
+        FreeBlock* freeBlock = static_cast<FreeBlock*>(block);
+        freeBlock->next = head;
+        head = freeBlock;
+        count++;
+    }
+
+    inline void* pop() noexcept {
+        FreeBlock* block = head;
+        head = block->next;
+        count--;
+        return block;
+    }
+};
+
+} // namespace
+
+static inline size_t sizeClassOf(size_t size) noexcept {
+    return (size - 1) / poolGranularity;
+}
+
+static inline size_t blockSizeOf(size_t sizeClass) noexcept {
+    return (sizeClass + 1) * poolGranularity;
+}
+
+namespace {
+
+class PoolDepot {
+private:
+    struct Chunk {
+        size_t sizeClass;
+        size_t blockCount;
+    };
+
+    std::mutex m_mutex;
+    FreeList m_lists[poolClassCount];
+    std::map<uintptr_t, Chunk> m_chunks; // Keyed by chunk start address, only needed for trimming
+    size_t m_reservedBytes = 0;
+
+public:
+    void refill(size_t sizeClass, FreeList& target) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        FreeList& source = m_lists[sizeClass];
+        if (source.count == 0) {
+            // Carve a new chunk into blocks of this size class
+            char* chunk = static_cast<char*>(::operator new(poolChunkSize));
+            size_t blockSize = blockSizeOf(sizeClass);
+            size_t blockCount = poolChunkSize / blockSize;
+            for (size_t i = blockCount; i > 0; i--) {
+                source.push(chunk + (i - 1) * blockSize);
+            }
+            m_chunks[reinterpret_cast<uintptr_t>(chunk)] = { sizeClass, blockCount };
+            m_reservedBytes += poolChunkSize;
+        }
+
+        for (size_t i = 0; i < poolBatchSize && source.count > 0; i++) {
+            target.push(source.pop());
+        }
+    }
+
+    void spill(size_t sizeClass, FreeList& source, size_t count) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        FreeList& target = m_lists[sizeClass];
+        for (size_t i = 0; i < count && source.count > 0; i++) {
+            target.push(source.pop());
+        }
+    }
+
+    void release(size_t sizeClass, void* block) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_lists[sizeClass].push(block);
+    }
+
+    size_t trim() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Count free blocks per chunk, a chunk is released once all of its blocks are in the depot
+        std::unordered_map<uintptr_t, size_t> freeBlocks;
+        for (FreeList& list : m_lists) {
+            for (FreeBlock* block = list.head; block; block = block->next) {
+                auto chunk = --m_chunks.upper_bound(reinterpret_cast<uintptr_t>(block));
+                freeBlocks[chunk->first]++;
+            }
+        }
+
+        std::unordered_map<uintptr_t, bool> releasable;
+        for (const auto& entry : freeBlocks) {
+            if (entry.second == m_chunks[entry.first].blockCount) {
+                releasable[entry.first] = true;
+            }
+        }
+        if (releasable.empty()) {
+            return 0;
+        }
+
+        for (FreeList& list : m_lists) {
+            FreeList kept;
+            while (list.count > 0) {
+                void* block = list.pop();
+                auto chunk = --m_chunks.upper_bound(reinterpret_cast<uintptr_t>(block));
+                if (!releasable.count(chunk->first)) {
+                    kept.push(block);
+                }
+            }
+            list = kept;
+        }
+
+        for (const auto& entry : releasable) {
+            m_chunks.erase(entry.first);
+            ::operator delete(reinterpret_cast<void*>(entry.first));
+        }
+        size_t released = releasable.size() * poolChunkSize;
+        m_reservedBytes -= released;
+        return released;
+    }
+
+    size_t reservedBytes() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_reservedBytes;
+    }
+};
+
+} // namespace
+
+static PoolDepot& poolDepot() {
+    // Never destroyed, payloads of static JsonValues may still be released during shutdown
+    static PoolDepot* depot = new PoolDepot();
+    return *depot;
+}
+
+// Plain flag so it can still be read after the cache of an exiting thread got destroyed
+static thread_local bool threadCacheDestroyed = false;
+
+namespace {
+
+struct ThreadCache {
+    FreeList lists[poolClassCount];
+
+    ~ThreadCache() {
+        threadCacheDestroyed = true;
+        for (size_t sizeClass = 0; sizeClass < poolClassCount; sizeClass++) {
+            poolDepot().spill(sizeClass, lists[sizeClass], lists[sizeClass].count);
+        }
+    }
+};
+
+} // namespace
+
+static ThreadCache& threadCache() {
+    static thread_local ThreadCache cache;
+    return cache;
+}
+
+void* Json::Detail::poolAllocate(size_t size) {
+    if (size == 0 || size > poolGranularity * poolClassCount) {
+        return ::operator new(size);
+    }
+
+    size_t sizeClass = sizeClassOf(size);
+    if (threadCacheDestroyed) {
+        FreeList single;
+        poolDepot().refill(sizeClass, single);
+        void* block = single.pop();
+        poolDepot().spill(sizeClass, single, single.count);
+        return block;
+    }
+
+    FreeList& list = threadCache().lists[sizeClass];
+    if (list.count == 0) {
+        poolDepot().refill(sizeClass, list);
+    }
+    return list.pop();
+}
+
+void Json::Detail::poolDeallocate(void* block, size_t size) noexcept {
+    if (size == 0 || size > poolGranularity * poolClassCount) {
+        ::operator delete(block);
+        return;
+    }
+
+    size_t sizeClass = sizeClassOf(size);
+    if (threadCacheDestroyed) {
+        poolDepot().release(sizeClass, block);
+        return;
+    }
+
+    FreeList& list = threadCache().lists[sizeClass];
+    list.push(block);
+    if (list.count > poolMaxCachedBlocks) {
+        poolDepot().spill(sizeClass, list, list.count - poolBatchSize);
+    }
+}
+
+size_t Json::trimPools() {
+    if (!threadCacheDestroyed) {
+        FreeList* lists = threadCache().lists;
+        for (size_t sizeClass = 0; sizeClass < poolClassCount; sizeClass++) {
+            poolDepot().spill(sizeClass, lists[sizeClass], lists[sizeClass].count);
+        }
+    }
+    return poolDepot().trim();
+}
+
+size_t Json::pooledBytes() {
+    return poolDepot().reservedBytes();
+}
+
+#else
+
+size_t Json::trimPools() {
+    return 0;
+}
+
+size_t Json::pooledBytes() {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,836 @@
+#include "json/JsonQuery.h"
+#include "json/JsonBind.h"
+#include "JsonOutput.h"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <deque>
+#include <iterator>
+
+namespace {
+
+constexpr long long maxIndex = 9007199254740991LL; // Largest exact integer of a double, as in RFC 9535
+constexpr long long unknownLength = LLONG_MAX; // Array length while streaming, only used by selectors that do not need it
+
+struct Selector {
+    enum Kind { Name, Wildcard, Index, Slice, Filter } kind;
+    Json::Key name = Json::Key("");
+    long long index = 0; // Index, or slice start
+    long long end = 0;
+    long long step = 1;
+    bool hasStart = false;
+    bool hasEnd = false;
+    int filter = -1; // Expression index
+
+    explicit Selector(Kind kind) : kind(kind) {}
+    Selector(Kind kind, std::string name) : kind(kind), name(std::move(name)) {}
+};
+
+struct Segment {
+    bool descendant = false; // Applies to the value and all its descendants
+    std::vector<Selector> selectors;
+    bool needsLength = false; // Negative index or slice bound, resolved against the array length
+    bool hasFilter = false;
+};
+
+// One way the streaming pass reached a value: the next segment and the position in the nodelist order so far, which
+// is compared element wise. Child segments add selector and rank, descendant segments the visited value before them
+struct Route {
+    size_t segment;
+    std::vector<long long> order;
+};
+
+struct StreamMatch {
+    std::vector<long long> order;
+    size_t value;
+};
+
+struct StreamState {
+    long long visits = 0; // Values entered so far, in document order
+    std::deque<Json::JsonValue> values; // Stable, matches nested in a match point into it
+    std::vector<StreamMatch> matches;
+};
+
+struct PathToken {
+    bool isIndex;
+    Json::Key name;
+    long long index;
+};
+
+struct Operand {
+    bool isPath = false;
+    std::vector<PathToken> path; // Relative to @
+    Json::JsonValue literal;
+};
+
+enum class Comparison { Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual };
+
+struct Expression {
+    enum Kind { Or, And, Not, Exists, Compare } kind;
+    int left = -1; // Sub expressions of Or, And and Not
+    int right = -1;
+    Operand first; // Exists tests first only
+    Operand second;
+    Comparison comparison = Comparison::Equal;
+
+    explicit Expression(Kind kind) : kind(kind) {}
+};
+
+inline bool isNumber(const Json::JsonValue& value) noexcept {
+    return value.isInt() || value.isDouble();
+}
+
+inline double numberOf(const Json::JsonValue& value) {
+    return value.isInt() ? value.toInt() : value.toDouble();
+}
+
+// Slice bounds with the normalization of RFC 9535, [lower, upper) for positive steps and (lower, upper] for negative
+// ones. The length only matters for negative bounds and steps
+void sliceBounds(const Selector& slice, long long length, long long& lower, long long& upper) noexcept {
+    auto normalize = [length](long long bound) { return bound >= 0 ? bound : length + bound; };
+    if (slice.step >= 0) {
+        lower = slice.hasStart ? std::min(std::max(normalize(slice.index), 0LL), length) : 0;
+        upper = slice.hasEnd ? std::min(std::max(normalize(slice.end), 0LL), length) : length;
+    } else {
+        upper = slice.hasStart ? std::min(std::max(normalize(slice.index), -1LL), length - 1) : length - 1;
+        lower = slice.hasEnd ? std::min(std::max(normalize(slice.end), -1LL), length - 1) : -1;
+    }
+}
+
+bool inSlice(const Selector& slice, long long index, long long length) noexcept {
+    long long lower = 0;
+    long long upper = 0;
+    sliceBounds(slice, length, lower, upper);
+    if (slice.step > 0)
+        return index >= lower && index < upper && (index - lower) % slice.step == 0;
+    if (slice.step < 0)
+        return index > lower && index <= upper && (upper - index) % -slice.step == 0;
+    return false;
+}
+
+} // namespace
+
+struct Json::Query::Program {
+    std::vector<Segment> segments;
+    std::vector<Expression> expressions;
+
+    const Json::JsonValue* resolve(const Operand& operand, const Json::JsonValue& current) const;
+    bool test(int expression, const Json::JsonValue& current) const;
+    void select(const Segment& segment, const Json::JsonValue& value, std::vector<const Json::JsonValue*>& nodes) const;
+    void selectDescendants(const Segment& segment, const Json::JsonValue& value, std::vector<const Json::JsonValue*>& nodes) const;
+    bool selects(const Selector& selector, const std::string* key, size_t index, long long length, const Json::JsonValue* child) const;
+    void advance(const std::vector<Route>& routes, long long visit, const std::string* key, size_t index, long long length,
+                 const Json::JsonValue* child, std::vector<Route>& next) const;
+    bool needs(const std::vector<Route>& routes, bool Segment::*flag) const noexcept;
+    void walkTree(const Json::JsonValue& value, std::vector<Route> routes, StreamState& state, size_t stored) const;
+    void walkRead(Json::JsonValue&& value, std::vector<Route> routes, StreamState& state) const;
+    void walkStream(Json::Detail::TextReader& reader, std::vector<Route> routes, StreamState& state) const;
+};
+
+namespace {
+
+class QueryCompiler {
+private:
+    const std::string& m_text;
+    size_t m_pos = 0;
+    std::vector<Segment>& m_segments;
+    std::vector<Expression>& m_expressions;
+
+    [[noreturn]] void fail(const std::string& message) const {
+        throw Json::JsonMalformedException("Invalid JSONPath at position " + std::to_string(m_pos) + ": " + message);
+    }
+
+    inline bool atEnd() const noexcept { return m_pos >= m_text.length(); }
+    inline char current() const noexcept { return atEnd() ? '\0' : m_text[m_pos]; }
+
+    void skipBlanks() noexcept {
+        while (!atEnd() && (m_text[m_pos] == ' ' || m_text[m_pos] == '\t' || m_text[m_pos] == '\n' || m_text[m_pos] == '\r')) {
+            m_pos++;
+        }
+    }
+
+    bool consume(char c) {
+        skipBlanks();
+        if (current() != c)
+            return false;
+        m_pos++;
+        return true;
+    }
+
+    void expect(char c) {
+        if (!consume(c))
+            fail(std::string("expected '") + c + "'");
+    }
+
+    static bool isNameStart(char c) noexcept {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || static_cast<unsigned char>(c) >= 0x80;
+    }
+
+    std::string parseName() {
+        if (!isNameStart(current()))
+            fail("expected a member name");
+        size_t start = m_pos;
+        while (!atEnd() && (isNameStart(m_text[m_pos]) || (m_text[m_pos] >= '0' && m_text[m_pos] <= '9'))) {
+            m_pos++;
+        }
+        return m_text.substr(start, m_pos - start);
+    }
+
+    unsigned parseHex() {
+        if (m_pos + 4 > m_text.length())
+            fail("incomplete unicode escape");
+        unsigned value = 0;
+        for (size_t i = 0; i < 4; i++) {
+            char c = m_text[m_pos++];
+            value <<= 4;
+            if (c >= '0' && c <= '9') {
+                value |= static_cast<unsigned>(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                value |= static_cast<unsigned>(c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                value |= static_cast<unsigned>(c - 'A' + 10);
+            } else {
+                fail("invalid unicode escape");
+            }
+        }
+        return value;
+    }
+
+    // Single or double quoted, with the escapes of json strings
+    std::string parseString() {
+        char quote = m_text[m_pos++];
+        std::string result;
+        while (true) {
+            if (atEnd())
+                fail("unterminated string");
+            char c = m_text[m_pos++];
+            if (c == quote)
+                return result;
+            if (c != '\\') {
+                result += c;
+                continue;
+            }
+            if (atEnd())
+                fail("unterminated string");
+            c = m_text[m_pos++];
+            switch (c) {
+                case 'b': result += '\b'; break;
+                case 'f': result += '\f'; break;
+                case 'n': result += '\n'; break;
+                case 'r': result += '\r'; break;
+                case 't': result += '\t'; break;
+                case '/': case '\\': case '\'': case '"': result += c; break;
+                case 'u': {
+                    unsigned codePoint = parseHex();
+                    if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+                        if (m_text.compare(m_pos, 2, "\\u") != 0)
+                            fail("unpaired surrogate");
+                        m_pos += 2;
+                        unsigned low = parseHex();
+                        if (low < 0xDC00 || low > 0xDFFF)
+                            fail("unpaired surrogate");
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    } else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF) {
+                        fail("unpaired surrogate");
+                    }
+                    char buffer[4];
+                    result.append(buffer, Json::Detail::encodeUtf8(codePoint, buffer));
+                    break;
+                }
+                default: fail("invalid escape");
+            }
+        }
+    }
+
+    bool atInteger() noexcept {
+        skipBlanks();
+        return current() == '-' || (current() >= '0' && current() <= '9');
+    }
+
+    long long parseInteger() {
+        skipBlanks();
+        bool negative = current() == '-';
+        if (negative)
+            m_pos++;
+        if (current() < '0' || current() > '9')
+            fail("expected an integer");
+        if (current() == '0' && m_pos + 1 < m_text.length() && m_text[m_pos + 1] >= '0' && m_text[m_pos + 1] <= '9')
+            fail("leading zeros");
+        long long value = 0;
+        while (current() >= '0' && current() <= '9') {
+            value = value * 10 + (m_text[m_pos++] - '0');
+            if (value > maxIndex)
+                fail("integer out of range");
+        }
+        if (negative && value == 0)
+            fail("negative zero");
+        return negative ? -value : value;
+    }
+
+    Selector parseSelector(Segment& segment) {
+        skipBlanks();
+        Selector selector(Selector::Wildcard);
+        char c = current();
+        if (c == '\'' || c == '"') {
+            selector.kind = Selector::Name;
+            selector.name = Json::Key(parseString());
+        } else if (c == '*') {
+            m_pos++;
+        } else if (c == '?') {
+            m_pos++;
+            selector.kind = Selector::Filter;
+            selector.filter = parseOr();
+            segment.hasFilter = true;
+        } else if (c == ':' || atInteger()) {
+            selector.kind = Selector::Index;
+            if (c != ':') {
+                selector.index = parseInteger();
+                selector.hasStart = true;
+            }
+            if (consume(':')) {
+                selector.kind = Selector::Slice;
+                if (atInteger()) {
+                    selector.end = parseInteger();
+                    selector.hasEnd = true;
+                }
+                if (consume(':') && atInteger())
+                    selector.step = parseInteger();
+                segment.needsLength |= selector.step < 0 || (selector.hasStart && selector.index < 0) || (selector.hasEnd && selector.end < 0);
+            } else {
+                segment.needsLength |= selector.index < 0;
+            }
+        } else {
+            fail("expected a selector");
+        }
+        return selector;
+    }
+
+    void parseSegment() {
+        Segment segment;
+        if (m_text.compare(m_pos, 2, "..") == 0) {
+            segment.descendant = true;
+            m_pos += 2;
+            if (current() != '[' && current() != '*') {
+                segment.selectors.emplace_back(Selector::Name, parseName());
+            }
+        } else if (current() == '.') {
+            m_pos++;
+            if (current() != '*') {
+                segment.selectors.emplace_back(Selector::Name, parseName());
+            }
+        } else if (current() != '[') {
+            fail("expected '.' or '['");
+        }
+
+        if (current() == '*' && segment.selectors.empty()) {
+            m_pos++;
+            segment.selectors.emplace_back(Selector::Wildcard);
+        } else if (current() == '[' && segment.selectors.empty()) {
+            m_pos++;
+            do {
+                segment.selectors.push_back(parseSelector(segment));
+            } while (consume(','));
+            expect(']');
+        }
+
+        m_segments.push_back(std::move(segment));
+    }
+
+    // Singular path below @, only names and indices
+    std::vector<PathToken> parseRelativePath() {
+        std::vector<PathToken> path;
+        while (true) {
+            if (current() == '.' && m_text.compare(m_pos, 2, "..") != 0) {
+                m_pos++;
+                if (current() == '*')
+                    fail("filter paths have to select a single value");
+                path.push_back({ false, Json::Key(parseName()), 0 });
+            } else if (current() == '[') {
+                m_pos++;
+                skipBlanks();
+                if (current() == '\'' || current() == '"') {
+                    path.push_back({ false, Json::Key(parseString()), 0 });
+                } else if (atInteger()) {
+                    path.push_back({ true, Json::Key(""), parseInteger() });
+                } else {
+                    fail("filter paths have to select a single value");
+                }
+                expect(']');
+            } else if (current() == '.') {
+                fail("filter paths have to select a single value");
+            } else {
+                return path;
+            }
+        }
+    }
+
+    Operand parseOperand() {
+        skipBlanks();
+        Operand operand;
+        char c = current();
+        if (c == '@') {
+            m_pos++;
+            operand.isPath = true;
+            operand.path = parseRelativePath();
+        } else if (c == '$') {
+            fail("filters only support paths relative to @");
+        } else if (c == '\'' || c == '"') {
+            operand.literal = Json::JsonValue(parseString());
+        } else if (m_text.compare(m_pos, 4, "true") == 0) {
+            m_pos += 4;
+            operand.literal = Json::JsonValue(true);
+        } else if (m_text.compare(m_pos, 5, "false") == 0) {
+            m_pos += 5;
+            operand.literal = Json::JsonValue(false);
+        } else if (m_text.compare(m_pos, 4, "null") == 0) {
+            m_pos += 4;
+        } else if (c == '-' || (c >= '0' && c <= '9')) {
+            const char* start = m_text.c_str() + m_pos;
+            char* end = nullptr;
+            double number = std::strtod(start, &end);
+            std::string text(start, static_cast<size_t>(end - start));
+            if (text.empty() || text.find_first_not_of("0123456789+-.eE") != std::string::npos)
+                fail("invalid number");
+            m_pos += text.length();
+            bool integral = text.find_first_of(".eE") == std::string::npos && number >= INT_MIN && number <= INT_MAX;
+            operand.literal = integral ? Json::JsonValue(static_cast<int>(number)) : Json::JsonValue(number);
+        } else {
+            fail("expected a path or literal");
+        }
+        return operand;
+    }
+
+    int add(Expression expression) {
+        m_expressions.push_back(std::move(expression));
+        return static_cast<int>(m_expressions.size() - 1);
+    }
+
+    int parseOr() {
+        int left = parseAnd();
+        while (skipBlanks(), m_text.compare(m_pos, 2, "||") == 0) {
+            m_pos += 2;
+            Expression expression(Expression::Or);
+            expression.left = left;
+            expression.right = parseAnd();
+            left = add(std::move(expression));
+        }
+        return left;
+    }
+
+    int parseAnd() {
+        int left = parseUnary();
+        while (skipBlanks(), m_text.compare(m_pos, 2, "&&") == 0) {
+            m_pos += 2;
+            Expression expression(Expression::And);
+            expression.left = left;
+            expression.right = parseUnary();
+            left = add(std::move(expression));
+        }
+        return left;
+    }
+
+    int parseUnary() {
+        skipBlanks();
+        if (current() == '!' && m_text.compare(m_pos, 2, "!=") != 0) {
+            m_pos++;
+            Expression expression(Expression::Not);
+            expression.left = parseUnary();
+            return add(std::move(expression));
+        }
+        if (consume('(')) {
+            int inner = parseOr();
+            expect(')');
+            return inner;
+        }
+
+        Expression expression(Expression::Exists);
+        expression.first = parseOperand();
+        skipBlanks();
+        static const char* operators[] = { "==", "!=", "<=", ">=", "<", ">" };
+        static const Comparison comparisons[] = { Comparison::Equal, Comparison::NotEqual, Comparison::LessEqual,
+                                                  Comparison::GreaterEqual, Comparison::Less, Comparison::Greater };
+        for (size_t i = 0; i < 6; i++) {
+            size_t length = i < 4 ? 2 : 1;
+            if (m_text.compare(m_pos, length, operators[i]) == 0) {
+                m_pos += length;
+                expression.kind = Expression::Compare;
+                expression.comparison = comparisons[i];
+                expression.second = parseOperand();
+                return add(std::move(expression));
+            }
+        }
+        if (!expression.first.isPath)
+            fail("a literal alone is not a test");
+        return add(std::move(expression));
+    }
+
+public:
+    QueryCompiler(const std::string& text, std::vector<Segment>& segments, std::vector<Expression>& expressions) noexcept
+        : m_text(text), m_segments(segments), m_expressions(expressions) {}
+
+    void compile() {
+        if (current() != '$')
+            fail("expected '$'");
+        m_pos++;
+        while (!atEnd()) {
+            skipBlanks(); // Blanks separate segments, they may not end the query
+            if (atEnd())
+                fail("expected a segment");
+            parseSegment();
+        }
+    }
+};
+
+} // namespace
+
+const Json::JsonValue* Json::Query::Program::resolve(const Operand& operand, const Json::JsonValue& current) const {
+    if (!operand.isPath)
+        return &operand.literal;
+    const Json::JsonValue* value = &current;
+    for (const PathToken& token : operand.path) {
+        if (!token.isIndex) {
+            value = value->find(token.name);
+        } else if (value->isArray()) {
+            const Json::JsonArray& array = value->toArray();
+            long long index = token.index >= 0 ? token.index : static_cast<long long>(array.size()) + token.index;
+            value = index >= 0 && index < static_cast<long long>(array.size()) ? &array[static_cast<size_t>(index)] : nullptr;
+        } else {
+            value = nullptr;
+        }
+        if (!value)
+            return nullptr;
+    }
+    return value;
+}
+
+bool Json::Query::Program::test(int index, const Json::JsonValue& current) const {
+    const Expression& expression = expressions[static_cast<size_t>(index)];
+    switch (expression.kind) {
+        case Expression::Or: return test(expression.left, current) || test(expression.right, current);
+        case Expression::And: return test(expression.left, current) && test(expression.right, current);
+        case Expression::Not: return !test(expression.left, current);
+        case Expression::Exists: return resolve(expression.first, current) != nullptr;
+        case Expression::Compare: break;
+    }
+
+    const Json::JsonValue* left = resolve(expression.first, current);
+    const Json::JsonValue* right = resolve(expression.second, current);
+    bool equal;
+    if (!left || !right) {
+        equal = !left && !right; // Two missing values are equal, as in RFC 9535
+    } else if (isNumber(*left) && isNumber(*right)) {
+        double a = numberOf(*left);
+        double b = numberOf(*right);
+        switch (expression.comparison) {
+            case Comparison::Less: return a < b;
+            case Comparison::LessEqual: return a <= b;
+            case Comparison::Greater: return a > b;
+            case Comparison::GreaterEqual: return a >= b;
+            default: equal = a == b;
+        }
+    } else if (left->isString() && right->isString()) {
+        int order = left->toString().compare(right->toString());
+        switch (expression.comparison) {
+            case Comparison::Less: return order < 0;
+            case Comparison::LessEqual: return order <= 0;
+            case Comparison::Greater: return order > 0;
+            case Comparison::GreaterEqual: return order >= 0;
+            default: equal = order == 0;
+        }
+    } else {
+        equal = *left == *right;
+    }
+
+    // Only equality is defined for the remaining types
+    switch (expression.comparison) {
+        case Comparison::Equal: case Comparison::LessEqual: case Comparison::GreaterEqual: return equal;
+        case Comparison::NotEqual: return !equal;
+        default: return false;
+    }
+}
+
+namespace {
+
+// Position of a child within the nodes one selector picks, slices with a negative step pick backwards
+inline long long rank(const Selector& selector, size_t index) noexcept {
+    return selector.kind == Selector::Slice && selector.step < 0 ? -static_cast<long long>(index) : static_cast<long long>(index);
+}
+
+} // namespace
+
+void Json::Query::Program::select(const Segment& segment, const Json::JsonValue& value, std::vector<const Json::JsonValue*>& nodes) const {
+    if (!value.isObject() && !value.isArray())
+        return;
+    for (const Selector& selector : segment.selectors) {
+        switch (selector.kind) {
+            case Selector::Name: {
+                const Json::JsonValue* child = value.find(selector.name);
+                if (child)
+                    nodes.push_back(child);
+                break;
+            }
+            case Selector::Wildcard:
+            case Selector::Filter:
+                if (value.isObject()) {
+                    value.forEachMember([&](const std::string&, const Json::JsonValue& member) {
+                        if (selector.kind == Selector::Wildcard || test(selector.filter, member))
+                            nodes.push_back(&member);
+                        return true;
+                    });
+                } else {
+                    for (const Json::JsonValue& element : value.toArray()) {
+                        if (selector.kind == Selector::Wildcard || test(selector.filter, element))
+                            nodes.push_back(&element);
+                    }
+                }
+                break;
+            case Selector::Index: {
+                if (!value.isArray())
+                    break;
+                const Json::JsonArray& array = value.toArray();
+                long long length = static_cast<long long>(array.size());
+                long long index = selector.index < 0 ? length + selector.index : selector.index;
+                if (index >= 0 && index < length)
+                    nodes.push_back(&array[static_cast<size_t>(index)]);
+                break;
+            }
+            case Selector::Slice: {
+                if (!value.isArray())
+                    break;
+                const Json::JsonArray& array = value.toArray();
+                long long lower = 0;
+                long long upper = 0;
+                sliceBounds(selector, static_cast<long long>(array.size()), lower, upper);
+                if (selector.step > 0) {
+                    for (long long i = lower; i < upper; i += selector.step) {
+                        nodes.push_back(&array[static_cast<size_t>(i)]);
+                    }
+                } else if (selector.step < 0) {
+                    for (long long i = upper; i > lower; i += selector.step) {
+                        nodes.push_back(&array[static_cast<size_t>(i)]);
+                    }
+                }
+                break;
+            }
+        }
+    }
+}
+
+void Json::Query::Program::selectDescendants(const Segment& segment, const Json::JsonValue& value, std::vector<const Json::JsonValue*>& nodes) const {
+    select(segment, value, nodes);
+    if (value.isObject()) {
+        value.forEachMember([&](const std::string&, const Json::JsonValue& member) {
+            selectDescendants(segment, member, nodes);
+            return true;
+        });
+    } else if (value.isArray() && !value.isPacked()) {
+        // Numbers of a packed array have no descendants to select from
+        value.forEachElement([&](size_t, const Json::JsonValue& element) {
+            selectDescendants(segment, element, nodes);
+            return true;
+        });
+    }
+}
+
+bool Json::Query::Program::selects(const Selector& selector, const std::string* key, size_t index, long long length, const Json::JsonValue* child) const {
+    switch (selector.kind) {
+        case Selector::Name: return key && *key == selector.name.name();
+        case Selector::Wildcard: return true;
+        case Selector::Index:
+            return !key && (selector.index >= 0 ? static_cast<long long>(index) == selector.index : static_cast<long long>(index) == length + selector.index);
+        case Selector::Slice: return !key && inSlice(selector, static_cast<long long>(index), length);
+        case Selector::Filter: return test(selector.filter, *child);
+    }
+    return false;
+}
+
+// Routes of a child: descendant segments stay active, every selector that picks the child moves a route one further
+void Json::Query::Program::advance(const std::vector<Route>& routes, long long visit, const std::string* key, size_t index, long long length,
+                                   const Json::JsonValue* child, std::vector<Route>& next) const {
+    for (const Route& route : routes) {
+        const Segment& segment = segments[route.segment];
+        if (segment.descendant)
+            next.push_back(route);
+        for (size_t i = 0; i < segment.selectors.size(); i++) {
+            const Selector& selector = segment.selectors[i];
+            if (!selects(selector, key, index, length, child))
+                continue;
+            Route reached = { route.segment + 1, route.order };
+            if (segment.descendant)
+                reached.order.push_back(visit);
+            reached.order.push_back(static_cast<long long>(i));
+            reached.order.push_back(rank(selector, index));
+            next.push_back(std::move(reached));
+        }
+    }
+}
+
+bool Json::Query::Program::needs(const std::vector<Route>& routes, bool Segment::*flag) const noexcept {
+    for (const Route& route : routes) {
+        if (route.segment < segments.size() && segments[route.segment].*flag)
+            return true;
+    }
+    return false;
+}
+
+void Json::Query::Program::walkTree(const Json::JsonValue& value, std::vector<Route> routes, StreamState& state, size_t stored) const {
+    // Routes past the last segment are matches, one stored copy serves all of them
+    auto ended = std::stable_partition(routes.begin(), routes.end(), [this](const Route& route) { return route.segment < segments.size(); });
+    if (ended != routes.end()) {
+        if (stored == std::string::npos) {
+            stored = state.values.size();
+            state.values.push_back(value);
+        }
+        for (auto it = ended; it != routes.end(); ++it) {
+            state.matches.push_back({ std::move(it->order), stored });
+        }
+        routes.erase(ended, routes.end());
+    }
+    long long visit = state.visits++;
+    if (routes.empty())
+        return;
+
+    if (value.isObject()) {
+        size_t index = 0;
+        value.forEachMember([&](const std::string& key, const Json::JsonValue& member) {
+            std::vector<Route> next;
+            advance(routes, visit, &key, index++, 0, &member, next);
+            if (!next.empty())
+                walkTree(member, std::move(next), state, std::string::npos);
+            return true;
+        });
+    } else if (value.isArray()) {
+        long long length = static_cast<long long>(value.size());
+        value.forEachElement([&](size_t i, const Json::JsonValue& element) {
+            std::vector<Route> next;
+            advance(routes, visit, nullptr, i, length, &element, next);
+            if (!next.empty())
+                walkTree(element, std::move(next), state, std::string::npos);
+            return true;
+        });
+    }
+}
+
+// Continues on a value that had to be read, a match keeps it without another copy
+void Json::Query::Program::walkRead(Json::JsonValue&& value, std::vector<Route> routes, StreamState& state) const {
+    for (const Route& route : routes) {
+        if (route.segment == segments.size()) {
+            size_t stored = state.values.size();
+            state.values.push_back(std::move(value));
+            walkTree(state.values[stored], std::move(routes), state, stored);
+            return;
+        }
+    }
+    walkTree(value, std::move(routes), state, std::string::npos);
+}
+
+void Json::Query::Program::walkStream(Json::Detail::TextReader& reader, std::vector<Route> routes, StreamState& state) const {
+    bool ended = false;
+    for (const Route& route : routes) {
+        ended |= route.segment == segments.size();
+    }
+    char next = reader.peek();
+    if (ended || (next == '[' && needs(routes, &Segment::needsLength))) {
+        walkRead(reader.readValue(), std::move(routes), state);
+        return;
+    }
+
+    long long visit = state.visits++;
+    if (next == '{') {
+        bool filtered = needs(routes, &Segment::hasFilter);
+        reader.beginObject();
+        size_t index = 0;
+        for (bool first = true; reader.nextMember(first); first = false, index++) {
+            std::vector<Route> childRoutes;
+            if (filtered) {
+                std::string key = reader.key();
+                Json::JsonValue child = reader.readValue();
+                advance(routes, visit, &key, index, 0, &child, childRoutes);
+                if (!childRoutes.empty())
+                    walkRead(std::move(child), std::move(childRoutes), state);
+                continue;
+            }
+            advance(routes, visit, &reader.key(), index, 0, nullptr, childRoutes);
+            if (childRoutes.empty()) {
+                reader.skipValue();
+            } else {
+                walkStream(reader, std::move(childRoutes), state);
+            }
+        }
+    } else if (next == '[') {
+        bool filtered = needs(routes, &Segment::hasFilter);
+        reader.beginArray();
+        for (size_t i = 0; reader.nextElement(i == 0); i++) {
+            std::vector<Route> childRoutes;
+            if (filtered) {
+                Json::JsonValue child = reader.readValue();
+                advance(routes, visit, nullptr, i, unknownLength, &child, childRoutes);
+                if (!childRoutes.empty())
+                    walkRead(std::move(child), std::move(childRoutes), state);
+                continue;
+            }
+            advance(routes, visit, nullptr, i, unknownLength, nullptr, childRoutes);
+            if (childRoutes.empty()) {
+                reader.skipValue();
+            } else {
+                walkStream(reader, std::move(childRoutes), state);
+            }
+        }
+    } else {
+        reader.skipValue();
+    }
+}
+
+Json::Query::Query(std::unique_ptr<const Program> program) noexcept : m_program(std::move(program)) {}
+Json::Query::Query(Query&& other) noexcept = default;
+Json::Query& Json::Query::operator=(Query&& other) noexcept = default;
+Json::Query::~Query() = default;
+
+Json::Query Json::Query::compile(const std::string& expression) {
+    std::unique_ptr<Program> program(new Program());
+    QueryCompiler compiler(expression, program->segments, program->expressions);
+    compiler.compile();
+    return Query(std::move(program));
+}
+
+std::vector<const Json::JsonValue*> Json::Query::evaluate(const JsonValue& document) const {
+    // Nodelists per segment, as in RFC 9535
+    std::vector<const JsonValue*> nodes(1, &document);
+    std::vector<const JsonValue*> next;
+    for (const Segment& segment : m_program->segments) {
+        next.clear();
+        for (const JsonValue* node : nodes) {
+            if (segment.descendant) {
+                m_program->selectDescendants(segment, *node, next);
+            } else {
+                m_program->select(segment, *node, next);
+            }
+        }
+        nodes.swap(next);
+    }
+    return nodes;
+}
+
+std::vector<Json::JsonValue> Json::Query::evaluateJson(const std::string& json) const {
+    StreamState state;
+    Json::Detail::TextReader reader(json.data(), json.length());
+    m_program->walkStream(reader, std::vector<Route>(1, Route{ 0, std::vector<long long>() }), state);
+    reader.finish();
+
+    // Matches arrive in document order, their recorded order puts them into nodelist order
+    std::stable_sort(state.matches.begin(), state.matches.end(), [](const StreamMatch& a, const StreamMatch& b) { return a.order < b.order; });
+    std::vector<size_t> uses(state.values.size(), 0);
+    for (const StreamMatch& match : state.matches) {
+        uses[match.value]++;
+    }
+    std::vector<JsonValue> results;
+    results.reserve(state.matches.size());
+    for (const StreamMatch& match : state.matches) {
+        if (--uses[match.value] == 0) {
+            results.push_back(std::move(state.values[match.value]));
+        } else {
+            results.push_back(state.values[match.value]);
+        }
+    }
+    return results;
+}
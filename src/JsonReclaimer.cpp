@@ -0,0 +1,74 @@
+#include "json/JsonParser.h"
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+namespace {
+
+// Background thread that frees documents handed to releaseAsync. Started on first use and never stopped,
+// whatever is still queued when the process exits is left to the operating system
+class Reclaimer {
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_queued;
+    std::condition_variable m_drained;
+    std::deque<Json::JsonValue> m_queue;
+    size_t m_inFlight = 0; // Queued plus currently being freed
+
+    void run() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_queued.wait(lock, [this]() { return !m_queue.empty(); });
+            Json::JsonValue value = std::move(m_queue.front());
+            m_queue.pop_front();
+
+            lock.unlock();
+            value = Json::JsonValue(); // Free outside the lock
+            lock.lock();
+
+            if (--m_inFlight == 0) {
+                m_drained.notify_all();
+            }
+        }
+    }
+
+public:
+    Reclaimer() {
+        std::thread(&Reclaimer::run, this).detach();
+    }
+
+    void push(Json::JsonValue&& value) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queue.push_back(std::move(value));
+            m_inFlight++;
+        }
+        m_queued.notify_one();
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_drained.wait(lock, [this]() { return m_inFlight == 0; });
+    }
+};
+
+} // namespace
+
+static Reclaimer& reclaimer() {
+    // Never destroyed, the detached thread keeps using it until the process ends
+    static Reclaimer* instance = new Reclaimer();
+    return *instance;
+}
+
+void Json::releaseAsync(JsonValue&& value) {
+    if (!value.isObject() && !value.isArray()) {
+        // Scalars and strings are freed right away, cheaper than a hand off
+        JsonValue released(std::move(value));
+        return;
+    }
+    reclaimer().push(std::move(value));
+}
+
+void Json::waitForReleases() {
+    reclaimer().wait();
+}
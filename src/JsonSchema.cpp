@@ -0,0 +1,963 @@
+#include "json/JsonSchema.h"
+#include "json/JsonBind.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <regex>
+
+namespace {
+
+constexpr size_t unlimited = static_cast<size_t>(-1);
+constexpr int noNode = -1;
+
+constexpr unsigned nullBit = 1u << 0;
+constexpr unsigned boolBit = 1u << 1;
+constexpr unsigned integerBit = 1u << 2;
+constexpr unsigned numberBit = 1u << 3; // Non integral numbers, "number" allows both
+constexpr unsigned stringBit = 1u << 4;
+constexpr unsigned arrayBit = 1u << 5;
+constexpr unsigned objectBit = 1u << 6;
+constexpr unsigned allTypes = (1u << 7) - 1;
+
+inline unsigned typeBits(Json::JsonType type) noexcept {
+    switch (type) {
+        case Json::JsonType::Bool: return boolBit;
+        case Json::JsonType::Integer: return integerBit;
+        case Json::JsonType::Double: return numberBit;
+        case Json::JsonType::String: return stringBit;
+        case Json::JsonType::Array: return arrayBit;
+        case Json::JsonType::Object: return objectBit;
+        default: return nullBit;
+    }
+}
+
+// Integral doubles count as integers, like 1.0 in the specification
+inline unsigned numberBits(bool isInteger, double value) noexcept {
+    return isInteger || std::floor(value) == value ? integerBit | numberBit : numberBit;
+}
+
+std::string typeNames(unsigned types) {
+    static const char* names[] = { "null", "boolean", "integer", "number", "string", "array", "object" };
+    std::string result;
+    for (unsigned i = 0; i < 7; i++) {
+        if (!(types & (1u << i)) || (i == 2 && (types & numberBit)))
+            continue;
+        if (!result.empty())
+            result += " or ";
+        result += names[i];
+    }
+    return result;
+}
+
+std::string formatNumber(double value) {
+    return Json::toJsonString(Json::JsonValue(value));
+}
+
+inline bool isNumber(const Json::JsonValue& value) noexcept {
+    return value.isInt() || value.isDouble();
+}
+
+inline double numberValue(const Json::JsonValue& value) {
+    return value.isInt() ? value.toInt() : value.toDouble();
+}
+
+// Instance equality of the specification: numbers compare by value at every depth, so 1 and 1.0 are equal
+bool instanceEquals(const Json::JsonValue& a, const Json::JsonValue& b) {
+    if (isNumber(a) && isNumber(b))
+        return numberValue(a) == numberValue(b);
+    if (a.type() != b.type())
+        return false;
+    if (a.isArray()) {
+        const Json::JsonArray& right = b.toArray();
+        return a.size() == right.size() &&
+               a.forEachElement([&right](size_t i, const Json::JsonValue& element) { return instanceEquals(element, right[i]); });
+    }
+    if (a.isObject()) {
+        return a.size() == b.size() && a.forEachMember([&b](const std::string& key, const Json::JsonValue& member) {
+            const Json::JsonValue* counterpart = b.find(Json::Key(key));
+            return counterpart && instanceEquals(member, *counterpart);
+        });
+    }
+    return a == b;
+}
+
+inline uint64_t combineHash(uint64_t seed, uint64_t value) noexcept {
+    return seed ^ (value + 0x9E3779B97F4A7C15ULL + (seed << 6) + (seed >> 2));
+}
+
+// Hash that agrees with instanceEquals, numbers are hashed by their double value
+uint64_t instanceHash(const Json::JsonValue& value) {
+    switch (value.type()) {
+        case Json::JsonType::Integer:
+        case Json::JsonType::Double: {
+            double number = numberValue(value);
+            if (number == 0.0)
+                number = 0.0; // -0.0 equals 0.0
+            uint64_t bits = 0;
+            std::memcpy(&bits, &number, sizeof(bits));
+            return combineHash(3, bits);
+        }
+        case Json::JsonType::Bool: return combineHash(2, value.toBool());
+        case Json::JsonType::String: return combineHash(4, Json::hashKey(value.toString().data(), value.toString().length()));
+        case Json::JsonType::Array: {
+            uint64_t hash = 5;
+            value.forEachElement([&hash](size_t, const Json::JsonValue& element) {
+                hash = combineHash(hash, instanceHash(element));
+                return true;
+            });
+            return hash;
+        }
+        case Json::JsonType::Object: {
+            uint64_t members = 0; // Order independent
+            value.forEachMember([&members](const std::string& key, const Json::JsonValue& member) {
+                members += combineHash(Json::hashKey(key.data(), key.length()), instanceHash(member));
+                return true;
+            });
+            return combineHash(6, members);
+        }
+        default: return 1;
+    }
+}
+
+struct Property {
+    int node; // noNode for keys that are only required
+    int requiredIndex; // -1 for optional keys
+};
+
+// One compiled (sub)schema. Indices refer to other nodes of the program
+struct Node {
+    bool never = false;
+    int alias = noNode; // Plain $ref, resolved to a node without alias after compiling
+    unsigned types = allTypes;
+
+    bool hasEnum = false;
+    std::vector<Json::JsonValue> enumValues;
+    std::vector<uint64_t> enumHashes; // instanceHash of each value
+    bool hasConst = false;
+    Json::JsonValue constValue;
+
+    bool hasMinimum = false;
+    bool hasMaximum = false;
+    bool exclusiveMinimum = false;
+    bool exclusiveMaximum = false;
+    double minimum = 0.0;
+    double maximum = 0.0;
+    double multipleOf = 0.0;
+
+    size_t minLength = 0;
+    size_t maxLength = unlimited;
+    const std::regex* pattern = nullptr;
+    std::string patternSource;
+
+    size_t minItems = 0;
+    size_t maxItems = unlimited;
+    std::vector<int> prefixItems;
+    int items = noNode;
+    int contains = noNode;
+    size_t minContains = 1;
+    size_t maxContains = unlimited;
+    bool uniqueItems = false;
+
+    size_t minProperties = 0;
+    size_t maxProperties = unlimited;
+    std::unordered_map<std::string, Property> properties;
+    std::vector<Json::Key> required; // Prehashed, looked up in shaped records without materializing them
+    std::vector<std::pair<const std::regex*, int>> patternProperties;
+    int additionalProperties = noNode;
+    int propertyNames = noNode;
+
+    std::vector<int> allOf;
+    std::vector<int> anyOf;
+    std::vector<int> oneOf;
+    int negated = noNode;
+    int condition = noNode;
+    int thenNode = noNode;
+    int elseNode = noNode;
+
+    bool needsTree = false; // Streaming validation parses the subtree first
+};
+
+// Required keys seen in one object, inline up to 64 of them
+class KeySet {
+private:
+    uint64_t m_bits = 0;
+    std::vector<bool> m_more;
+
+public:
+    explicit KeySet(size_t count) : m_more(count > 64 ? count : 0) {}
+
+    inline void set(size_t index) {
+        if (m_more.empty()) {
+            m_bits |= 1ULL << index;
+        } else {
+            m_more[index] = true;
+        }
+    }
+
+    inline bool test(size_t index) const { return m_more.empty() ? (m_bits >> index) & 1 : m_more[index]; }
+};
+
+std::string escapePointerSegment(const std::string& segment) {
+    std::string result;
+    for (char c : segment) {
+        if (c == '~') {
+            result += "~0";
+        } else if (c == '/') {
+            result += "~1";
+        } else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+template <typename Message>
+bool fail(Json::SchemaError* error, const Message& message) {
+    if (error) {
+        error->path.clear();
+        error->message = message();
+    }
+    return false;
+}
+
+// Called while a failure unwinds, builds the path from the innermost segment outwards
+inline bool failAt(Json::SchemaError* error, const std::string& segment) {
+    if (error)
+        error->path.insert(0, "/" + escapePointerSegment(segment));
+    return false;
+}
+
+} // namespace
+
+struct Json::Schema::Program {
+    std::vector<Node> nodes;
+    std::unordered_map<std::string, std::unique_ptr<std::regex>> patterns; // By source, shared between nodes
+
+    inline const Node& node(int index) const noexcept {
+        const Node& node = nodes[static_cast<size_t>(index)];
+        return node.alias == noNode ? node : nodes[static_cast<size_t>(node.alias)];
+    }
+
+    bool matchesEnum(const Node& node, const Json::JsonValue& value) const;
+    bool checkNumber(const Node& node, bool isInteger, int intValue, double doubleValue, Json::SchemaError* error) const;
+    bool checkString(const Node& node, const std::string& value, Json::SchemaError* error) const;
+    bool checkCombinators(const Node& node, const Json::JsonValue& value, Json::SchemaError* error) const;
+    bool validate(const Json::JsonValue& value, int index, Json::SchemaError* error) const;
+    bool validateMember(const Node& node, const std::string& key, const Json::JsonValue& value, Json::SchemaError* error) const;
+    bool validateStream(Json::Detail::TextReader& reader, int index, Json::SchemaError* error) const;
+    bool validateStreamMember(const Node& node, Json::Detail::TextReader& reader, KeySet& seen, Json::SchemaError* error) const;
+};
+
+namespace {
+
+class SchemaCompiler {
+private:
+    const Json::JsonValue& m_root;
+    std::vector<Node>& m_nodes;
+    std::unordered_map<std::string, std::unique_ptr<std::regex>>& m_patterns;
+    std::unordered_map<std::string, int> m_compiled; // Node of each json pointer, also breaks $ref cycles
+
+    [[noreturn]] static void invalid(const std::string& pointer, const std::string& message) {
+        throw Json::JsonMalformedException("Invalid schema at " + pointer + ": " + message);
+    }
+
+    static double number(const Json::JsonValue& value, const std::string& pointer) {
+        if (value.isInt())
+            return value.toInt();
+        if (value.isDouble())
+            return value.toDouble();
+        invalid(pointer, "expected a number");
+    }
+
+    static size_t count(const Json::JsonValue& value, const std::string& pointer) {
+        double result = number(value, pointer);
+        if (result < 0 || std::floor(result) != result)
+            invalid(pointer, "expected a non negative integer");
+        return static_cast<size_t>(result);
+    }
+
+    const std::regex* regex(const Json::JsonValue& value, const std::string& pointer) {
+        if (!value.isString())
+            invalid(pointer, "expected a regular expression string");
+        std::unique_ptr<std::regex>& slot = m_patterns[value.toString()];
+        if (!slot) {
+            try {
+                slot.reset(new std::regex(value.toString(), std::regex::ECMAScript));
+            } catch (const std::regex_error& e) {
+                m_patterns.erase(value.toString());
+                invalid(pointer, std::string("bad regular expression: ") + e.what());
+            }
+        }
+        return slot.get();
+    }
+
+    std::vector<int> compileList(const Json::JsonValue& list, const std::string& pointer) {
+        if (!list.isArray() || list.toArray().empty())
+            invalid(pointer, "expected a non empty array of schemas");
+        std::vector<int> result;
+        for (size_t i = 0; i < list.toArray().size(); i++) {
+            result.push_back(compile(list.toArray()[i], pointer + "/" + std::to_string(i)));
+        }
+        return result;
+    }
+
+    unsigned typeNamed(const Json::JsonValue& name, const std::string& pointer) {
+        static const char* names[] = { "null", "boolean", "integer", "number", "string", "array", "object" };
+        static const unsigned bits[] = { nullBit, boolBit, integerBit, integerBit | numberBit, stringBit, arrayBit, objectBit };
+        if (name.isString()) {
+            for (size_t i = 0; i < 7; i++) {
+                if (name.toString() == names[i])
+                    return bits[i];
+            }
+        }
+        invalid(pointer, "unknown type");
+    }
+
+    // Local references only: "#" or a json pointer like "#/$defs/item"
+    int resolveReference(const Json::JsonValue& reference, const std::string& pointer) {
+        if (!reference.isString())
+            invalid(pointer, "expected a reference string");
+        const std::string& text = reference.toString();
+        if (text.empty() || text[0] != '#' || (text.length() > 1 && text[1] != '/'))
+            invalid(pointer, "only references into the same document are supported, got " + text);
+
+        const Json::JsonValue* target = &m_root;
+        std::string canonical = "#";
+        size_t pos = 1;
+        while (pos < text.length()) {
+            size_t end = text.find('/', pos + 1);
+            if (end == std::string::npos)
+                end = text.length();
+            std::string segment;
+            for (size_t i = pos + 1; i < end; i++) {
+                if (text[i] == '~' && i + 1 < end && (text[i + 1] == '0' || text[i + 1] == '1')) {
+                    segment += text[++i] == '0' ? '~' : '/';
+                } else if (text[i] == '%' && i + 2 < end && isxdigit(text[i + 1]) && isxdigit(text[i + 2])) {
+                    segment += static_cast<char>(std::stoi(text.substr(i + 1, 2), nullptr, 16));
+                    i += 2;
+                } else {
+                    segment += text[i];
+                }
+            }
+            if (target->isObject() && target->toObject().count(segment)) {
+                target = &target->at(segment);
+            } else if (target->isArray() && !segment.empty() && segment.find_first_not_of("0123456789") == std::string::npos &&
+                       std::stoul(segment) < target->toArray().size()) {
+                target = &target->at(std::stoul(segment));
+            } else {
+                invalid(pointer, "unresolvable reference " + text);
+            }
+            canonical += "/" + escapePointerSegment(segment);
+            pos = end;
+        }
+        return compile(*target, canonical);
+    }
+
+    void compileKeywords(const Json::JsonObject& schema, Node& node, const std::string& pointer);
+
+public:
+    SchemaCompiler(const Json::JsonValue& root, std::vector<Node>& nodes, std::unordered_map<std::string, std::unique_ptr<std::regex>>& patterns) noexcept
+        : m_root(root), m_nodes(nodes), m_patterns(patterns) {}
+
+    int compile(const Json::JsonValue& schema, const std::string& pointer) {
+        auto known = m_compiled.find(pointer);
+        if (known != m_compiled.end())
+            return known->second;
+
+        int index = static_cast<int>(m_nodes.size());
+        m_nodes.emplace_back();
+        m_compiled.emplace(pointer, index);
+
+        Node node; // Built aside, compiling children grows the node vector
+        if (schema.isBool()) {
+            node.never = !schema.toBool();
+        } else if (schema.isObject()) {
+            compileKeywords(schema.toObject(), node, pointer);
+        } else {
+            invalid(pointer, "expected an object or a boolean");
+        }
+        m_nodes[static_cast<size_t>(index)] = std::move(node);
+        return index;
+    }
+
+    // Replaces alias chains by their final node and orders the combinators by their estimated cost
+    void finish() {
+        std::vector<Node>& nodes = m_nodes;
+        for (Node& node : nodes) {
+            size_t steps = 0;
+            while (node.alias != noNode && nodes[static_cast<size_t>(node.alias)].alias != noNode) {
+                if (++steps > nodes.size())
+                    throw Json::JsonMalformedException("Invalid schema: circular $ref");
+                node.alias = nodes[static_cast<size_t>(node.alias)].alias;
+            }
+        }
+
+        std::vector<int> costs(nodes.size(), -1);
+        for (Node& node : nodes) {
+            auto cheaper = [this, &costs](int a, int b) { return cost(a, costs) < cost(b, costs); };
+            std::stable_sort(node.allOf.begin(), node.allOf.end(), cheaper);
+            std::stable_sort(node.anyOf.begin(), node.anyOf.end(), cheaper);
+        }
+    }
+
+    // Rough number of checks below a node, recursive schemas count as expensive
+    int cost(int index, std::vector<int>& costs) const {
+        size_t resolved = static_cast<size_t>(m_nodes[static_cast<size_t>(index)].alias == noNode ? index : m_nodes[static_cast<size_t>(index)].alias);
+        const Node& node = m_nodes[resolved];
+        int& slot = costs[resolved];
+        if (slot == -2)
+            return 1000;
+        if (slot >= 0)
+            return slot;
+        slot = -2;
+        int total = 1 + static_cast<int>(node.enumValues.size() + node.properties.size() + node.patternProperties.size());
+        total += node.pattern ? 10 : 0;
+        for (const std::vector<int>* list : { &node.prefixItems, &node.allOf, &node.anyOf, &node.oneOf }) {
+            for (int child : *list) {
+                total += cost(child, costs);
+            }
+        }
+        for (int child : { node.items, node.contains, node.additionalProperties, node.propertyNames, node.negated, node.condition,
+                           node.thenNode, node.elseNode }) {
+            if (child != noNode)
+                total += cost(child, costs);
+        }
+        for (const auto& property : node.properties) {
+            if (property.second.node != noNode)
+                total += cost(property.second.node, costs);
+        }
+        slot = std::min(total, 1000);
+        return slot;
+    }
+};
+
+void SchemaCompiler::compileKeywords(const Json::JsonObject& schema, Node& node, const std::string& pointer) {
+    auto keyword = [&schema](const char* name) -> const Json::JsonValue* {
+        auto it = schema.find(name);
+        return it == schema.end() ? nullptr : &it->second;
+    };
+    auto at = [&pointer](const char* name) { return pointer + "/" + name; };
+    const Json::JsonValue* value = nullptr;
+
+    if ((value = keyword("type"))) {
+        if (value->isArray()) {
+            node.types = 0;
+            for (const Json::JsonValue& name : value->toArray()) {
+                node.types |= typeNamed(name, at("type"));
+            }
+        } else {
+            node.types = typeNamed(*value, at("type"));
+        }
+    }
+    if ((value = keyword("enum"))) {
+        if (!value->isArray())
+            invalid(at("enum"), "expected an array");
+        node.hasEnum = true;
+        node.enumValues.assign(value->toArray().begin(), value->toArray().end());
+    }
+    for (const Json::JsonValue& option : node.enumValues) {
+        node.enumHashes.push_back(instanceHash(option));
+    }
+    if ((value = keyword("const"))) {
+        node.hasConst = true;
+        node.constValue = *value;
+    }
+
+    if ((value = keyword("minimum"))) {
+        node.hasMinimum = true;
+        node.minimum = number(*value, at("minimum"));
+    }
+    if ((value = keyword("maximum"))) {
+        node.hasMaximum = true;
+        node.maximum = number(*value, at("maximum"));
+    }
+    if ((value = keyword("exclusiveMinimum"))) {
+        if (value->isBool()) { // Draft 4 form, modifies minimum
+            node.exclusiveMinimum = value->toBool();
+        } else {
+            double bound = number(*value, at("exclusiveMinimum"));
+            if (!node.hasMinimum || bound >= node.minimum) {
+                node.hasMinimum = true;
+                node.exclusiveMinimum = true;
+                node.minimum = bound;
+            }
+        }
+    }
+    if ((value = keyword("exclusiveMaximum"))) {
+        if (value->isBool()) {
+            node.exclusiveMaximum = value->toBool();
+        } else {
+            double bound = number(*value, at("exclusiveMaximum"));
+            if (!node.hasMaximum || bound <= node.maximum) {
+                node.hasMaximum = true;
+                node.exclusiveMaximum = true;
+                node.maximum = bound;
+            }
+        }
+    }
+    if ((value = keyword("multipleOf"))) {
+        node.multipleOf = number(*value, at("multipleOf"));
+        if (node.multipleOf <= 0)
+            invalid(at("multipleOf"), "expected a number above 0");
+    }
+
+    if ((value = keyword("minLength")))
+        node.minLength = count(*value, at("minLength"));
+    if ((value = keyword("maxLength")))
+        node.maxLength = count(*value, at("maxLength"));
+    if ((value = keyword("pattern"))) {
+        node.pattern = regex(*value, at("pattern"));
+        node.patternSource = value->toString();
+    }
+
+    if ((value = keyword("prefixItems")))
+        node.prefixItems = compileList(*value, at("prefixItems"));
+    if ((value = keyword("items"))) {
+        if (value->isArray()) { // Draft 7 tuple form
+            node.prefixItems = compileList(*value, at("items"));
+            if ((value = keyword("additionalItems")))
+                node.items = compile(*value, at("additionalItems"));
+        } else {
+            node.items = compile(*value, at("items"));
+        }
+    }
+    if ((value = keyword("contains")))
+        node.contains = compile(*value, at("contains"));
+    if ((value = keyword("minContains")))
+        node.minContains = count(*value, at("minContains"));
+    if ((value = keyword("maxContains")))
+        node.maxContains = count(*value, at("maxContains"));
+    if ((value = keyword("minItems")))
+        node.minItems = count(*value, at("minItems"));
+    if ((value = keyword("maxItems")))
+        node.maxItems = count(*value, at("maxItems"));
+    if ((value = keyword("uniqueItems"))) {
+        if (!value->isBool())
+            invalid(at("uniqueItems"), "expected a boolean");
+        node.uniqueItems = value->toBool();
+    }
+
+    if ((value = keyword("properties"))) {
+        if (!value->isObject())
+            invalid(at("properties"), "expected an object");
+        for (const auto& member : value->toObject()) {
+            int child = compile(member.second, at("properties") + "/" + escapePointerSegment(member.first));
+            node.properties[member.first] = { child, -1 };
+        }
+    }
+    if ((value = keyword("required"))) {
+        if (!value->isArray())
+            invalid(at("required"), "expected an array of strings");
+        for (const Json::JsonValue& name : value->toArray()) {
+            if (!name.isString())
+                invalid(at("required"), "expected an array of strings");
+            auto slot = node.properties.emplace(name.toString(), Property{ noNode, -1 }).first;
+            if (slot->second.requiredIndex < 0) {
+                slot->second.requiredIndex = static_cast<int>(node.required.size());
+                node.required.push_back(Json::Key(name.toString()));
+            }
+        }
+    }
+    if ((value = keyword("patternProperties"))) {
+        if (!value->isObject())
+            invalid(at("patternProperties"), "expected an object");
+        for (const auto& member : value->toObject()) {
+            std::string memberPointer = at("patternProperties") + "/" + escapePointerSegment(member.first);
+            node.patternProperties.emplace_back(regex(Json::JsonValue(member.first), memberPointer), compile(member.second, memberPointer));
+        }
+    }
+    if ((value = keyword("additionalProperties")))
+        node.additionalProperties = compile(*value, at("additionalProperties"));
+    if ((value = keyword("propertyNames")))
+        node.propertyNames = compile(*value, at("propertyNames"));
+    if ((value = keyword("minProperties")))
+        node.minProperties = count(*value, at("minProperties"));
+    if ((value = keyword("maxProperties")))
+        node.maxProperties = count(*value, at("maxProperties"));
+
+    if ((value = keyword("allOf")))
+        node.allOf = compileList(*value, at("allOf"));
+    if ((value = keyword("anyOf")))
+        node.anyOf = compileList(*value, at("anyOf"));
+    if ((value = keyword("oneOf")))
+        node.oneOf = compileList(*value, at("oneOf"));
+    if ((value = keyword("not")))
+        node.negated = compile(*value, at("not"));
+    if ((value = keyword("if"))) {
+        node.condition = compile(*value, at("if"));
+        if ((value = keyword("then")))
+            node.thenNode = compile(*value, at("then"));
+        if ((value = keyword("else")))
+            node.elseNode = compile(*value, at("else"));
+    }
+
+    if ((value = keyword("$ref"))) {
+        int target = resolveReference(*value, at("$ref"));
+        bool onlyReference = node.types == allTypes && !node.hasEnum && !node.hasConst && !node.hasMinimum && !node.hasMaximum && node.multipleOf == 0 &&
+                             node.minLength == 0 && node.maxLength == unlimited && !node.pattern && node.prefixItems.empty() &&
+                             node.items == noNode && node.contains == noNode && node.minItems == 0 && node.maxItems == unlimited &&
+                             !node.uniqueItems && node.properties.empty() && node.patternProperties.empty() &&
+                             node.additionalProperties == noNode && node.propertyNames == noNode && node.minProperties == 0 &&
+                             node.maxProperties == unlimited && node.allOf.empty() && node.anyOf.empty() && node.oneOf.empty() &&
+                             node.negated == noNode && node.condition == noNode;
+        if (onlyReference) {
+            node.alias = target;
+        } else {
+            node.allOf.insert(node.allOf.begin(), target); // Keywords next to $ref apply as well, like in 2019-09 and later
+        }
+    }
+
+    node.needsTree = node.hasEnum || node.hasConst || node.uniqueItems || node.contains != noNode || !node.allOf.empty() || !node.anyOf.empty() ||
+                     !node.oneOf.empty() || node.negated != noNode || node.condition != noNode;
+}
+
+size_t countCodePoints(const std::string& value) noexcept {
+    size_t count = 0;
+    for (char c : value) {
+        count += (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+    }
+    return count;
+}
+
+} // namespace
+
+bool Json::Schema::Program::matchesEnum(const Node& node, const Json::JsonValue& value) const {
+    uint64_t hash = instanceHash(value);
+    for (size_t i = 0; i < node.enumValues.size(); i++) {
+        if (node.enumHashes[i] == hash && instanceEquals(node.enumValues[i], value))
+            return true;
+    }
+    return false;
+}
+
+bool Json::Schema::Program::checkNumber(const Node& node, bool isInteger, int intValue, double doubleValue, Json::SchemaError* error) const {
+    double value = isInteger ? intValue : doubleValue;
+    if (!(node.types & numberBits(isInteger, value)))
+        return fail(error, [&node]() { return "Expected " + typeNames(node.types) + ", found a number"; });
+    if (node.hasMinimum && (node.exclusiveMinimum ? value <= node.minimum : value < node.minimum)) {
+        return fail(error, [&node, value]() {
+            return formatNumber(value) + " is below the " + (node.exclusiveMinimum ? "exclusive " : "") + "minimum " + formatNumber(node.minimum);
+        });
+    }
+    if (node.hasMaximum && (node.exclusiveMaximum ? value >= node.maximum : value > node.maximum)) {
+        return fail(error, [&node, value]() {
+            return formatNumber(value) + " is above the " + (node.exclusiveMaximum ? "exclusive " : "") + "maximum " + formatNumber(node.maximum);
+        });
+    }
+    if (node.multipleOf > 0) {
+        double quotient = value / node.multipleOf;
+        if (std::fabs(quotient - std::round(quotient)) > 1e-9 * std::max(1.0, std::fabs(quotient)))
+            return fail(error, [&node, value]() { return formatNumber(value) + " is not a multiple of " + formatNumber(node.multipleOf); });
+    }
+    return true;
+}
+
+bool Json::Schema::Program::checkString(const Node& node, const std::string& value, Json::SchemaError* error) const {
+    if (!(node.types & stringBit))
+        return fail(error, [&node]() { return "Expected " + typeNames(node.types) + ", found a string"; });
+    if (node.minLength > 0 || node.maxLength != unlimited) {
+        size_t length = countCodePoints(value);
+        if (length < node.minLength)
+            return fail(error, [&node]() { return "String is shorter than " + std::to_string(node.minLength) + " characters"; });
+        if (length > node.maxLength)
+            return fail(error, [&node]() { return "String is longer than " + std::to_string(node.maxLength) + " characters"; });
+    }
+    if (node.pattern && !std::regex_search(value, *node.pattern))
+        return fail(error, [&node]() { return "String does not match the pattern " + node.patternSource; });
+    return true;
+}
+
+bool Json::Schema::Program::checkCombinators(const Node& node, const Json::JsonValue& value, Json::SchemaError* error) const {
+    for (int child : node.allOf) {
+        if (!validate(value, child, error))
+            return false;
+    }
+    if (!node.anyOf.empty()) {
+        bool matched = false;
+        for (int child : node.anyOf) {
+            if ((matched = validate(value, child, nullptr)))
+                break;
+        }
+        if (!matched)
+            return fail(error, []() { return std::string("Value matches none of the anyOf schemas"); });
+    }
+    if (!node.oneOf.empty()) {
+        size_t matches = 0;
+        for (int child : node.oneOf) {
+            if (validate(value, child, nullptr) && ++matches > 1)
+                break;
+        }
+        if (matches != 1)
+            return fail(error, [matches]() { return std::string(matches ? "Value matches more than one" : "Value matches none") + " of the oneOf schemas"; });
+    }
+    if (node.negated != noNode && validate(value, node.negated, nullptr))
+        return fail(error, []() { return std::string("Value matches the schema in not"); });
+    if (node.condition != noNode) {
+        int branch = validate(value, node.condition, nullptr) ? node.thenNode : node.elseNode;
+        if (branch != noNode && !validate(value, branch, error))
+            return false;
+    }
+    return true;
+}
+
+bool Json::Schema::Program::validateMember(const Node& node, const std::string& key, const Json::JsonValue& value, Json::SchemaError* error) const {
+    if (node.propertyNames != noNode && !validate(Json::JsonValue(key), node.propertyNames, error))
+        return failAt(error, key);
+    bool evaluated = false;
+    if (!node.properties.empty()) {
+        auto property = node.properties.find(key);
+        if (property != node.properties.end() && property->second.node != noNode) {
+            evaluated = true;
+            if (!validate(value, property->second.node, error))
+                return failAt(error, key);
+        }
+    }
+    for (const auto& pattern : node.patternProperties) {
+        if (std::regex_search(key, *pattern.first)) {
+            evaluated = true;
+            if (!validate(value, pattern.second, error))
+                return failAt(error, key);
+        }
+    }
+    if (!evaluated && node.additionalProperties != noNode && !validate(value, node.additionalProperties, error)) {
+        if (error && this->node(node.additionalProperties).never)
+            error->message = "Key \"" + key + "\" is not allowed";
+        return failAt(error, key);
+    }
+    return true;
+}
+
+bool Json::Schema::Program::validate(const Json::JsonValue& value, int index, Json::SchemaError* error) const {
+    const Node& node = this->node(index);
+    if (node.never)
+        return fail(error, []() { return std::string("No value is allowed here"); });
+    if (node.hasEnum && !matchesEnum(node, value))
+        return fail(error, []() { return std::string("Value is not one of the allowed values"); });
+    if (node.hasConst && !instanceEquals(node.constValue, value))
+        return fail(error, []() { return std::string("Value does not equal the constant"); });
+
+    switch (value.type()) {
+        case Json::JsonType::Integer:
+            if (!checkNumber(node, true, value.toInt(), 0.0, error))
+                return false;
+            break;
+        case Json::JsonType::Double:
+            if (!checkNumber(node, false, 0, value.toDouble(), error))
+                return false;
+            break;
+        case Json::JsonType::String:
+            if (!checkString(node, value.toString(), error))
+                return false;
+            break;
+        case Json::JsonType::Array: {
+            if (!(node.types & arrayBit))
+                return fail(error, [&node]() { return "Expected " + typeNames(node.types) + ", found an array"; });
+            // Packed arrays are read from their buffers, only uniqueItems needs references to the elements
+            size_t items = value.size();
+            if (items < node.minItems)
+                return fail(error, [&node]() { return "Array has fewer than " + std::to_string(node.minItems) + " items"; });
+            if (items > node.maxItems)
+                return fail(error, [&node]() { return "Array has more than " + std::to_string(node.maxItems) + " items"; });
+            size_t invalid = items;
+            value.forEachElement([&](size_t i, const Json::JsonValue& element) {
+                int child = i < node.prefixItems.size() ? node.prefixItems[i] : node.items;
+                if (child == noNode || validate(element, child, error))
+                    return true;
+                invalid = i;
+                return false;
+            });
+            if (invalid < items)
+                return failAt(error, std::to_string(invalid));
+            if (node.contains != noNode) {
+                size_t matches = 0;
+                value.forEachElement([&](size_t, const Json::JsonValue& element) {
+                    matches += validate(element, node.contains, nullptr);
+                    return matches <= node.maxContains;
+                });
+                if (matches < node.minContains || matches > node.maxContains)
+                    return fail(error, [matches]() { return "Array contains " + std::to_string(matches) + " matching items"; });
+            }
+            if (node.uniqueItems && items > 1) {
+                const Json::JsonArray& array = value.toArray();
+                std::vector<std::pair<uint64_t, size_t>> hashes;
+                hashes.reserve(array.size());
+                for (size_t i = 0; i < array.size(); i++) {
+                    hashes.emplace_back(instanceHash(array[i]), i);
+                }
+                std::sort(hashes.begin(), hashes.end());
+                for (size_t i = 1; i < hashes.size(); i++) {
+                    for (size_t j = i; j > 0 && hashes[j - 1].first == hashes[i].first; j--) {
+                        if (instanceEquals(array[hashes[j - 1].second], array[hashes[i].second]))
+                            return fail(error, []() { return std::string("Array items are not unique"); });
+                    }
+                }
+            }
+            break;
+        }
+        case Json::JsonType::Object: {
+            if (!(node.types & objectBit))
+                return fail(error, [&node]() { return "Expected " + typeNames(node.types) + ", found an object"; });
+            size_t members = value.size();
+            if (members < node.minProperties)
+                return fail(error, [&node]() { return "Object has fewer than " + std::to_string(node.minProperties) + " members"; });
+            if (members > node.maxProperties)
+                return fail(error, [&node]() { return "Object has more than " + std::to_string(node.maxProperties) + " members"; });
+            for (const Json::Key& key : node.required) {
+                if (!value.find(key))
+                    return fail(error, [&key]() { return "Missing required key \"" + key.name() + "\""; });
+            }
+            if (!value.forEachMember([&](const std::string& key, const Json::JsonValue& member) { return validateMember(node, key, member, error); }))
+                return false;
+            break;
+        }
+        default:
+            if (!(node.types & typeBits(value.type())))
+                return fail(error, [&node, &value]() { return "Expected " + typeNames(node.types) + ", found " + Json::toJsonString(value); });
+            break;
+    }
+
+    return checkCombinators(node, value, error);
+}
+
+bool Json::Schema::Program::validateStreamMember(const Node& node, Json::Detail::TextReader& reader, KeySet& seen, Json::SchemaError* error) const {
+    // The key lives in the reader until the value is read
+    const std::string& key = reader.key();
+    std::string path = error ? key : std::string();
+    if (node.propertyNames != noNode && !validate(Json::JsonValue(key), node.propertyNames, error))
+        return failAt(error, path);
+
+    int target = noNode;
+    size_t targets = 0;
+    if (!node.properties.empty()) {
+        auto property = node.properties.find(key);
+        if (property != node.properties.end()) {
+            if (property->second.requiredIndex >= 0)
+                seen.set(static_cast<size_t>(property->second.requiredIndex));
+            if (property->second.node != noNode) {
+                target = property->second.node;
+                targets++;
+            }
+        }
+    }
+    for (const auto& pattern : node.patternProperties) {
+        if (std::regex_search(key, *pattern.first)) {
+            target = pattern.second;
+            targets++;
+        }
+    }
+    if (targets == 0)
+        target = node.additionalProperties;
+
+    if (targets > 1) {
+        // Several schemas apply to the value, look at it as a tree
+        std::string name = key;
+        return validateMember(node, name, reader.readValue(), error);
+    }
+    if (target == noNode) {
+        reader.skipValue();
+        return true;
+    }
+    if (!validateStream(reader, target, error)) {
+        if (error && targets == 0 && this->node(target).never)
+            error->message = "Key \"" + path + "\" is not allowed";
+        return failAt(error, path);
+    }
+    return true;
+}
+
+bool Json::Schema::Program::validateStream(Json::Detail::TextReader& reader, int index, Json::SchemaError* error) const {
+    const Node& node = this->node(index);
+    if (node.needsTree)
+        return validate(reader.readValue(), index, error);
+    if (node.never)
+        return fail(error, []() { return std::string("No value is allowed here"); });
+
+    switch (reader.peek()) {
+        case '{': {
+            if (!(node.types & objectBit))
+                return fail(error, [&node]() { return "Expected " + typeNames(node.types) + ", found an object"; });
+            KeySet seen(node.required.size());
+            size_t members = 0;
+            reader.beginObject();
+            for (bool first = true; reader.nextMember(first); first = false) {
+                if (++members > node.maxProperties)
+                    return fail(error, [&node]() { return "Object has more than " + std::to_string(node.maxProperties) + " members"; });
+                if (!validateStreamMember(node, reader, seen, error))
+                    return false;
+            }
+            if (members < node.minProperties)
+                return fail(error, [&node]() { return "Object has fewer than " + std::to_string(node.minProperties) + " members"; });
+            for (size_t i = 0; i < node.required.size(); i++) {
+                if (!seen.test(i)) {
+                    const std::string& key = node.required[i].name();
+                    return fail(error, [&key]() { return "Missing required key \"" + key + "\""; });
+                }
+            }
+            return true;
+        }
+        case '[': {
+            if (!(node.types & arrayBit))
+                return fail(error, [&node]() { return "Expected " + typeNames(node.types) + ", found an array"; });
+            size_t items = 0;
+            reader.beginArray();
+            for (bool first = true; reader.nextElement(first); first = false) {
+                if (items >= node.maxItems)
+                    return fail(error, [&node]() { return "Array has more than " + std::to_string(node.maxItems) + " items"; });
+                int child = items < node.prefixItems.size() ? node.prefixItems[items] : node.items;
+                if (child == noNode) {
+                    reader.skipValue();
+                } else if (!validateStream(reader, child, error)) {
+                    return failAt(error, std::to_string(items));
+                }
+                items++;
+            }
+            if (items < node.minItems)
+                return fail(error, [&node]() { return "Array has fewer than " + std::to_string(node.minItems) + " items"; });
+            return true;
+        }
+        case '"': return checkString(node, reader.readString(), error);
+        case 't':
+        case 'f': {
+            bool value = reader.readBool();
+            if (!(node.types & boolBit))
+                return fail(error, [&node, value]() { return "Expected " + typeNames(node.types) + ", found " + (value ? "true" : "false"); });
+            return true;
+        }
+        case 'n':
+            reader.readNull();
+            if (!(node.types & nullBit))
+                return fail(error, [&node]() { return "Expected " + typeNames(node.types) + ", found null"; });
+            return true;
+        default: {
+            int intValue = 0;
+            double doubleValue = 0.0;
+            bool isInteger = reader.readNumber(intValue, doubleValue);
+            return checkNumber(node, isInteger, intValue, doubleValue, error);
+        }
+    }
+}
+
+Json::Schema::Schema(std::unique_ptr<const Program> program) noexcept : m_program(std::move(program)) {}
+Json::Schema::Schema(Schema&& other) noexcept = default;
+Json::Schema& Json::Schema::operator=(Schema&& other) noexcept = default;
+Json::Schema::~Schema() = default;
+
+Json::Schema Json::Schema::compile(const JsonValue& schema) {
+    std::unique_ptr<Program> program(new Program());
+    SchemaCompiler compiler(schema, program->nodes, program->patterns);
+    compiler.compile(schema, "#");
+    compiler.finish();
+    return Schema(std::move(program));
+}
+
+bool Json::Schema::validate(const JsonValue& value, SchemaError* error) const {
+    return m_program->validate(value, 0, error);
+}
+
+bool Json::Schema::validateJson(const std::string& json, SchemaError* error) const {
+    Json::Detail::TextReader reader(json.data(), json.length());
+    if (!m_program->validateStream(reader, 0, error))
+        return false;
+    reader.finish();
+    return true;
+}
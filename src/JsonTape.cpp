@@ -0,0 +1,505 @@
+#include "json/JsonTape.h"
+#include "JsonOutput.h"
+#include <fstream>
+#include <iterator>
+#include <unordered_map>
+
+#ifdef JSONPARSER_HAS_POSIX_IO
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Tape words: tag in the top byte, payload in the lower 56 bits. Containers keep the index of their end word in the
+// low 32 bits and their saturated element count above it, end words point back to their start
+
+#define TAPE_NULL 'n'
+#define TAPE_TRUE 't'
+#define TAPE_FALSE 'f'
+#define TAPE_INTEGER 'l'
+#define TAPE_DOUBLE 'd'
+#define TAPE_STRING 's'
+#define TAPE_OBJECT_START '{'
+#define TAPE_OBJECT_END '}'
+#define TAPE_ARRAY_START '['
+#define TAPE_ARRAY_END ']'
+
+namespace {
+
+constexpr uint64_t payloadMask = (1ULL << 56) - 1;
+constexpr uint64_t maxTapeIndex = 0xFFFFFFFFULL;
+constexpr uint64_t maxStoredCount = 0xFFFFFF;
+
+inline uint64_t makeWord(unsigned char tag, uint64_t payload) noexcept {
+    return (static_cast<uint64_t>(tag) << 56) | payload;
+}
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder; // Written natively, reads back differently on a machine with the other byte order
+    uint64_t wordCount;
+    uint64_t stringBytes;
+};
+
+const char snapshotMagic[8] = { 'J', 'S', 'O', 'N', 'T', 'A', 'P', 'E' };
+constexpr uint32_t snapshotVersion = 1;
+constexpr uint32_t snapshotByteOrder = 0x01020304;
+
+// Builds the tape from a JsonValue of any layout or directly from parser events. Keys are stored once per distinct
+// name, element counts are taken while building since the parser does not know them up front
+class TapeBuilder : public Json::Detail::ValueVisitor {
+private:
+    struct OpenContainer {
+        size_t start;
+        uint64_t count;
+    };
+
+    std::vector<uint64_t> m_words;
+    std::string m_strings;
+    std::vector<OpenContainer> m_open;
+    std::unordered_map<std::string, uint64_t> m_keys;
+
+    inline void added() noexcept {
+        if (!m_open.empty())
+            m_open.back().count++;
+    }
+
+    uint64_t addString(const std::string& value) {
+        if (value.length() > 0xFFFFFFFFULL || m_strings.size() > payloadMask)
+            throw Json::JsonWriteException("Document too large for a tape");
+        uint64_t offset = m_strings.size();
+        uint32_t length = static_cast<uint32_t>(value.length());
+        m_strings.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        m_strings.append(value);
+        m_strings += '\0';
+        return offset;
+    }
+
+    void begin(unsigned char tag) {
+        if (m_words.size() >= maxTapeIndex)
+            throw Json::JsonWriteException("Document too large for a tape");
+        added();
+        m_open.push_back({ m_words.size(), 0 });
+        m_words.push_back(makeWord(tag, 0));
+    }
+
+    void end(unsigned char tag) {
+        if (m_words.size() >= maxTapeIndex)
+            throw Json::JsonWriteException("Document too large for a tape");
+        OpenContainer container = m_open.back();
+        m_open.pop_back();
+        uint64_t count = container.count < maxStoredCount ? container.count : maxStoredCount;
+        m_words[container.start] |= (count << 32) | m_words.size();
+        m_words.push_back(makeWord(tag, container.start));
+    }
+
+public:
+    void null() override {
+        added();
+        m_words.push_back(makeWord(TAPE_NULL, 0));
+    }
+
+    void boolean(bool value) override {
+        added();
+        m_words.push_back(makeWord(value ? TAPE_TRUE : TAPE_FALSE, 0));
+    }
+
+    void integer(int value) override {
+        added();
+        m_words.push_back(makeWord(TAPE_INTEGER, static_cast<uint32_t>(value)));
+    }
+
+    void number(double value) override {
+        added();
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        m_words.push_back(makeWord(TAPE_DOUBLE, 0));
+        m_words.push_back(bits);
+    }
+
+    void string(const std::string& value) override {
+        added();
+        m_words.push_back(makeWord(TAPE_STRING, addString(value)));
+    }
+
+    void key(const std::string& name) override {
+        auto it = m_keys.find(name);
+        if (it == m_keys.end()) {
+            it = m_keys.emplace(name, addString(name)).first;
+        }
+        m_words.push_back(makeWord(TAPE_STRING, it->second));
+    }
+
+    void beginObject(size_t) override { begin(TAPE_OBJECT_START); }
+    void endObject() override { end(TAPE_OBJECT_END); }
+    void beginArray(size_t) override { begin(TAPE_ARRAY_START); }
+    void endArray() override { end(TAPE_ARRAY_END); }
+
+    inline std::vector<uint64_t>& words() noexcept { return m_words; }
+    inline std::string& strings() noexcept { return m_strings; }
+};
+
+// Hands the snapshot bytes of a tape to write(data, length) without building them in one piece
+template <typename Write>
+void emitSnapshot(const Json::Detail::TapeData& tape, const Write& write) {
+    SnapshotHeader header;
+    std::memcpy(header.magic, snapshotMagic, sizeof(header.magic));
+    header.version = snapshotVersion;
+    header.byteOrder = snapshotByteOrder;
+    header.wordCount = tape.wordCount;
+    header.stringBytes = tape.stringBytes;
+    write(reinterpret_cast<const char*>(&header), sizeof(header));
+    write(reinterpret_cast<const char*>(tape.words), tape.wordCount * sizeof(uint64_t));
+    write(tape.strings, tape.stringBytes);
+}
+
+} // namespace
+
+struct Json::Tape::State {
+    Json::Detail::TapeData tape;
+    std::vector<uint64_t> words;
+    std::string strings;
+
+    explicit State(TapeBuilder& builder) : words(std::move(builder.words())), strings(std::move(builder.strings())) {
+        tape.words = words.data();
+        tape.wordCount = words.size();
+        tape.strings = strings.data();
+        tape.stringBytes = strings.size();
+    }
+};
+
+Json::Tape::Tape(std::unique_ptr<State> state) noexcept : m_state(std::move(state)) {}
+Json::Tape::Tape(Tape&& other) noexcept = default;
+Json::Tape& Json::Tape::operator=(Tape&& other) noexcept = default;
+Json::Tape::~Tape() = default;
+
+Json::Tape::Tape(const JsonValue& value) {
+    TapeBuilder builder;
+    Json::Detail::visitValue(value, builder);
+    m_state.reset(new State(builder));
+}
+
+Json::ElementView Json::Tape::root() const noexcept {
+    return ElementView(&m_state->tape, 0);
+}
+
+size_t Json::Tape::sizeBytes() const noexcept {
+    return m_state->tape.wordCount * sizeof(uint64_t) + m_state->tape.stringBytes;
+}
+
+Json::Tape Json::parseTape(const std::string& json) {
+    TapeBuilder builder;
+    Json::Detail::parseEvents(json.data(), json.length(), builder);
+    return Tape(std::unique_ptr<Tape::State>(new Tape::State(builder)));
+}
+
+struct Json::Snapshot::State {
+    Json::Detail::TapeData tape;
+    std::vector<uint64_t> owned; // Copied or read data, aligned for the tape words
+    void* mapping = nullptr;
+    size_t size = 0;
+
+    State() = default;
+    State(const State&) = delete;
+    State& operator=(const State&) = delete;
+
+    ~State() {
+#ifdef JSONPARSER_HAS_POSIX_IO
+        if (mapping)
+            ::munmap(mapping, size);
+#endif
+    }
+
+    // Checks the header against the size, the rest is trusted
+    void attach(const void* data, size_t length) {
+        if (length < sizeof(SnapshotHeader))
+            throw Json::JsonMalformedException("Snapshot too small");
+        SnapshotHeader header;
+        std::memcpy(&header, data, sizeof(header));
+        if (std::memcmp(header.magic, snapshotMagic, sizeof(snapshotMagic)) != 0)
+            throw Json::JsonMalformedException("Not a json snapshot");
+        if (header.version != snapshotVersion)
+            throw Json::JsonMalformedException("Unsupported snapshot version " + std::to_string(header.version));
+        if (header.byteOrder != snapshotByteOrder)
+            throw Json::JsonMalformedException("Snapshot was written with a different byte order");
+        size_t available = length - sizeof(SnapshotHeader);
+        if (header.wordCount == 0 || header.wordCount > available / sizeof(uint64_t) ||
+            header.stringBytes != available - header.wordCount * sizeof(uint64_t))
+            throw Json::JsonMalformedException("Snapshot sizes do not match its length");
+
+        const char* bytes = static_cast<const char*>(data);
+        tape.words = reinterpret_cast<const uint64_t*>(bytes + sizeof(SnapshotHeader));
+        tape.wordCount = static_cast<size_t>(header.wordCount);
+        tape.strings = bytes + sizeof(SnapshotHeader) + tape.wordCount * sizeof(uint64_t);
+        tape.stringBytes = static_cast<size_t>(header.stringBytes);
+        size = length;
+    }
+
+    void copy(const void* data, size_t length) {
+        owned.resize((length + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+        if (length > 0)
+            std::memcpy(owned.data(), data, length);
+        attach(owned.data(), length);
+    }
+};
+
+Json::Snapshot::Snapshot(std::unique_ptr<State> state) noexcept : m_state(std::move(state)) {}
+Json::Snapshot::Snapshot(Snapshot&& other) noexcept = default;
+Json::Snapshot& Json::Snapshot::operator=(Snapshot&& other) noexcept = default;
+Json::Snapshot::~Snapshot() = default;
+
+Json::Snapshot Json::Snapshot::open(const std::string& path) {
+    std::unique_ptr<State> state(new State());
+#ifdef JSONPARSER_HAS_POSIX_IO
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw Json::JsonMalformedException("Failed to open snapshot " + path + ": " + std::strerror(errno));
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        int error = errno;
+        ::close(fd);
+        throw Json::JsonMalformedException("Failed to open snapshot " + path + ": " + std::strerror(error));
+    }
+    size_t length = static_cast<size_t>(info.st_size);
+    void* mapping = length > 0 ? ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    int error = errno;
+    ::close(fd); // The mapping keeps the file alive
+    if (mapping == MAP_FAILED) {
+        if (length == 0)
+            throw Json::JsonMalformedException("Snapshot too small");
+        throw Json::JsonMalformedException("Failed to map snapshot " + path + ": " + std::strerror(error));
+    }
+    state->mapping = mapping;
+    state->size = length;
+    state->attach(mapping, length);
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        throw Json::JsonMalformedException("Failed to open snapshot " + path);
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    state->copy(content.data(), content.size());
+#endif
+    return Snapshot(std::move(state));
+}
+
+Json::Snapshot Json::Snapshot::fromBuffer(const void* data, size_t length) {
+    std::unique_ptr<State> state(new State());
+    state->copy(data, length);
+    return Snapshot(std::move(state));
+}
+
+Json::ElementView Json::Snapshot::root() const noexcept {
+    return ElementView(&m_state->tape, 0);
+}
+
+size_t Json::Snapshot::sizeBytes() const noexcept {
+    return m_state->size;
+}
+
+std::string Json::toSnapshot(const Tape& tape) {
+    std::string out;
+    out.reserve(sizeof(SnapshotHeader) + tape.sizeBytes());
+    emitSnapshot(tape.m_state->tape, [&out](const char* data, size_t length) { out.append(data, length); });
+    return out;
+}
+
+void Json::writeSnapshot(const Tape& tape, std::ostream& os) {
+    Json::Detail::StreamSink sink(os);
+    emitSnapshot(tape.m_state->tape, [&sink](const char* data, size_t length) { sink.write(data, length); });
+}
+
+void Json::writeSnapshot(const Tape& tape, const WriteCallback& callback) {
+    emitSnapshot(tape.m_state->tape, callback);
+}
+
+std::string Json::toSnapshot(const JsonValue& value) {
+    return toSnapshot(Tape(value));
+}
+
+void Json::writeSnapshot(const JsonValue& value, std::ostream& os) {
+    writeSnapshot(Tape(value), os);
+}
+
+void Json::writeSnapshot(const JsonValue& value, const WriteCallback& callback) {
+    writeSnapshot(Tape(value), callback);
+}
+
+size_t Json::ElementView::endIndex() const {
+    size_t end = static_cast<size_t>(word() & maxTapeIndex);
+    if (end >= m_tape->wordCount || end <= m_index)
+        throw Json::JsonMalformedException("Corrupt tape");
+    return end;
+}
+
+Json::JsonType Json::ElementView::type() const {
+    switch (tag()) {
+        case TAPE_TRUE:
+        case TAPE_FALSE: return JsonType::Bool;
+        case TAPE_INTEGER: return JsonType::Integer;
+        case TAPE_DOUBLE: return JsonType::Double;
+        case TAPE_STRING: return JsonType::String;
+        case TAPE_OBJECT_START: return JsonType::Object;
+        case TAPE_ARRAY_START: return JsonType::Array;
+        case TAPE_NULL: return JsonType::Null;
+        default: throw Json::JsonMalformedException("Corrupt tape");
+    }
+}
+
+bool Json::ElementView::toBool() const {
+    if (!isBool())
+        throw Json::JsonTypeException("Cannot cast to C++ BOOL because underlying type is " + jsonTypeToString(type()));
+    return tag() == TAPE_TRUE;
+}
+
+int Json::ElementView::toInt() const {
+    if (!isInt())
+        throw Json::JsonTypeException("Cannot cast to C++ INTEGER because underlying type is " + jsonTypeToString(type()));
+    return static_cast<int>(static_cast<uint32_t>(word()));
+}
+
+double Json::ElementView::toDouble() const {
+    if (!isDouble())
+        throw Json::JsonTypeException("Cannot cast to C++ DOUBLE because the underlying type is " + jsonTypeToString(type()));
+    if (m_index + 1 >= m_tape->wordCount)
+        throw Json::JsonMalformedException("Corrupt tape");
+    double value;
+    std::memcpy(&value, &m_tape->words[m_index + 1], sizeof(value));
+    return value;
+}
+
+size_t Json::ElementView::stringLength() const {
+    if (!isString())
+        throw Json::JsonTypeException("Cannot cast to C++ STRING because the underlying type is " + jsonTypeToString(type()));
+    size_t offset = static_cast<size_t>(word() & payloadMask);
+    uint32_t length;
+    if (offset > m_tape->stringBytes || m_tape->stringBytes - offset < sizeof(length))
+        throw Json::JsonMalformedException("Corrupt tape");
+    std::memcpy(&length, m_tape->strings + offset, sizeof(length));
+    if (m_tape->stringBytes - offset - sizeof(length) <= length)
+        throw Json::JsonMalformedException("Corrupt tape");
+    return length;
+}
+
+const char* Json::ElementView::stringData() const {
+    stringLength(); // Checks the type and the bounds
+    return m_tape->strings + (word() & payloadMask) + sizeof(uint32_t);
+}
+
+std::string Json::ElementView::toString() const {
+    size_t length = stringLength();
+    return std::string(stringData(), length);
+}
+
+#ifdef JSONPARSER_HAS_STRING_VIEW
+std::string_view Json::ElementView::toStringView() const {
+    size_t length = stringLength();
+    return std::string_view(stringData(), length);
+}
+#endif
+
+size_t Json::ElementView::size() const {
+    if (!isObject() && !isArray())
+        throw Json::JsonTypeException("Cannot get size of non-object/array types");
+    size_t count = static_cast<size_t>((word() & payloadMask) >> 32);
+    if (count < maxStoredCount)
+        return count;
+    // Saturated, count by walking
+    count = 0;
+    for (Iterator it = begin(), last = end(); it != last; ++it) {
+        count++;
+    }
+    return count;
+}
+
+bool Json::ElementView::isEmpty() const {
+    if (!isObject() && !isArray())
+        throw Json::JsonTypeException("Cannot check emptiness for non-object/array types");
+    return endIndex() == m_index + 1;
+}
+
+Json::ElementView::Iterator& Json::ElementView::Iterator::operator++() {
+    size_t value = m_object ? m_index + 1 : m_index;
+    ElementView current(m_tape, value);
+    switch (current.tag()) {
+        case TAPE_OBJECT_START:
+        case TAPE_ARRAY_START: m_index = current.endIndex() + 1; break;
+        case TAPE_DOUBLE: m_index = value + 2; break;
+        default: m_index = value + 1; break;
+    }
+    return *this;
+}
+
+Json::ElementView::Iterator Json::ElementView::begin() const {
+    if (!isObject() && !isArray())
+        throw Json::JsonTypeException("Cannot iterate non-object/array types");
+    return Iterator(m_tape, m_index + 1, isObject());
+}
+
+Json::ElementView::Iterator Json::ElementView::end() const {
+    if (!isObject() && !isArray())
+        throw Json::JsonTypeException("Cannot iterate non-object/array types");
+    return Iterator(m_tape, endIndex(), isObject());
+}
+
+Json::ElementView Json::ElementView::member(const char* key, size_t length) const {
+    if (!isObject())
+        throw Json::JsonTypeException("Accessing key in non-object type");
+    for (Iterator it = begin(), last = end(); it != last; ++it) {
+        ElementView name = it.key();
+        if (name.stringLength() == length && std::memcmp(name.stringData(), key, length) == 0)
+            return *it;
+    }
+    throw std::out_of_range("Key not found in json object");
+}
+
+Json::ElementView Json::ElementView::element(size_t index) const {
+    if (!isArray())
+        throw Json::JsonTypeException("Accessing index in non-array type");
+    Iterator it = begin();
+    Iterator last = end();
+    for (size_t i = 0; i < index && it != last; i++) {
+        ++it;
+    }
+    if (it == last)
+        throw std::out_of_range("Index out of range in json array");
+    return *it;
+}
+
+Json::ElementView Json::ElementView::at(const std::string& key) const {
+    return member(key.data(), key.length());
+}
+
+Json::ElementView Json::ElementView::at(size_t index) const {
+    return element(index);
+}
+
+Json::JsonValue Json::ElementView::toJsonValue() const {
+    switch (tag()) {
+        case TAPE_TRUE: return JsonValue(true);
+        case TAPE_FALSE: return JsonValue(false);
+        case TAPE_INTEGER: return JsonValue(toInt());
+        case TAPE_DOUBLE: return JsonValue(toDouble());
+        case TAPE_STRING: return JsonValue(toString());
+        case TAPE_OBJECT_START: {
+            JsonObject object;
+            object.reserve(size());
+            for (Iterator it = begin(), last = end(); it != last; ++it) {
+                object.emplace(it.key().toString(), (*it).toJsonValue()); // First occurrence of a duplicate wins, like parseJson
+            }
+            return JsonValue(std::move(object));
+        }
+        case TAPE_ARRAY_START: {
+            JsonArray array;
+            array.reserve(size());
+            for (ElementView element : *this) {
+                array.push_back(element.toJsonValue());
+            }
+            return JsonValue(std::move(array));
+        }
+        case TAPE_NULL: return JsonValue(nullptr);
+        default: throw Json::JsonMalformedException("Corrupt tape");
+    }
+}
@@ -0,0 +1,128 @@
+#include "json/JsonParser.h"
+#include "JsonOutput.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <thread>
+
+namespace {
+
+// Threads for parallel serialization. Started on first use and never stopped, like the reclaimer
+class WorkerPool {
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_queued;
+    std::deque<std::function<void()>> m_tasks;
+    size_t m_size;
+
+    void run() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_queued.wait(lock, [this]() { return !m_tasks.empty(); });
+            std::function<void()> task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+
+public:
+    explicit WorkerPool(size_t size) : m_size(size) {
+        for (size_t i = 0; i < size; i++) {
+            std::thread(&WorkerPool::run, this).detach();
+        }
+    }
+
+    inline size_t size() const noexcept { return m_size; }
+
+    void post(std::function<void()>&& task) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.push_back(std::move(task));
+        }
+        m_queued.notify_one();
+    }
+};
+
+// Tasks are claimed through a shared counter, so the calling thread finishes everything on its own when the pool
+// is busy. Helpers that arrive late find nothing left and only touch the job itself
+struct ParallelJob {
+    std::atomic<size_t> next;
+    std::atomic<bool> failed;
+    std::mutex mutex;
+    std::condition_variable finished;
+    size_t remaining;
+    std::exception_ptr error;
+    const std::function<void(size_t)>* task;
+    size_t count;
+
+    ParallelJob(const std::function<void(size_t)>* t, size_t c) : next(0), failed(false), remaining(c), task(t), count(c) {}
+};
+
+} // namespace
+
+static WorkerPool& workerPool() {
+    // Never destroyed, the detached threads keep using it until the process ends
+    static WorkerPool* pool = new WorkerPool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return *pool;
+}
+
+static thread_local bool insideParallelTask = false;
+
+static void workOn(const std::shared_ptr<ParallelJob>& job) {
+    insideParallelTask = true;
+    while (true) {
+        size_t index = job->next.fetch_add(1, std::memory_order_relaxed);
+        if (index >= job->count) {
+            break;
+        }
+        if (!job->failed.load(std::memory_order_relaxed)) {
+            try {
+                (*job->task)(index);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(job->mutex);
+                if (!job->error) {
+                    job->error = std::current_exception();
+                }
+                job->failed.store(true, std::memory_order_relaxed);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(job->mutex);
+        if (--job->remaining == 0) {
+            job->finished.notify_all();
+        }
+    }
+    insideParallelTask = false;
+}
+
+unsigned int Json::Detail::serializationThreads(const WriteOptions& options) noexcept {
+    if (options.threads == 0) {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+    return options.threads;
+}
+
+bool Json::Detail::insideParallelSerialization() noexcept {
+    return insideParallelTask;
+}
+
+void Json::Detail::runParallel(size_t taskCount, unsigned int threads, const std::function<void(size_t)>& task) {
+    std::shared_ptr<ParallelJob> job = std::make_shared<ParallelJob>(&task, taskCount);
+    size_t helpers = std::min<size_t>(std::min<size_t>(threads - 1, workerPool().size()), taskCount - 1);
+    for (size_t i = 0; i < helpers; i++) {
+        workerPool().post([job]() { workOn(job); });
+    }
+    workOn(job);
+
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->finished.wait(lock, [&job]() { return job->remaining == 0; });
+    if (job->error) {
+        std::rethrow_exception(job->error);
+    }
+}
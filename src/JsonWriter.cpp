@@ -0,0 +1,237 @@
+#include "json/JsonWriter.h"
+#include "JsonOutput.h"
+#include <cstring>
+#include <vector>
+
+#ifndef NDEBUG
+#define JSONWRITER_CHECK(condition, message) \
+    do { if (!(condition)) throw Json::JsonWriteException(message); } while (false)
+#else
+#define JSONWRITER_CHECK(condition, message) do {} while (false)
+#endif
+
+struct Json::Writer::State {
+    WriteCallback callback; // Kept alive for the callback sink
+    std::unique_ptr<Detail::OutputSink> sink;
+    std::vector<char> buffer;
+    Detail::BufferedOutput output;
+    size_t depth = 0;
+    bool needsComma = false;
+    bool rootWritten = false;
+    std::vector<bool> inObject; // Open containers, only tracked for the checks of debug builds
+    bool expectingValue = false; // A key was written and waits for its value
+    WriteOptions options;
+
+    State(Detail::OutputSink* outputSink, const WriteOptions& writeOptions, size_t bufferSize)
+        : sink(outputSink), buffer(bufferSize == 0 ? 1 : bufferSize), output(*sink, buffer.data(), buffer.size()), options(writeOptions) {}
+
+    // The sink refers to the copy of the callback, which therefore has to exist first
+    State(const WriteCallback& writeCallback, const WriteOptions& writeOptions, size_t bufferSize)
+        : callback(writeCallback), sink(new Detail::CallbackSink(callback)), buffer(bufferSize == 0 ? 1 : bufferSize),
+          output(*sink, buffer.data(), buffer.size()), options(writeOptions) {}
+};
+
+// Strings only need a small staging buffer, the string itself grows as needed
+static constexpr size_t stringWriterBufferSize = 1024;
+
+Json::Writer::Writer(std::string& out) : Writer(out, WriteOptions()) {}
+
+Json::Writer::Writer(std::ostream& os, size_t bufferSize) : Writer(os, WriteOptions(), bufferSize) {}
+
+Json::Writer::Writer(const WriteCallback& callback, size_t bufferSize) : Writer(callback, WriteOptions(), bufferSize) {}
+
+Json::Writer::Writer(std::string& out, const WriteOptions& options)
+    : m_state(new State(new Detail::StringSink(out), options, stringWriterBufferSize)) {}
+
+Json::Writer::Writer(std::ostream& os, const WriteOptions& options, size_t bufferSize)
+    : m_state(new State(new Detail::StreamSink(os), options, bufferSize)) {}
+
+Json::Writer::Writer(const WriteCallback& callback, const WriteOptions& options, size_t bufferSize)
+    : m_state(new State(callback, options, bufferSize)) {}
+
+Json::Writer::~Writer() {
+    try {
+        m_state->output.flush();
+    } catch (...) {
+        // Destructors must not throw, call flush() to see write errors
+    }
+}
+
+void Json::Writer::beforeValue() {
+    State& state = *m_state;
+    JSONWRITER_CHECK(state.depth > 0 || !state.rootWritten, "Json writer already wrote a complete root value");
+    JSONWRITER_CHECK(state.inObject.empty() || !state.inObject.back() || state.expectingValue, "Json writer expected a key inside an object");
+    if (state.needsComma) {
+        state.output.put(JSONVALUE_DELIMITER);
+    }
+    // Values of object members stay on the line of their key
+    if (!state.expectingValue && state.depth > 0 && Detail::isPretty(state.options)) {
+        Detail::appendLineBreak(state.output, state.options, state.depth);
+    }
+    state.expectingValue = false;
+}
+
+void Json::Writer::afterValue() {
+    State& state = *m_state;
+    state.needsComma = true;
+    if (state.depth == 0) {
+        // Root value complete, make the output visible
+        state.rootWritten = true;
+        state.needsComma = false;
+        state.output.flush();
+    }
+}
+
+void Json::Writer::closeContainer(char delimiter) {
+    // needsComma tells whether the container got any element, empty ones stay {} and []
+    if (m_state->needsComma && Detail::isPretty(m_state->options)) {
+        Detail::appendLineBreak(m_state->output, m_state->options, m_state->depth);
+    }
+    m_state->output.put(delimiter);
+}
+
+Json::Writer& Json::Writer::beginObject() {
+    beforeValue();
+    m_state->output.put(JSONOBJECT_STARTDELIMITER);
+    m_state->depth++;
+    m_state->needsComma = false;
+#ifndef NDEBUG
+    m_state->inObject.push_back(true);
+#endif
+    return *this;
+}
+
+Json::Writer& Json::Writer::endObject() {
+    JSONWRITER_CHECK(!m_state->inObject.empty() && m_state->inObject.back(), "Json writer has no open object to end");
+    JSONWRITER_CHECK(!m_state->expectingValue, "Json writer ended an object after a key without value");
+#ifndef NDEBUG
+    m_state->inObject.pop_back();
+#endif
+    m_state->depth--;
+    closeContainer(JSONOBJECT_ENDDELIMITER);
+    afterValue();
+    return *this;
+}
+
+Json::Writer& Json::Writer::beginArray() {
+    beforeValue();
+    m_state->output.put(JSONARRAY_STARTDELIMITER);
+    m_state->depth++;
+    m_state->needsComma = false;
+#ifndef NDEBUG
+    m_state->inObject.push_back(false);
+#endif
+    return *this;
+}
+
+Json::Writer& Json::Writer::endArray() {
+    JSONWRITER_CHECK(!m_state->inObject.empty() && !m_state->inObject.back(), "Json writer has no open array to end");
+#ifndef NDEBUG
+    m_state->inObject.pop_back();
+#endif
+    m_state->depth--;
+    closeContainer(JSONARRAY_ENDDELIMITER);
+    afterValue();
+    return *this;
+}
+
+Json::Writer& Json::Writer::writeKey(const char* name, size_t length) {
+    State& state = *m_state;
+    JSONWRITER_CHECK(!state.inObject.empty() && state.inObject.back(), "Json writer got a key outside of an object");
+    JSONWRITER_CHECK(!state.expectingValue, "Json writer got a key while expecting a value");
+    if (state.needsComma) {
+        state.output.put(JSONVALUE_DELIMITER);
+    }
+    if (Detail::isPretty(state.options)) {
+        Detail::appendLineBreak(state.output, state.options, state.depth);
+    }
+    state.output.put(JSONSTRING_DELIMITER);
+    Detail::appendEscaped(state.output, name, length, Detail::escapingOf(state.options));
+    state.output.put(JSONSTRING_DELIMITER);
+    Detail::appendKeySeparator(state.output, state.options);
+    state.needsComma = false;
+    state.expectingValue = true;
+    return *this;
+}
+
+Json::Writer& Json::Writer::writeString(const char* value, size_t length) {
+    beforeValue();
+    m_state->output.put(JSONSTRING_DELIMITER);
+    Detail::appendEscaped(m_state->output, value, length, Detail::escapingOf(m_state->options));
+    m_state->output.put(JSONSTRING_DELIMITER);
+    afterValue();
+    return *this;
+}
+
+Json::Writer& Json::Writer::key(const char* name) {
+    return writeKey(name, std::strlen(name));
+}
+
+Json::Writer& Json::Writer::key(const std::string& name) {
+    return writeKey(name.data(), name.length());
+}
+
+Json::Writer& Json::Writer::value(bool value) {
+    beforeValue();
+    if (value) {
+        m_state->output.write(JSON_BOOLTRUE_LITERAL, sizeof(JSON_BOOLTRUE_LITERAL) - 1);
+    } else {
+        m_state->output.write(JSON_BOOLFALSE_LITERAL, sizeof(JSON_BOOLFALSE_LITERAL) - 1);
+    }
+    afterValue();
+    return *this;
+}
+
+Json::Writer& Json::Writer::value(int value) {
+    beforeValue();
+    Detail::appendInt(m_state->output, value);
+    afterValue();
+    return *this;
+}
+
+Json::Writer& Json::Writer::value(double value) {
+    beforeValue();
+    Detail::appendDouble(m_state->output, value, m_state->options.canonical);
+    afterValue();
+    return *this;
+}
+
+Json::Writer& Json::Writer::value(const char* value) {
+    return writeString(value, std::strlen(value));
+}
+
+Json::Writer& Json::Writer::value(const std::string& value) {
+    return writeString(value.data(), value.length());
+}
+
+Json::Writer& Json::Writer::value(std::nullptr_t) {
+    beforeValue();
+    m_state->output.write(JSON_NULL_LITERAL, sizeof(JSON_NULL_LITERAL) - 1);
+    afterValue();
+    return *this;
+}
+
+Json::Writer& Json::Writer::value(const JsonValue& value) {
+    beforeValue();
+    Detail::serializeValue(value, m_state->output, m_state->options, m_state->depth);
+    afterValue();
+    return *this;
+}
+
+#ifdef JSONPARSER_HAS_STRING_VIEW
+Json::Writer& Json::Writer::key(std::string_view name) {
+    return writeKey(name.data(), name.length());
+}
+
+Json::Writer& Json::Writer::value(std::string_view value) {
+    return writeString(value.data(), value.length());
+}
+#endif
+
+void Json::Writer::flush() {
+    m_state->output.flush();
+}
+
+bool Json::Writer::isComplete() const noexcept {
+    return m_state->rootWritten && m_state->depth == 0;
+}
@@ -0,0 +1,134 @@
+#include "json/JsonParser.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <sstream>
+
+namespace Json {
+
+static std::string bytes(std::initializer_list<unsigned char> list) {
+    return std::string(list.begin(), list.end());
+}
+
+static const char* sampleDocument = R"({"id": 42, "name": "widget é", "price": 12.75, "tags": ["a", "b"], "stock": null, "active": true,
+    "dims": {"w": -3, "h": 1e300, "d": -200000}, "empty": [], "none": {}, "big": 2147483647, "small": -2147483648})";
+
+// Independent of the member order of the decoded maps
+static std::string canonicalString(const JsonValue& value) {
+    WriteOptions options;
+    options.canonical = true;
+    return toJsonString(value, options);
+}
+
+TEST(JsonBinaryTests, MessagePackRoundTripMatchesTextPath) {
+    ParseOptions shaped;
+    shaped.shareShapes = true;
+    shaped.packNumbers = true;
+    for (const JsonValue& value : { parseJson(sampleDocument), parseJson(sampleDocument, shaped) }) {
+        JsonValue decoded = fromMessagePack(toMessagePack(value));
+        EXPECT_EQ(decoded, parseJson(sampleDocument));
+        EXPECT_EQ(canonicalString(decoded), canonicalString(parseJson(toJsonString(value))));
+        EXPECT_TRUE(decoded["price"].isDouble());
+        EXPECT_TRUE(decoded["id"].isInt());
+    }
+}
+
+TEST(JsonBinaryTests, CborRoundTripMatchesTextPath) {
+    ParseOptions shaped;
+    shaped.shareShapes = true;
+    shaped.packNumbers = true;
+    for (const JsonValue& value : { parseJson(sampleDocument), parseJson(sampleDocument, shaped) }) {
+        JsonValue decoded = fromCbor(toCbor(value));
+        EXPECT_EQ(decoded, parseJson(sampleDocument));
+        EXPECT_EQ(canonicalString(decoded), canonicalString(parseJson(toJsonString(value))));
+    }
+
+    // Exact binary form, no decimal round trip
+    double third = 1.0 / 3.0;
+    EXPECT_EQ(fromCbor(toCbor(JsonValue(third))).toDouble(), third);
+    EXPECT_EQ(fromMessagePack(toMessagePack(JsonValue(third))).toDouble(), third);
+}
+
+TEST(JsonBinaryTests, MessagePackEncoding) {
+    JsonObject object;
+    object["compact"] = true;
+    EXPECT_EQ(toMessagePack(JsonValue(object)), bytes({ 0x81, 0xA7, 'c', 'o', 'm', 'p', 'a', 'c', 't', 0xC3 }));
+    EXPECT_EQ(toMessagePack(JsonValue(-1)), bytes({ 0xFF }));
+    EXPECT_EQ(toMessagePack(JsonValue(-33)), bytes({ 0xD0, 0xDF }));
+    EXPECT_EQ(toMessagePack(JsonValue(200)), bytes({ 0xCC, 0xC8 }));
+    EXPECT_EQ(toMessagePack(JsonValue(70000)), bytes({ 0xCE, 0x00, 0x01, 0x11, 0x70 }));
+    EXPECT_EQ(toMessagePack(JsonValue(1.5)), bytes({ 0xCB, 0x3F, 0xF8, 0, 0, 0, 0, 0, 0 }));
+    EXPECT_EQ(toMessagePack(JsonValue(std::string(40, 'x'))).substr(0, 2), bytes({ 0xD9, 40 }));
+
+    JsonArray large(20, JsonValue(nullptr));
+    EXPECT_EQ(toMessagePack(JsonValue(large)).substr(0, 4), bytes({ 0xDC, 0x00, 0x14, 0xC0 }));
+}
+
+TEST(JsonBinaryTests, CborEncodingFollowsRfc8949Examples) {
+    EXPECT_EQ(toCbor(JsonValue(0)), bytes({ 0x00 }));
+    EXPECT_EQ(toCbor(JsonValue(24)), bytes({ 0x18, 0x18 }));
+    EXPECT_EQ(toCbor(JsonValue(1000000)), bytes({ 0x1A, 0x00, 0x0F, 0x42, 0x40 }));
+    EXPECT_EQ(toCbor(JsonValue(-1000)), bytes({ 0x39, 0x03, 0xE7 }));
+    EXPECT_EQ(toCbor(JsonValue(1.1)), bytes({ 0xFB, 0x3F, 0xF1, 0x99, 0x99, 0x99, 0x99, 0x99, 0x9A }));
+    EXPECT_EQ(toCbor(JsonValue("IETF")), bytes({ 0x64, 'I', 'E', 'T', 'F' }));
+    EXPECT_EQ(toCbor(parseJson("[1, [2, 3], true, null]")), bytes({ 0x84, 0x01, 0x82, 0x02, 0x03, 0xF5, 0xF6 }));
+    EXPECT_EQ(toCbor(parseJson(R"({"a": 1})")), bytes({ 0xA1, 0x61, 'a', 0x01 }));
+}
+
+TEST(JsonBinaryTests, DecodesOtherEncoderForms) {
+    // Smaller floats, 64 bit integers, indefinite lengths and tags are valid output of other encoders
+    EXPECT_EQ(fromCbor(bytes({ 0xF9, 0x3E, 0x00 })).toDouble(), 1.5);
+    EXPECT_EQ(fromCbor(bytes({ 0xF9, 0x7B, 0xFF })).toDouble(), 65504.0);
+    EXPECT_TRUE(std::isinf(fromCbor(bytes({ 0xF9, 0xFC, 0x00 })).toDouble()));
+    EXPECT_EQ(fromCbor(bytes({ 0xFA, 0x47, 0xC3, 0x50, 0x00 })).toDouble(), 100000.0);
+    EXPECT_EQ(fromCbor(bytes({ 0x1B, 0x00, 0x00, 0x00, 0xE8, 0xD4, 0xA5, 0x10, 0x00 })).toDouble(), 1e12);
+    EXPECT_EQ(fromCbor(bytes({ 0x9F, 0x01, 0x82, 0x02, 0x03, 0x9F, 0x04, 0x05, 0xFF, 0xFF })), parseJson("[1, [2, 3], [4, 5]]"));
+    EXPECT_EQ(fromCbor(bytes({ 0xBF, 0x61, 'a', 0x01, 0x61, 'b', 0x9F, 0x02, 0x03, 0xFF, 0xFF })), parseJson(R"({"a": 1, "b": [2, 3]})"));
+    EXPECT_EQ(fromCbor(bytes({ 0x7F, 0x65, 's', 't', 'r', 'e', 'a', 0x64, 'm', 'i', 'n', 'g', 0xFF })).toString(), "streaming");
+    EXPECT_EQ(fromCbor(bytes({ 0xC1, 0x1A, 0x51, 0x4B, 0x67, 0xB0 })).toInt(), 1363896240); // Epoch time tag
+
+    EXPECT_EQ(fromMessagePack(bytes({ 0xCA, 0x3F, 0xC0, 0x00, 0x00 })).toDouble(), 1.5);
+    EXPECT_EQ(fromMessagePack(bytes({ 0xD3, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE })).toInt(), -2);
+    EXPECT_EQ(fromMessagePack(bytes({ 0xCF, 0, 0, 0, 0x01, 0, 0, 0, 0 })).toDouble(), 4294967296.0);
+    EXPECT_EQ(fromMessagePack(bytes({ 0xDE, 0x00, 0x01, 0xA1, 'k', 0x90 })), parseJson(R"({"k": []})"));
+}
+
+TEST(JsonBinaryTests, RejectsMalformedInput) {
+    EXPECT_THROW(fromMessagePack(bytes({ 0x92, 0x01 })), JsonMalformedException);
+    EXPECT_THROW(fromMessagePack(bytes({ 0xC4, 0x01, 0x00 })), JsonMalformedException); // bin
+    EXPECT_THROW(fromMessagePack(bytes({ 0x81, 0x01, 0x01 })), JsonMalformedException); // Integer key
+    EXPECT_THROW(fromMessagePack(bytes({ 0x01, 0x02 })), JsonMalformedException); // Trailing data
+    EXPECT_THROW(fromMessagePack(bytes({ 0xDD, 0xFF, 0xFF, 0xFF, 0xFF })), JsonMalformedException); // Count beyond the data
+    EXPECT_THROW(fromMessagePack(bytes({ 0xCF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF })), JsonMalformedException);
+    EXPECT_THROW(fromCbor(bytes({ 0x42, 0x01, 0x02 })), JsonMalformedException); // Byte string
+    EXPECT_THROW(fromCbor(bytes({ 0xFF })), JsonMalformedException);
+    EXPECT_THROW(fromCbor(bytes({ 0x3B, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF })), JsonMalformedException);
+    EXPECT_THROW(fromCbor(std::string(100000, static_cast<char>(0x81))), JsonMalformedException); // Nesting depth
+}
+
+TEST(JsonBinaryTests, StreamsMatchBuffers) {
+    JsonArray records;
+    for (int i = 0; i < 500; i++) {
+        records.push_back(parseJson(sampleDocument));
+    }
+    JsonValue value(records);
+
+    std::ostringstream msgpack;
+    writeMessagePack(value, msgpack, 100);
+    EXPECT_EQ(msgpack.str(), toMessagePack(value));
+    std::string cbor;
+    writeCbor(value, [&cbor](const char* data, size_t length) { cbor.append(data, length); }, 100);
+    EXPECT_EQ(cbor, toCbor(value));
+
+    // Consecutive messages in one stream
+    std::stringstream stream;
+    writeMessagePack(value, stream);
+    writeMessagePack(JsonValue(7), stream);
+    EXPECT_EQ(fromMessagePack(stream), value);
+    EXPECT_EQ(fromMessagePack(stream).toInt(), 7);
+    EXPECT_THROW(fromMessagePack(stream), JsonMalformedException);
+
+    std::istringstream cborStream(cbor);
+    EXPECT_EQ(fromCbor(cborStream), value);
+}
+
+}
@@ -0,0 +1,112 @@
+#include "json/JsonParser.h"
+#include "json/JsonBind.h"
+#include <gtest/gtest.h>
+
+namespace Json {
+
+struct BindPoint {
+    int x;
+    int y;
+};
+JSON_BIND(BindPoint, x, y)
+
+struct BindShape {
+    std::string name;
+    double area;
+    bool closed;
+    std::vector<BindPoint> points;
+    std::map<std::string, int> counters;
+    std::unordered_map<std::string, std::vector<float>> series;
+    std::vector<bool> flags;
+    JsonValue extra;
+};
+JSON_BIND(BindShape, name, area, closed, points, counters, series, flags, extra)
+
+static const char* shapeDocument = R"({"name": "triängle", "area": 12, "closed": true,
+    "points": [{"x": 0, "y": 0}, {"y": 4, "x": 3}, {"x": -1, "y": 2, "z": 9}],
+    "counters": {"a": 1, "b": 2}, "series": {"s": [1.5, 2]}, "flags": [true, false], "extra": {"k": [null, "v"]},
+    "ignored": {"deep": [[{"x": "}"}]]}})";
+
+TEST(JsonBindTests, ReadsNestedStructs) {
+    BindShape shape = fromJson<BindShape>(shapeDocument);
+    EXPECT_EQ(shape.name, "tri\xC3\xA4ngle");
+    EXPECT_EQ(shape.area, 12.0);
+    EXPECT_TRUE(shape.closed);
+    ASSERT_EQ(shape.points.size(), 3u);
+    EXPECT_EQ(shape.points[1].x, 3);
+    EXPECT_EQ(shape.points[1].y, 4);
+    EXPECT_EQ(shape.points[2].x, -1);
+    EXPECT_EQ(shape.counters.at("b"), 2);
+    EXPECT_EQ(shape.series.at("s"), std::vector<float>({ 1.5f, 2.0f }));
+    EXPECT_EQ(shape.flags, std::vector<bool>({ true, false }));
+    EXPECT_EQ(shape.extra, parseJson(R"({"k": [null, "v"]})"));
+}
+
+TEST(JsonBindTests, WritesLikeTheValueTree) {
+    BindShape shape = fromJson<BindShape>(shapeDocument);
+    std::string json = toJson(shape);
+    EXPECT_EQ(json.find("ignored"), std::string::npos);
+
+    JsonValue expected = parseJson(shapeDocument);
+    expected.toObject().erase("ignored");
+    expected["points"][2].toObject().erase("z");
+    EXPECT_EQ(parseJson(json), expected);
+
+    // Round trip
+    BindShape copy = fromJson<BindShape>(json);
+    EXPECT_EQ(toJson(copy), json);
+    EXPECT_EQ(toJson(std::vector<BindPoint>{ { 1, 2 } }), R"([{"x":1,"y":2}])");
+}
+
+TEST(JsonBindTests, ReportsMismatches) {
+    EXPECT_THROW(fromJson<BindPoint>(R"({"x": 1})"), std::out_of_range);
+    EXPECT_THROW(fromJson<BindPoint>(R"({"x": 1, "y": "2"})"), JsonTypeException);
+    EXPECT_THROW(fromJson<BindPoint>(R"({"x": 1, "y": 2.5})"), JsonTypeException);
+    EXPECT_THROW(fromJson<BindPoint>(R"([1, 2])"), JsonTypeException);
+    EXPECT_THROW(fromJson<BindPoint>(R"({"x": 1, "y": 2)"), JsonMalformedException);
+    EXPECT_THROW(fromJson<BindPoint>(R"({"x": 1, "y": 2} {})"), JsonMalformedException);
+    EXPECT_THROW(fromJson<BindPoint>(R"({"x": 1 "y": 2})"), JsonMalformedException);
+    EXPECT_THROW(fromJson<std::vector<int>>("[1, 2,]"), JsonMalformedException);
+    EXPECT_THROW(fromJson<std::vector<int>>("[1, 99999999999]"), std::out_of_range);
+
+    // First occurrence of a duplicate wins, like in parseJson
+    BindPoint point = fromJson<BindPoint>(R"({"x": 1, "y": 2, "x": 3})");
+    EXPECT_EQ(point.x, 1);
+}
+
+TEST(JsonBindTests, ValueMembersMatchParseJson) {
+    const char* values[] = { R"({"a": 1, "a": [2], "b\u00e9\n": {"c": [true, false, null, -1.5e3, 7]}})", "[]", "{}", R"("text")", "-0" };
+    for (const char* json : values) {
+        EXPECT_EQ(fromJson<JsonValue>(json), parseJson(json)) << json;
+        EXPECT_EQ(toJsonString(fromJson<JsonValue>(json)), toJsonString(parseJson(json))) << json;
+    }
+    EXPECT_THROW(fromJson<JsonValue>(R"({"a": [1, 2})"), JsonMalformedException);
+    EXPECT_THROW(fromJson<JsonValue>(R"({"a": tru})"), JsonMalformedException);
+    EXPECT_THROW(fromJson<JsonValue>(R"({"a": 1, "a": [01]})"), JsonMalformedException);
+}
+
+#ifdef JSONPARSER_HAS_OPTIONAL
+struct BindUser {
+    int id;
+    std::optional<std::string> email;
+    std::optional<BindPoint> location;
+    std::vector<std::optional<int>> scores;
+};
+JSON_BIND(BindUser, id, email, location, scores)
+
+TEST(JsonBindTests, OptionalMembers) {
+    BindUser user = fromJson<BindUser>(R"({"id": 7, "location": null, "scores": [1, null]})");
+    EXPECT_EQ(user.id, 7);
+    EXPECT_FALSE(user.email.has_value());
+    EXPECT_FALSE(user.location.has_value());
+    ASSERT_EQ(user.scores.size(), 2u);
+    EXPECT_EQ(user.scores[0], 1);
+    EXPECT_FALSE(user.scores[1].has_value());
+    EXPECT_EQ(toJson(user), R"({"id":7,"scores":[1,null]})"); // Empty optional members are left out
+
+    user.location = BindPoint{ 1, 2 };
+    EXPECT_EQ(fromJson<BindUser>(toJson(user)).location->y, 2);
+}
+#endif
+
+}
@@ -0,0 +1,96 @@
+#include "json/JsonParser.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <limits>
+
+namespace Json {
+
+static std::string canonicalString(const JsonValue& value) {
+    WriteOptions options;
+    options.canonical = true;
+    return toJsonString(value, options);
+}
+
+TEST(JsonCanonicalTests, SortsKeysByUtf16CodeUnits) {
+    // Example of RFC 8785 section 3.2.3
+    JsonValue value = parseJson(R"({"\u20ac": 1, "\r": 2, "\ufb33": 3, "1": 4, "\ud83d\ude00": 5, "\u0080": 6, "\u00f6": 7})");
+    EXPECT_EQ(canonicalString(value), "{\"\\r\":2,\"1\":4,\"\xC2\x80\":6,\"\xC3\xB6\":7,\"\xE2\x82\xAC\":1,\"\xF0\x9F\x98\x80\":5,\"\xEF\xAC\xB3\":3}");
+}
+
+TEST(JsonCanonicalTests, FormatsNumbersLikeEcmaScript) {
+    EXPECT_EQ(canonicalString(JsonValue(1e30)), "1e+30");
+    EXPECT_EQ(canonicalString(JsonValue(4.5)), "4.5");
+    EXPECT_EQ(canonicalString(JsonValue(0.002)), "0.002");
+    EXPECT_EQ(canonicalString(JsonValue(1e-27)), "1e-27");
+    EXPECT_EQ(canonicalString(JsonValue(333333333.33333329)), "333333333.3333333");
+    EXPECT_EQ(canonicalString(JsonValue(1e21)), "1e+21");
+    EXPECT_EQ(canonicalString(JsonValue(1e20)), "100000000000000000000");
+    EXPECT_EQ(canonicalString(JsonValue(0.000001)), "0.000001");
+    EXPECT_EQ(canonicalString(JsonValue(1e-7)), "1e-7");
+    EXPECT_EQ(canonicalString(JsonValue(-0.0)), "0");
+    EXPECT_EQ(canonicalString(JsonValue(2.0)), "2");
+    EXPECT_EQ(canonicalString(JsonValue(0.1)), "0.1");
+    EXPECT_EQ(canonicalString(JsonValue(-1.5e-9)), "-1.5e-9");
+    EXPECT_EQ(canonicalString(JsonValue(5e-324)), "5e-324");
+    EXPECT_EQ(canonicalString(JsonValue(1.7976931348623157e308)), "1.7976931348623157e+308");
+    EXPECT_EQ(canonicalString(JsonValue(9007199254740992.0)), "9007199254740992");
+
+    EXPECT_THROW(canonicalString(JsonValue(std::numeric_limits<double>::quiet_NaN())), JsonWriteException);
+    EXPECT_THROW(canonicalString(JsonValue(std::numeric_limits<double>::infinity())), JsonWriteException);
+}
+
+TEST(JsonCanonicalTests, OnlyMandatoryEscapes) {
+    WriteOptions options;
+    options.canonical = true;
+    options.escapeNonAscii = true; // Ignored in canonical form
+    JsonValue value(std::string("a/b \"q\" \x01 \xC3\xA9"));
+    std::string out = toJsonString(value, options);
+    EXPECT_EQ(out, "\"a/b \\\"q\\\" \\u0001 \xC3\xA9\"");
+    EXPECT_EQ(serializedSize(value, options), out.size());
+}
+
+TEST(JsonCanonicalTests, IndependentOfInsertionOrderAndLayout) {
+    JsonObject first;
+    JsonObject second;
+    for (int i = 0; i < 100; i++) {
+        first["key" + std::to_string(i)] = JsonValue(i * 0.5);
+        second["key" + std::to_string(99 - i)] = JsonValue((99 - i) * 0.5);
+    }
+    second.rehash(1024); // Different bucket order
+    EXPECT_EQ(canonicalString(JsonValue(first)), canonicalString(JsonValue(second)));
+
+    std::string text = R"([{"b": 1, "a": [2.5, 3], "c": {"z": null, "y": true}}, {"b": 4, "a": [5.5, 6], "c": {"z": null, "y": false}}])";
+    ParseOptions options;
+    options.shareShapes = true;
+    options.packNumbers = true;
+    JsonValue shaped = parseJson(text, options);
+    std::string expected = R"([{"a":[2.5,3],"b":1,"c":{"y":true,"z":null}},{"a":[5.5,6],"b":4,"c":{"y":false,"z":null}}])";
+    EXPECT_EQ(canonicalString(parseJson(text)), expected);
+    EXPECT_EQ(canonicalString(shaped), expected);
+    EXPECT_EQ(canonicalString(shaped), expected); // Second pass uses the sort order cached on the shape
+
+    WriteOptions canonical;
+    canonical.canonical = true;
+    EXPECT_EQ(serializedSize(shaped, canonical), expected.size());
+}
+
+TEST(JsonCanonicalTests, DigestsOfCanonicalForm) {
+    // Canonical form: {"id":7,"name":"widget","tags":["a/b","c"],"weight":1.5}
+    JsonValue value = parseJson(R"({"weight": 1.50, "tags": ["a\/b", "c"], "name": "widget", "id": 7})");
+    Sha256Digest digest = canonicalSha256(value);
+    static const char hexDigits[] = "0123456789abcdef";
+    std::string hex;
+    for (uint8_t byte : digest) {
+        hex += hexDigits[byte >> 4];
+        hex += hexDigits[byte & 15];
+    }
+    EXPECT_EQ(hex, "71734c6ba9c7b39f9e994382f7036c01911061aedde4c8bced0d24dae8aefa0b");
+    EXPECT_EQ(canonicalXxHash64(value), 0xda90f3c42f2acb7cULL);
+    EXPECT_EQ(canonicalXxHash64(value, 42), 0x5ca4194dfb4d1565ULL);
+
+    JsonValue reordered = parseJson(R"({"id": 7, "name": "widget", "tags": ["a/b", "c"], "weight": 1.5})");
+    EXPECT_EQ(canonicalSha256(reordered), digest);
+    EXPECT_NE(canonicalXxHash64(parseJson(R"({"id": 8})")), canonicalXxHash64(parseJson(R"({"id": 7})")));
+}
+
+}
@@ -0,0 +1,57 @@
+#include "json/JsonParser.h"
+#include <gtest/gtest.h>
+
+namespace Json {
+
+static const int deepNesting = 200000; // Far beyond what recursive destruction survives on a default stack
+
+TEST(JsonDestructionTests, DeepArraysDoNotOverflow) {
+    JsonValue value;
+    for (int i = 0; i < deepNesting; i++) {
+        JsonArray array;
+        array.push_back(std::move(value));
+        value = JsonValue(std::move(array));
+    }
+    value = JsonValue(); // Must not recurse
+    EXPECT_TRUE(value.isNull());
+}
+
+TEST(JsonDestructionTests, DeepMixedLayoutsDoNotOverflow) {
+    JsonValue value(1);
+    for (int i = 0; i < deepNesting; i++) {
+        JsonObject object;
+        object["child"] = std::move(value);
+        object["name"] = JsonValue("level");
+        value = JsonValue(std::move(object));
+        if (i % 1000 == 0) {
+            value.share(); // Shared nodes along the chain
+        }
+    }
+}
+
+TEST(JsonDestructionTests, SharedChildrenSurviveParentDestruction) {
+    JsonValue child = parseJson(R"({"nested": [{"a": 1}, [2, 3]]})");
+    child.share();
+    {
+        JsonArray array = { child, parseJson(R"([{"b": [true]}])") };
+        JsonValue parent(std::move(array));
+    }
+    EXPECT_EQ(child["nested"][0]["a"].toInt(), 1);
+    EXPECT_EQ(child["nested"][1][1].toInt(), 3);
+}
+
+TEST(JsonDestructionTests, ReleaseAsync) {
+    JsonValue document = parseJson(R"({"items": [{"id": 1}, {"id": 2}], "name": "doc"})");
+    JsonValue copy = document;
+    releaseAsync(std::move(document));
+    EXPECT_TRUE(document.isNull());
+
+    releaseAsync(JsonValue("not worth a hand off"));
+    for (int i = 0; i < 100; i++) {
+        releaseAsync(parseJson(R"([[1, 2], {"x": "y"}])"));
+    }
+    waitForReleases();
+    EXPECT_EQ(copy["items"][1]["id"].toInt(), 2);
+}
+
+}
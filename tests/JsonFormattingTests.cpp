@@ -0,0 +1,110 @@
+#include "json/JsonParser.h"
+#include "json/JsonWriter.h"
+#include <gtest/gtest.h>
+#include <sstream>
+
+namespace Json {
+
+// Shaped objects keep the key order of the text, which makes the expected output deterministic
+static JsonValue parseOrdered(const std::string& json) {
+    ParseOptions options;
+    options.shareShapes = true;
+    return parseJson(json, options);
+}
+
+static const char* sampleDocument = R"({"name": "widget", "tags": ["a", "b"], "size": {"w": 2, "h": 3.5}, "empty": [], "none": {}})";
+
+TEST(JsonFormattingTests, IndentsNestedContainers) {
+    WriteOptions options;
+    options.indent = 2;
+    options.spaceAfterColon = true;
+    std::string out = toJsonString(parseOrdered(sampleDocument), options);
+    EXPECT_EQ(out,
+              "{\n"
+              "  \"name\": \"widget\",\n"
+              "  \"tags\": [\n"
+              "    \"a\",\n"
+              "    \"b\"\n"
+              "  ],\n"
+              "  \"size\": {\n"
+              "    \"w\": 2,\n"
+              "    \"h\": 3.5\n"
+              "  },\n"
+              "  \"empty\": [],\n"
+              "  \"none\": {}\n"
+              "}");
+    EXPECT_EQ(parseJson(out), parseJson(sampleDocument));
+}
+
+TEST(JsonFormattingTests, TabsAndNewlineStyle) {
+    WriteOptions options;
+    options.indentWithTabs = true;
+    options.newline = "\r\n";
+    EXPECT_EQ(toJsonString(parseOrdered(R"({"a": [1, {"b": null}]})"), options), "{\r\n\t\"a\":[\r\n\t\t1,\r\n\t\t{\r\n\t\t\t\"b\":null\r\n\t\t}\r\n\t]\r\n}");
+}
+
+TEST(JsonFormattingTests, ShortContainersStayOnOneLine) {
+    WriteOptions options;
+    options.indent = 4;
+    options.spaceAfterColon = true;
+    options.inlineWidth = 20;
+    ParseOptions packed;
+    packed.shareShapes = true;
+    packed.packNumbers = true;
+    std::string text = R"({"point": {"x": 1, "y": 2}, "values": [1, 2, 3], "long": ["abcdefghij", "klmnopqrst"]})";
+    std::string expected = "{\n"
+                           "    \"point\": {\"x\": 1, \"y\": 2},\n"
+                           "    \"values\": [1, 2, 3],\n"
+                           "    \"long\": [\n"
+                           "        \"abcdefghij\",\n"
+                           "        \"klmnopqrst\"\n"
+                           "    ]\n"
+                           "}";
+    EXPECT_EQ(toJsonString(parseOrdered(text), options), expected);
+    EXPECT_EQ(toJsonString(parseJson(text, packed), options), expected);
+
+    options.inlineWidth = 1000; // Everything fits, pretty single line form
+    EXPECT_EQ(toJsonString(parseOrdered(text), options), R"({"point": {"x": 1, "y": 2}, "values": [1, 2, 3], "long": ["abcdefghij", "klmnopqrst"]})");
+}
+
+TEST(JsonFormattingTests, SpaceAfterColonInCompactOutput) {
+    WriteOptions options;
+    options.spaceAfterColon = true;
+    EXPECT_EQ(toJsonString(parseOrdered(R"({"a": [1, 2], "b": {"c": true}})"), options), R"({"a": [1,2],"b": {"c": true}})");
+}
+
+TEST(JsonFormattingTests, SizeAndStreamsMatchFormattedString) {
+    WriteOptions options;
+    options.indent = 3;
+    options.spaceAfterColon = true;
+    options.inlineWidth = 12;
+    JsonValue value = parseOrdered(sampleDocument);
+    std::string expected = toJsonString(value, options);
+    EXPECT_EQ(serializedSize(value, options), expected.size());
+
+    std::ostringstream os;
+    writeJson(value, os, options, 7);
+    EXPECT_EQ(os.str(), expected);
+
+    std::string appended;
+    toJsonString(value, appended, options, true);
+    EXPECT_EQ(appended, expected);
+}
+
+TEST(JsonFormattingTests, WriterIndentsLikeSerializer) {
+    WriteOptions options;
+    options.indent = 2;
+    options.spaceAfterColon = true;
+    std::string out;
+    Writer writer(out, options);
+    writer.beginObject()
+        .key("name").value("widget")
+        .key("tags").beginArray().value("a").value("b").endArray()
+        .key("size").value(parseOrdered(R"({"w": 2, "h": 3.5})"))
+        .key("empty").beginArray().endArray()
+        .key("none").beginObject().endObject()
+    .endObject();
+    EXPECT_EQ(out, toJsonString(parseOrdered(sampleDocument), options));
+}
+
+}
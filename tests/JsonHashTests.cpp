@@ -0,0 +1,66 @@
+#include "json/JsonParser.h"
+#include <gtest/gtest.h>
+#include <unordered_set>
+
+namespace Json {
+
+static const char* hashDocument = R"({"name": "cfg", "limits": {"cpu": 2, "mem": 1.5}, "ports": [80, 443], "tags": ["a", "b"], "off": null})";
+
+TEST(JsonHashTests, EqualValuesHashEqual) {
+    JsonValue lhs = parseJson(hashDocument);
+    JsonValue rhs = parseJson(R"({"off": null, "tags": ["a", "b"], "ports": [80, 443], "limits": {"mem": 1.5, "cpu": 2}, "name": "cfg"})");
+    EXPECT_EQ(lhs, rhs);
+    EXPECT_EQ(lhs.hash(), rhs.hash());
+    EXPECT_EQ(JsonValue(0.0).hash(), JsonValue(-0.0).hash());
+}
+
+TEST(JsonHashTests, DifferentValuesHashDifferent) {
+    EXPECT_NE(JsonValue(1).hash(), JsonValue(1.0).hash());
+    EXPECT_NE(JsonValue(1).hash(), JsonValue("1").hash());
+    EXPECT_NE(parseJson("[1, 2]").hash(), parseJson("[2, 1]").hash());
+    EXPECT_NE(parseJson(R"({"a": 1, "b": 2})").hash(), parseJson(R"({"a": 2, "b": 1})").hash());
+    EXPECT_NE(parseJson("[[]]").hash(), parseJson("[[], []]").hash());
+    EXPECT_NE(parseJson(hashDocument).hash(), parseJson(R"({"name": "cfg", "limits": {"cpu": 3, "mem": 1.5}, "ports": [80, 443], "tags": ["a", "b"], "off": null})").hash());
+}
+
+TEST(JsonHashTests, LayoutsHashLikeRegularValues) {
+    ParseOptions options;
+    options.shareShapes = true;
+    options.packNumbers = true;
+    JsonValue plain = parseJson(R"([{"id": 1, "v": [1, 2.5, 3]}, {"id": 2, "v": [4, 5]}])");
+    JsonValue compact = parseJson(R"([{"id": 1, "v": [1, 2.5, 3]}, {"id": 2, "v": [4, 5]}])", options);
+    EXPECT_TRUE(compact[0].isShaped());
+    EXPECT_TRUE(compact[0]["v"].isPacked());
+    EXPECT_EQ(plain.hash(), compact.hash());
+
+    JsonValue shared = plain;
+    shared.share();
+    EXPECT_EQ(shared.hash(), plain.hash());
+}
+
+TEST(JsonHashTests, SharedHashFollowsMutation) {
+    JsonValue base = parseJson(hashDocument);
+    base.share();
+    JsonValue copy = base;
+    EXPECT_EQ(copy, base);
+
+    copy["limits"]["cpu"] = 4;
+    copy.share();
+    EXPECT_NE(copy.hash(), base.hash());
+    EXPECT_NE(copy, base);
+
+    copy["limits"]["cpu"] = 2;
+    copy.share();
+    EXPECT_EQ(copy.hash(), base.hash());
+    EXPECT_EQ(copy, base);
+}
+
+TEST(JsonHashTests, StdHashDedupes) {
+    std::unordered_set<JsonValue> documents;
+    documents.insert(parseJson(R"({"a": [1, 2], "b": "x"})"));
+    documents.insert(parseJson(R"({"b": "x", "a": [1, 2]})"));
+    documents.insert(parseJson(R"({"a": [1, 2], "b": "y"})"));
+    EXPECT_EQ(documents.size(), 2u);
+}
+
+}
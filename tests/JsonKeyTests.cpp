@@ -0,0 +1,108 @@
+#include "json/JsonParser.h"
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <new>
+
+static thread_local size_t allocationCount = 0;
+
+// Counts global allocations of the calling thread for the lookup tests
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    allocationCount++;
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new(size_t size) {
+    if (void* memory = operator new(size, std::nothrow))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return operator new(size, std::nothrow); }
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory, size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+
+namespace Json {
+
+TEST(JsonKeyTests, PrecomputesHash) {
+    Key key("score");
+    EXPECT_EQ(key.name(), "score");
+    EXPECT_EQ(key.hash(), hashKey("score", 5));
+    EXPECT_EQ(KeyHash()(key), KeyHash()(std::string("score")));
+}
+
+TEST(JsonKeyTests, LookupInRegularObject) {
+    JsonValue value = parseJson(R"({"score": 10, "nested": {"score": 3}})");
+    const JsonValue& constValue = value;
+    Key score("score");
+    Key nested("nested");
+
+    EXPECT_EQ(constValue.at(score).toInt(), 10);
+    EXPECT_EQ(constValue[nested][score].toInt(), 3);
+    EXPECT_THROW(constValue.at(Key("missing")), std::out_of_range);
+    EXPECT_THROW(JsonValue(1).at(score), JsonTypeException);
+
+    value[score] = 11;
+    value[Key("added")] = "new";
+    EXPECT_EQ(value["score"].toInt(), 11);
+    EXPECT_EQ(value.at(Key("added")).toString(), "new");
+}
+
+TEST(JsonKeyTests, LookupsDoNotAllocate) {
+    JsonValue value = parseJson(R"({"a member name longer than the small string buffer": 1, "short": 2})");
+    const JsonValue& constValue = value;
+    Key key("a member name longer than the small string buffer");
+
+    size_t before = allocationCount;
+    int sum = 0;
+    for (int i = 0; i < 100; i++) {
+        sum += constValue.at("a member name longer than the small string buffer").toInt();
+        sum += constValue.at(key).toInt();
+        sum += value["short"].toInt();
+    }
+    size_t allocations = allocationCount - before;
+
+    EXPECT_EQ(allocations, 0u);
+    EXPECT_EQ(sum, 400);
+}
+
+TEST(JsonKeyTests, LookupAcrossRehashes) {
+    JsonValue value = JsonObject();
+    std::vector<Key> keys;
+    for (int i = 0; i < 500; i++) {
+        keys.emplace_back("key" + std::to_string(i));
+        value[keys.back()] = i;
+
+        const JsonValue& constValue = value;
+        for (int j = 0; j <= i; j += 7) {
+            ASSERT_EQ(constValue.at(keys[j]).toInt(), j);
+            ASSERT_EQ(constValue.at(keys[j].name().c_str()).toInt(), j);
+        }
+        ASSERT_EQ(constValue.find(Key("missing")), nullptr);
+    }
+}
+
+TEST(JsonKeyTests, LookupInShapedAndSharedObjects) {
+    ParseOptions options;
+    options.shareShapes = true;
+    JsonValue records = parseJson(R"([{"id": 1, "score": 5}, {"id": 2, "score": 7}])", options);
+    records.share();
+
+    Key score("score");
+    const JsonValue& constRecords = records;
+    int sum = 0;
+    for (size_t i = 0; i < 2; i++) {
+        sum += constRecords[i][score].toInt();
+    }
+    EXPECT_EQ(sum, 12);
+
+    records[1][score] = 8;
+    EXPECT_EQ(records[1].at(score).toInt(), 8);
+    EXPECT_EQ(constRecords[0][score].toInt(), 5);
+}
+
+}
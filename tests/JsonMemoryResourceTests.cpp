@@ -0,0 +1,107 @@
+#include "json/JsonParser.h"
+#include <gtest/gtest.h>
+
+#ifdef JSONPARSER_MEMORY_RESOURCE
+#include <cstdlib>
+#include <set>
+
+namespace Json {
+
+// Counts live allocations so tests can check that nothing leaks to or from the default resource
+class CountingResource : public MemoryResource {
+public:
+    std::set<void*> live;
+    size_t allocations = 0;
+
+    void* allocate(size_t size, size_t) override {
+        void* memory = std::malloc(size);
+        live.insert(memory);
+        allocations++;
+        return memory;
+    }
+
+    void deallocate(void* memory, size_t, size_t) noexcept override {
+        EXPECT_EQ(live.erase(memory), 1u);
+        std::free(memory);
+    }
+};
+
+TEST(JsonMemoryResourceTests, ParseAllocatesFromResource) {
+    CountingResource resource;
+    ParseOptions options;
+    options.memoryResource = &resource;
+    {
+        JsonValue value = parseJson(R"({"name": "a rather long string that does not fit inline", "items": [1, {"x": [true]}]})", options);
+        EXPECT_GT(resource.allocations, 0u);
+        EXPECT_EQ(value.toObject().get_allocator().resource(), &resource);
+        EXPECT_EQ(value["items"].toArray().get_allocator().resource(), &resource);
+        EXPECT_EQ(value["items"][1]["x"][0].toBool(), true);
+        EXPECT_EQ(currentMemoryResource(), defaultMemoryResource());
+    }
+    EXPECT_TRUE(resource.live.empty());
+}
+
+TEST(JsonMemoryResourceTests, ScopeAppliesToConstruction) {
+    CountingResource resource;
+    {
+        MemoryResourceScope scope(&resource);
+        JsonArray array = { JsonValue(1), JsonValue("two") };
+        JsonValue value(std::move(array));
+        EXPECT_EQ(value.toArray().get_allocator().resource(), &resource);
+
+        // Copies made outside the scope leave the resource
+        JsonValue copy;
+        {
+            MemoryResourceScope inner(defaultMemoryResource());
+            copy = value;
+        }
+        EXPECT_EQ(copy.toArray().get_allocator().resource(), defaultMemoryResource());
+    }
+    EXPECT_TRUE(resource.live.empty());
+}
+
+TEST(JsonMemoryResourceTests, LayoutsStayInResource) {
+    CountingResource resource;
+    ParseOptions options;
+    options.memoryResource = &resource;
+    options.shareShapes = true;
+    options.packNumbers = true;
+    {
+        JsonValue value = parseJson(R"([{"id": 1, "v": [1.5, 2]}, {"id": 2, "v": [3, 4]}])", options);
+        size_t before = resource.allocations;
+
+        // The sorted member order of a shape lands next to the shape, the vector and its buffer
+        WriteOptions canonical;
+        canonical.canonical = true;
+        toJsonString(value, canonical);
+        EXPECT_EQ(resource.allocations, before + 2);
+
+        // Lazily built fallbacks land in the owner's resource even outside the scope
+        const JsonValue& constValue = value;
+        EXPECT_EQ(constValue[0].toObject().get_allocator().resource(), &resource);
+        EXPECT_EQ(constValue[1]["v"].toArray().get_allocator().resource(), &resource);
+        value[0]["extra"] = true;
+        value[1]["v"].toArray().push_back(JsonValue(5));
+        EXPECT_GT(resource.allocations, before);
+        EXPECT_EQ(toJsonString(value[1]["v"]), "[3,4,5]");
+    }
+    EXPECT_TRUE(resource.live.empty());
+}
+
+#ifdef JSONPARSER_HAS_PMR
+TEST(JsonMemoryResourceTests, PmrAdapter) {
+    char buffer[4096];
+    std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+    PmrMemoryResource resource(&arena);
+    ParseOptions options;
+    options.memoryResource = &resource;
+
+    JsonValue value = parseJson(R"({"a": [1, 2, 3], "b": "text"})", options);
+    EXPECT_EQ(value["a"][2].toInt(), 3);
+    EXPECT_EQ(value.toObject().get_allocator().resource(), &resource);
+}
+#endif
+
+}
+
+#endif
@@ -0,0 +1,98 @@
+#include "json/JsonParser.h"
+#include <gtest/gtest.h>
+
+namespace Json {
+
+static const char* usageDocument = R"({
+    "name": "a string long enough to need its own heap buffer",
+    "short": "abc",
+    "count": 3,
+    "ratio": 0.5,
+    "flags": [true, false, null],
+    "points": [1, 2.5, 3],
+    "records": [{"id": 1, "label": "first record label that is long"}, {"id": 2, "label": "x"}]
+})";
+
+static void expectSameUsage(const MemoryUsage& lhs, const MemoryUsage& rhs) {
+    for (size_t i = 0; i < 7; i++) {
+        EXPECT_EQ(lhs.nodes[i], rhs.nodes[i]) << "JsonType index " << i;
+    }
+    EXPECT_EQ(lhs.stringBytes, rhs.stringBytes);
+    EXPECT_EQ(lhs.containerOverhead, rhs.containerOverhead);
+    EXPECT_EQ(lhs.totalBytes, rhs.totalBytes);
+}
+
+TEST(JsonMemoryUsageTests, CountsNodesByType) {
+    MemoryUsage usage = memoryUsage(parseJson(usageDocument));
+
+    EXPECT_EQ(usage.count(JsonType::Object), 3u);
+    EXPECT_EQ(usage.count(JsonType::Array), 3u);
+    EXPECT_EQ(usage.count(JsonType::String), 4u);
+    EXPECT_EQ(usage.count(JsonType::Integer), 5u);
+    EXPECT_EQ(usage.count(JsonType::Double), 2u);
+    EXPECT_EQ(usage.count(JsonType::Bool), 2u);
+    EXPECT_EQ(usage.count(JsonType::Null), 1u);
+    EXPECT_EQ(usage.nodeCount(), 20u);
+
+    EXPECT_GT(usage.stringBytes, 0u);
+    EXPECT_GT(usage.containerOverhead, 0u);
+    EXPECT_GT(usage.totalBytes, usage.stringBytes + usage.containerOverhead);
+}
+
+TEST(JsonMemoryUsageTests, PrimitivesOwnNoHeap) {
+    MemoryUsage usage = memoryUsage(JsonValue(42));
+    EXPECT_EQ(usage.count(JsonType::Integer), 1u);
+    EXPECT_EQ(usage.totalBytes, 0u);
+}
+
+TEST(JsonMemoryUsageTests, VectorSlackIsOverhead) {
+    JsonArray array;
+    array.reserve(64);
+    array.push_back(JsonValue(1));
+    MemoryUsage usage = memoryUsage(JsonValue(std::move(array)));
+    EXPECT_GE(usage.containerOverhead, 63 * sizeof(JsonValue));
+}
+
+TEST(JsonMemoryUsageTests, ParseStatsMatchMemoryUsage) {
+    ParseOptions plain;
+    MemoryUsage stats;
+    plain.stats = &stats;
+    JsonValue value = parseJson(usageDocument, plain);
+    expectSameUsage(stats, memoryUsage(value));
+
+    ParseOptions layouts;
+    layouts.shareShapes = true;
+    layouts.packNumbers = true;
+    layouts.stats = &stats;
+    JsonValue shaped = parseJson(usageDocument, layouts);
+    expectSameUsage(stats, memoryUsage(shaped));
+    EXPECT_EQ(stats.nodeCount(), 20u);
+}
+
+TEST(JsonMemoryUsageTests, ParseStatsSkipDuplicateKeys) {
+    const char* json = R"({"a": 1, "b": [2, 3], "a": {"dropped": "a string long enough to need its own heap buffer"}, "b": [4]})";
+    MemoryUsage stats;
+    ParseOptions plain;
+    plain.stats = &stats;
+    JsonValue value = parseJson(json, plain);
+    expectSameUsage(stats, memoryUsage(value));
+    EXPECT_EQ(stats.nodeCount(), 5u);
+
+    ParseOptions shaped;
+    shaped.shareShapes = true;
+    shaped.stats = &stats;
+    JsonValue fallback = parseJson(json, shaped);
+    expectSameUsage(stats, memoryUsage(fallback));
+    EXPECT_EQ(stats.nodeCount(), 5u);
+}
+
+TEST(JsonMemoryUsageTests, SharedNodesCountOnce) {
+    JsonValue child = parseJson(R"({"payload": "a string long enough to need its own heap buffer"})");
+    child.share();
+    JsonArray array = { child, child, child };
+    MemoryUsage usage = memoryUsage(JsonValue(std::move(array)));
+    EXPECT_EQ(usage.count(JsonType::Object), 1u);
+    EXPECT_EQ(usage.count(JsonType::String), 1u);
+}
+
+}
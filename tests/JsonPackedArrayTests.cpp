@@ -0,0 +1,106 @@
+#include "json/JsonParser.h"
+#include <gtest/gtest.h>
+
+namespace Json {
+
+static ParseOptions packOptions() {
+    ParseOptions options;
+    options.packNumbers = true;
+    return options;
+}
+
+TEST(JsonPackedArrayTests, IntegerArraysArePacked) {
+    JsonValue value = parseJson("[1, -2, 123456789, 2147483647, -2147483648, 0]", packOptions());
+
+    ASSERT_TRUE(value.isPacked());
+    Span<int> ints = value.asIntSpan();
+    ASSERT_EQ(ints.size(), 6);
+    EXPECT_EQ(ints[0], 1);
+    EXPECT_EQ(ints[1], -2);
+    EXPECT_EQ(ints[2], 123456789);
+    EXPECT_EQ(ints[3], 2147483647);
+    EXPECT_EQ(ints[4], -2147483647 - 1);
+    EXPECT_THROW(value.asDoubleSpan(), JsonTypeException);
+}
+
+TEST(JsonPackedArrayTests, DoublesMatchGenericParser) {
+    std::string json = "[0.1, 3.14159, -2.5e-3, 1E10, 12345678901234567890.5, 2.2250738585072014e-308, 0.30000000000000004, 7]";
+    JsonValue packed = parseJson(json, packOptions());
+    JsonValue regular = parseJson(json);
+
+    ASSERT_TRUE(packed.isPacked());
+    Span<double> doubles = packed.asDoubleSpan();
+    ASSERT_EQ(doubles.size(), regular.toArray().size());
+    for (size_t i = 0; i + 1 < doubles.size(); i++) {
+        EXPECT_EQ(doubles[i], regular[i].toDouble()) << "element " << i;
+    }
+
+    // Integers in mixed arrays keep their type
+    const JsonValue& constPacked = packed;
+    EXPECT_TRUE(constPacked[7].isInt());
+    EXPECT_EQ(constPacked[7].toInt(), 7);
+    EXPECT_EQ(packed, regular);
+    EXPECT_EQ(toJsonString(packed), toJsonString(regular));
+}
+
+TEST(JsonPackedArrayTests, ForEachElementReadsBuffers) {
+    const JsonValue packed = parseJson("[1, 2.5, 3]", packOptions());
+    size_t before = memoryUsage(packed).totalBytes;
+    std::string elements;
+    bool completed = packed.forEachElement([&elements](size_t index, const JsonValue& element) {
+        elements += std::to_string(index) + ":" + toJsonString(element) + " ";
+        return true;
+    });
+    bool stopped = !packed.forEachElement([](size_t index, const JsonValue&) { return index < 1; });
+
+    EXPECT_TRUE(completed);
+    EXPECT_TRUE(stopped);
+    EXPECT_EQ(elements, "0:1 1:2.5 2:3 ");
+    EXPECT_EQ(packed.size(), 3u);
+    EXPECT_EQ(memoryUsage(packed).totalBytes, before); // No regular array was built
+    EXPECT_THROW(JsonValue(1).forEachElement([](size_t, const JsonValue&) { return true; }), JsonTypeException);
+}
+
+TEST(JsonPackedArrayTests, NonNumericArraysStayRegular) {
+    JsonValue value = parseJson(R"({"a": [1, "two"], "b": [], "c": [[1], [2]], "d": [1, 2]})", packOptions());
+
+    EXPECT_FALSE(value["a"].isPacked());
+    EXPECT_FALSE(value["b"].isPacked());
+    EXPECT_FALSE(value["c"].isPacked());
+    EXPECT_TRUE(value["c"][0].isPacked());
+    EXPECT_TRUE(value["d"].isPacked());
+}
+
+TEST(JsonPackedArrayTests, InvalidNumbersStillThrow) {
+    EXPECT_THROW(parseJson("[1, 01]", packOptions()), JsonMalformedException);
+    EXPECT_THROW(parseJson("[1, 2,]", packOptions()), JsonMalformedException);
+    EXPECT_THROW(parseJson("[1.]", packOptions()), JsonMalformedException);
+    EXPECT_THROW(parseJson("[2147483648]", packOptions()), std::out_of_range);
+}
+
+TEST(JsonPackedArrayTests, MutationFallsBackToRegularArray) {
+    JsonValue value = parseJson("[1, 2, 3]", packOptions());
+    value[1] = "two";
+
+    EXPECT_FALSE(value.isPacked());
+    EXPECT_EQ(value[0].toInt(), 1);
+    EXPECT_EQ(value[1].toString(), "two");
+    EXPECT_THROW(value.asIntSpan(), JsonTypeException);
+}
+
+TEST(JsonPackedArrayTests, PackExistingArray) {
+    JsonValue value(JsonArray{ 1, 2.5, 3 });
+    EXPECT_TRUE(value.pack());
+    EXPECT_TRUE(value.isPacked());
+    EXPECT_EQ(value.asDoubleSpan()[1], 2.5);
+
+    JsonValue copy = value;
+    EXPECT_TRUE(copy.isPacked());
+    EXPECT_EQ(copy, value);
+
+    JsonValue strings(JsonArray{ "a" });
+    EXPECT_FALSE(strings.pack());
+    EXPECT_THROW(JsonValue(1).pack(), JsonTypeException);
+}
+
+}
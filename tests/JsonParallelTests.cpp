@@ -0,0 +1,110 @@
+#include "json/JsonParser.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <limits>
+#include <sstream>
+
+namespace Json {
+
+// Large enough to be split into several chunks and more than one wave
+static std::string largeDocument() {
+    std::string json = "{\"records\": [";
+    for (int i = 0; i < 20000; i++) {
+        if (i > 0)
+            json += ", ";
+        json += "{\"id\": " + std::to_string(i) + ", \"name\": \"item\\n" + std::to_string(i) + "\", \"tags\": [\"a\", \"b\"], \"score\": " +
+                std::to_string(i * 0.25) + "}";
+    }
+    json += "], \"values\": [";
+    for (int i = 0; i < 10000; i++) {
+        if (i > 0)
+            json += ", ";
+        json += std::to_string(i % 3 == 0 ? i : i + 0.5);
+    }
+    json += "]}";
+    return json;
+}
+
+static WriteOptions parallel(WriteOptions options) {
+    options.threads = 4;
+    return options;
+}
+
+static void expectSameOutput(const JsonValue& value, const WriteOptions& options) {
+    std::string expected = toJsonString(value, options);
+    EXPECT_EQ(toJsonString(value, parallel(options)), expected);
+    EXPECT_EQ(serializedSize(value, parallel(options)), expected.size());
+}
+
+TEST(JsonParallelTests, MatchesSequentialOutput) {
+    std::string text = largeDocument();
+    ParseOptions shaped;
+    shaped.shareShapes = true;
+    shaped.packNumbers = true;
+
+    WriteOptions pretty;
+    pretty.indent = 2;
+    pretty.spaceAfterColon = true;
+    pretty.inlineWidth = 40;
+    WriteOptions canonical;
+    canonical.canonical = true;
+
+    for (const JsonValue& value : { parseJson(text), parseJson(text, shaped) }) {
+        expectSameOutput(value, WriteOptions());
+        expectSameOutput(value, pretty);
+        expectSameOutput(value, canonical);
+    }
+}
+
+TEST(JsonParallelTests, LargeObjects) {
+    JsonObject object;
+    for (int i = 0; i < 10000; i++) {
+        object["key" + std::to_string(i)] = JsonValue(JsonArray{ JsonValue(i), JsonValue("v") });
+    }
+    JsonValue value(object);
+    expectSameOutput(value, WriteOptions());
+
+    WriteOptions canonical;
+    canonical.canonical = true;
+    expectSameOutput(value, canonical);
+}
+
+TEST(JsonParallelTests, StreamsMatchString) {
+    JsonValue value = parseJson(largeDocument());
+    WriteOptions options;
+    options.threads = 0; // One per core
+    std::string expected = toJsonString(value);
+
+    std::ostringstream os;
+    writeJson(value, os, options, 1024);
+    EXPECT_EQ(os.str(), expected);
+
+#ifdef JSONPARSER_HAS_POSIX_IO
+    std::FILE* file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    writeJsonToFd(value, fileno(file), parallel(WriteOptions()));
+    std::rewind(file);
+    std::string written;
+    char buffer[4096];
+    size_t read;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        written.append(buffer, read);
+    }
+    EXPECT_EQ(written, expected);
+    std::fclose(file);
+#endif
+}
+
+TEST(JsonParallelTests, ErrorsOfWorkersReachCaller) {
+    JsonArray array(10000, JsonValue(1.5));
+    array[7777] = JsonValue(std::numeric_limits<double>::quiet_NaN());
+    WriteOptions options;
+    options.canonical = true;
+    EXPECT_THROW(toJsonString(JsonValue(array), parallel(options)), JsonWriteException);
+
+    // Pool is still usable afterwards
+    array[7777] = JsonValue(2);
+    EXPECT_EQ(toJsonString(JsonValue(array), parallel(options)), toJsonString(JsonValue(array), options));
+}
+
+}
@@ -44,6 +44,13 @@ TEST(JsonParsingTests, ParseRawNull) {
     EXPECT_TRUE(parsed.isNull());
 }
 
+TEST(JsonParsingTests, ParseNestedNull) {
+    JsonValue parsed = parseJson(R"({"x": 1, "y": null, "z": [null, 2]})");
+    EXPECT_TRUE(parsed["y"].isNull());
+    EXPECT_TRUE(parsed["z"][0].isNull());
+    EXPECT_EQ(parsed["z"][1].toInt(), 2);
+}
+
 TEST(JsonParsingTests, ParseInvalidBooleanCapitalization) {
     // Invalid TRUE
     std::string invalidJson = "TRUE";
@@ -275,6 +282,18 @@ TEST(JsonParsingTests, InvalidEscapeSequencesInString) {
     EXPECT_THROW(parseJson(invalidJson), JsonMalformedException);
 }
 
+TEST(JsonParsingTests, UnicodeEscapeSequencesInString) {
+    EXPECT_EQ(parseJson(R"("\u0041\u00e9\u20AC")").toString(), "A\xC3\xA9\xE2\x82\xAC");
+    EXPECT_EQ(parseJson(R"("\ud83d\ude00")").toString(), "\xF0\x9F\x98\x80"); // Surrogate pair
+    EXPECT_EQ(parseJson(R"({"\u006bey": 1})")["key"].toInt(), 1);
+    EXPECT_EQ(parseJson("\"raw caf\xC3\xA9\"").toString(), "raw caf\xC3\xA9");
+
+    EXPECT_THROW(parseJson(R"("\u12G4")"), JsonMalformedException);
+    EXPECT_THROW(parseJson(R"("\ud83d")"), JsonMalformedException); // Lone high surrogate
+    EXPECT_THROW(parseJson(R"("\ud83dA")"), JsonMalformedException);
+    EXPECT_THROW(parseJson(R"("\ude00")"), JsonMalformedException); // Lone low surrogate
+}
+
 TEST(JsonParsingTests, ValidUnescapedCharactersInString) {
     std::string validJson;
 
@@ -0,0 +1,115 @@
+#include "json/JsonParser.h"
+#include "json/JsonPatch.h"
+#include <gtest/gtest.h>
+
+namespace Json {
+
+static void expectPatch(const char* document, const char* patch, const char* expected) {
+    const JsonValue operations = parseJson(patch);
+    JsonValue value = parseJson(document);
+    applyPatch(value, operations);
+    EXPECT_EQ(value, parseJson(expected)) << patch;
+    EXPECT_EQ(operations, parseJson(patch));
+
+    JsonValue moved = parseJson(document);
+    applyPatch(moved, parseJson(patch));
+    EXPECT_EQ(moved, parseJson(expected)) << patch;
+}
+
+TEST(JsonPatchTests, AppliesOperations) {
+    expectPatch(R"({"foo": "bar"})", R"([{"op": "add", "path": "/baz", "value": "qux"}])", R"({"foo": "bar", "baz": "qux"})");
+    expectPatch(R"({"foo": ["bar", "baz"]})", R"([{"op": "add", "path": "/foo/1", "value": "qux"}])", R"({"foo": ["bar", "qux", "baz"]})");
+    expectPatch(R"({"foo": [1]})", R"([{"op": "add", "path": "/foo/-", "value": 2}])", R"({"foo": [1, 2]})");
+    expectPatch(R"({"baz": "qux", "foo": "bar"})", R"([{"op": "remove", "path": "/baz"}])", R"({"foo": "bar"})");
+    expectPatch(R"({"foo": ["bar", "qux", "baz"]})", R"([{"op": "remove", "path": "/foo/1"}])", R"({"foo": ["bar", "baz"]})");
+    expectPatch(R"({"baz": "qux"})", R"([{"op": "replace", "path": "/baz", "value": "boo"}])", R"({"baz": "boo"})");
+    expectPatch(R"({"foo": {"bar": "baz", "waldo": "fred"}, "qux": {"corge": "grault"}})",
+                R"([{"op": "move", "from": "/foo/waldo", "path": "/qux/thud"}])",
+                R"({"foo": {"bar": "baz"}, "qux": {"corge": "grault", "thud": "fred"}})");
+    expectPatch(R"({"foo": ["all", "grass", "cows", "eat"]})", R"([{"op": "move", "from": "/foo/1", "path": "/foo/3"}])",
+                R"({"foo": ["all", "cows", "eat", "grass"]})");
+    expectPatch(R"({"a": {"b": [1]}})", R"([{"op": "copy", "from": "/a", "path": "/c"}, {"op": "add", "path": "/c/b/-", "value": 2}])",
+                R"({"a": {"b": [1]}, "c": {"b": [1, 2]}})");
+    expectPatch(R"({"a~b": {"c/d": 1}})", R"([{"op": "replace", "path": "/a~0b/c~1d", "value": 2}])", R"({"a~b": {"c/d": 2}})");
+    expectPatch(R"({"a": 1})", R"([{"op": "replace", "path": "", "value": [1]}])", "[1]");
+    expectPatch(R"({"a": [1, {"b": 2.0}]})", R"([{"op": "test", "path": "/a", "value": [1.0, {"b": 2}]}])", R"({"a": [1, {"b": 2.0}]})");
+}
+
+TEST(JsonPatchTests, RollsBackOnFailure) {
+    const char* document = R"({"list": [1, 2, 3], "map": {"a": "x", "b": "y"}, "keep": true})";
+    const char* patches[] = {
+        R"([{"op": "remove", "path": "/list/0"}, {"op": "add", "path": "/map/a", "value": 5}, {"op": "test", "path": "/keep", "value": false}])",
+        R"([{"op": "move", "from": "/map/a", "path": "/list/1"}, {"op": "copy", "from": "/list", "path": "/map/c"}, {"op": "remove", "path": "/missing"}])",
+        R"([{"op": "move", "from": "/list", "path": "/map/b"}, {"op": "replace", "path": "", "value": null}, {"op": "add", "path": "/x/y", "value": 1}])",
+        R"([{"op": "add", "path": "/list/-", "value": 4}, {"op": "remove", "path": "/list/01"}])",
+        R"([{"op": "add", "path": "/list/4", "value": 4}])",
+        R"([{"op": "move", "from": "/map", "path": "/missing/x"}])",
+        R"([{"op": "move", "from": "/list/0", "path": "/list/9"}])",
+        R"([{"op": "move", "from": "/list", "path": "/keep/x"}])",
+    };
+    for (const char* patch : patches) {
+        JsonValue value = parseJson(document);
+        EXPECT_THROW(applyPatch(value, parseJson(patch)), JsonPatchException) << patch;
+        EXPECT_EQ(value, parseJson(document)) << patch;
+    }
+
+    JsonValue value = parseJson(document);
+    try {
+        applyPatch(value, parseJson(R"([{"op": "remove", "path": "/keep"}, {"op": "test", "path": "/map/a", "value": "z"}])"));
+        FAIL();
+    } catch (const JsonPatchException& e) {
+        EXPECT_EQ(std::string(e.what()), "Patch operation 1: Test failed at \"/map/a\"");
+    }
+}
+
+TEST(JsonPatchTests, RejectsMalformedPatches) {
+    JsonValue object = parseJson(R"({"a": {}})");
+    EXPECT_THROW(applyPatch(object, parseJson(R"({"op": "add", "path": "/a", "value": 1})")), JsonMalformedException);
+
+    const char* patches[] = {
+        R"({"op": "insert", "path": "/a", "value": 1})",
+        R"({"path": "/a", "value": 1})",
+        R"({"op": "add", "value": 1})",
+        R"({"op": "add", "path": "/a"})",
+        R"({"op": "move", "path": "/a"})",
+        R"({"op": "add", "path": "a", "value": 1})",
+        R"({"op": "add", "path": "/a~2", "value": 1})",
+        R"({"op": "move", "from": "/a", "path": "/a/b"})",
+    };
+    for (const char* patch : patches) {
+        JsonValue value = parseJson(R"({"a": {}})");
+        EXPECT_THROW(applyPatch(value, parseJson(std::string("[{\"op\": \"remove\", \"path\": \"/a\"}, ") + patch + "]")), JsonMalformedException) << patch;
+        EXPECT_THROW(applyPatch(value, parseJson(std::string("[") + patch + "]")), JsonMalformedException) << patch;
+        EXPECT_EQ(value, parseJson(R"({"a": {}})"));
+    }
+}
+
+TEST(JsonPatchTests, DiffRoundTrips) {
+    const char* pairs[][2] = {
+        { R"({"a": 1, "b": [1, 2, 3], "c": {"d": "x"}})", R"({"a": 1, "b": [1, 2, 3], "c": {"d": "x"}})" },
+        { R"({"a": 1, "b": {"c": [1, 2]}, "gone": null})", R"({"a": 2.5, "b": {"c": [1, 2, 3]}, "new": {"x": ["y"]}})" },
+        { "[1, 2, 3, 4, 5]", "[1, 9, 8, 7, 4, 5]" },
+        { "[1, 2, 3, 4, 5]", "[1, 5]" },
+        { R"([{"id": 1, "v": "a"}, {"id": 2, "v": "b"}])", R"([{"id": 1, "v": "a"}, {"id": 2, "v": "c"}])" },
+        { R"({"a/b": {"~": 1}})", R"({"a/b": {"~": 2}})" },
+        { R"({"a": 1})", "[1]" },
+    };
+    for (const auto& pair : pairs) {
+        JsonValue from = parseJson(pair[0]);
+        JsonValue to = parseJson(pair[1]);
+        JsonValue patch = diff(from, to);
+        applyPatch(from, patch);
+        EXPECT_EQ(from, to) << pair[0] << " -> " << pair[1];
+    }
+
+    // Only the changed range of an array gets operations
+    EXPECT_EQ(diff(parseJson("[1, 2, 3, 4, 5]"), parseJson("[1, 2, 6, 4, 5]")), parseJson(R"([{"op": "replace", "path": "/2", "value": 6}])"));
+    EXPECT_EQ(diff(parseJson("[1, 2, 3]"), parseJson("[1, 7, 2, 3]")), parseJson(R"([{"op": "add", "path": "/1", "value": 7}])"));
+    EXPECT_EQ(diff(parseJson("[1, 2, 3, 4]"), parseJson("[1, 4]")),
+              parseJson(R"([{"op": "remove", "path": "/2"}, {"op": "remove", "path": "/1"}])"));
+    EXPECT_EQ(diff(parseJson(R"({"a": {"b": 1}})"), parseJson(R"({"a": {"b": 2}})")),
+              parseJson(R"([{"op": "replace", "path": "/a/b", "value": 2}])"));
+    EXPECT_EQ(diff(parseJson("[]"), parseJson("[]")).toArray().size(), 0u);
+}
+
+}
@@ -0,0 +1,70 @@
+#include "json/JsonParser.h"
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+namespace Json {
+
+TEST(JsonPoolTests, ValuesSurviveAcrossThreads) {
+    // Values created on one thread and released on another must not corrupt either free list
+    std::vector<JsonValue> values;
+    std::thread producer([&values]() {
+        for (int i = 0; i < 2000; i++) {
+            values.push_back(parseJson("{\"id\": " + std::to_string(i) + ", \"tags\": [\"a\", \"b\"]}"));
+        }
+    });
+    producer.join();
+
+    for (int i = 0; i < 2000; i++) {
+        EXPECT_EQ(values[i]["id"].toInt(), i);
+        EXPECT_EQ(values[i]["tags"][1].toString(), "b");
+    }
+    values.clear();
+    trimPools();
+}
+
+TEST(JsonPoolTests, ConcurrentParsing) {
+    std::string json = R"({"items": [{"name": "x", "values": [1, 2, 3]}, {"name": "y", "values": []}]})";
+    JsonValue expected = parseJson(json);
+    std::vector<std::thread> threads;
+    std::vector<int> mismatches(4, 0);
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < 500; i++) {
+                if (parseJson(json) != expected) mismatches[t]++;
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (int count : mismatches) {
+        EXPECT_EQ(count, 0);
+    }
+}
+
+#ifdef JSONPARSER_POOL_ALLOCATOR
+TEST(JsonPoolTests, TrimReleasesUnusedChunks) {
+    {
+        std::vector<JsonValue> values;
+        for (int i = 0; i < 20000; i++) {
+            values.push_back(JsonValue("payload" + std::to_string(i)));
+        }
+        EXPECT_GT(pooledBytes(), 0u);
+    }
+    size_t before = pooledBytes();
+    EXPECT_GT(trimPools(), 0u);
+    EXPECT_LT(pooledBytes(), before);
+
+    // Pool still works after trimming
+    JsonValue value = parseJson(R"({"a": [1, "two"]})");
+    EXPECT_EQ(value["a"][1].toString(), "two");
+}
+#else
+TEST(JsonPoolTests, TrimWithoutPoolIsNoOp) {
+    EXPECT_EQ(trimPools(), 0u);
+    EXPECT_EQ(pooledBytes(), 0u);
+}
+#endif
+
+}
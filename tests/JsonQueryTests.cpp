@@ -0,0 +1,145 @@
+#include "json/JsonParser.h"
+#include "json/JsonQuery.h"
+#include <algorithm>
+#include <gtest/gtest.h>
+
+namespace Json {
+
+static const char* storeJson = R"({
+    "store": {
+        "book": [
+            {"category": "reference", "author": "Nigel Rees", "title": "Sayings of the Century", "price": 8.95},
+            {"category": "fiction", "author": "Evelyn Waugh", "title": "Sword of Honour", "price": 12.99},
+            {"category": "fiction", "author": "Herman Melville", "title": "Moby Dick", "isbn": "0-553-21311-3", "price": 8.99},
+            {"category": "fiction", "author": "J. R. R. Tolkien", "title": "The Lord of the Rings", "isbn": "0-395-19395-8", "price": 22.99}
+        ],
+        "bicycle": {"color": "red", "price": 399}
+    }
+})";
+
+template <typename Values>
+static std::vector<std::string> serialize(const Values& values) {
+    std::vector<std::string> result;
+    for (const JsonValue& value : values) {
+        result.push_back(toJsonString(value));
+    }
+    return result;
+}
+
+// Tree and streaming evaluation have to find the same nodelist, in the same order where objects are not involved
+static void expectQuery(const char* json, const char* expression, const char* expected, bool ordered = true) {
+    Query query = Query::compile(expression);
+    JsonValue document = parseJson(json);
+    std::vector<JsonValue> tree;
+    for (const JsonValue* match : query.evaluate(document)) {
+        tree.push_back(*match);
+    }
+    // Shaped records and packed arrays are read in place
+    ParseOptions layouts;
+    layouts.shareShapes = true;
+    layouts.packNumbers = true;
+    JsonValue compact = parseJson(json, layouts);
+    std::vector<JsonValue> layoutTree;
+    for (const JsonValue* match : query.evaluate(compact)) {
+        layoutTree.push_back(parseJson(toJsonString(*match))); // Regular objects serialize members in the expected order
+    }
+    std::vector<std::string> treeResults = serialize(tree);
+    std::vector<std::string> layoutResults = serialize(layoutTree);
+    std::vector<std::string> streamResults = serialize(query.evaluateJson(json));
+    std::vector<std::string> expectedResults = serialize(parseJson(expected).toArray());
+    if (!ordered) {
+        std::sort(treeResults.begin(), treeResults.end());
+        std::sort(layoutResults.begin(), layoutResults.end());
+        std::sort(streamResults.begin(), streamResults.end());
+        std::sort(expectedResults.begin(), expectedResults.end());
+    }
+    EXPECT_EQ(treeResults, expectedResults) << expression;
+    EXPECT_EQ(layoutResults, expectedResults) << expression;
+    EXPECT_EQ(streamResults, expectedResults) << expression;
+}
+
+TEST(JsonQueryTests, Selectors) {
+    expectQuery(storeJson, "$.store.book[*].author", R"(["Nigel Rees", "Evelyn Waugh", "Herman Melville", "J. R. R. Tolkien"])");
+    expectQuery(storeJson, "$..author", R"(["Nigel Rees", "Evelyn Waugh", "Herman Melville", "J. R. R. Tolkien"])");
+    expectQuery(storeJson, "$.store..price", "[8.95, 12.99, 8.99, 22.99, 399]", false);
+    expectQuery(storeJson, "$..book[2].title", R"(["Moby Dick"])");
+    expectQuery(storeJson, "$..book[-1].title", R"(["The Lord of the Rings"])");
+    expectQuery(storeJson, "$..book[0,1].title", R"(["Sayings of the Century", "Sword of Honour"])");
+    expectQuery(storeJson, "$..book[:2].price", "[8.95, 12.99]");
+    expectQuery(storeJson, "$['store']['bicycle'][\"color\"]", R"(["red"])");
+    expectQuery(storeJson, "$.store.bicycle.*", R"(["red", 399])", false);
+    expectQuery(storeJson, "$.store.missing[0]", "[]");
+    expectQuery(storeJson, "$.store.book.title", "[]");
+    expectQuery(storeJson, "$", std::string("[" + std::string(storeJson) + "]").c_str());
+
+    expectQuery("[0, 1, 2, 3, 4, 5, 6]", "$[1:5:2]", "[1, 3]");
+    expectQuery("[0, 1, 2, 3, 4, 5, 6]", "$[-2:]", "[5, 6]");
+    expectQuery("[0, 1, 2, 3, 4, 5, 6]", "$[5:1:-2]", "[5, 3]");
+    expectQuery("[0, 1, 2, 3, 4, 5, 6]", "$[::-3]", "[6, 3, 0]");
+    expectQuery("[0, 1, 2, 3, 4, 5, 6]", "$[::0]", "[]");
+    expectQuery("[0, 1, 2]", "$[2, 0, 0]", "[2, 0, 0]"); // Selector order, duplicates kept
+    expectQuery("[[1, 2], [3, 4]]", "$[*][1, 0]", "[2, 1, 4, 3]");
+    expectQuery("[[1, 2], [3, 4]]", "$[1, 0][0]", "[3, 1]");
+    expectQuery(R"({"x": {"author": 1}, "author": 2})", "$..author", "[2, 1]"); // A value's own children before its descendants
+    expectQuery("[[1, [2]], {\"a\": [3]}]", "$..[0]", "[[1, [2]], 1, 2, 3]");
+    expectQuery(R"({"a": {"a": {"a": 1}}})", "$..a", R"([{"a": {"a": 1}}, {"a": 1}, 1])");
+    expectQuery(R"({"a/b": {"it's": 1}, "é": 2})", R"($['a/b']['it\'s'])", "[1]");
+    expectQuery(R"({"a/b": {"it's": 1}, "é": 2})", "$['\\u00e9']", "[2]");
+    expectQuery(storeJson, "$ .store\n.bicycle [ 'color' ]", R"(["red"])");
+}
+
+TEST(JsonQueryTests, Filters) {
+    expectQuery(storeJson, "$..book[?(@.isbn)].title", R"(["Moby Dick", "The Lord of the Rings"])");
+    expectQuery(storeJson, "$..book[?(@.price < 10)].title", R"(["Sayings of the Century", "Moby Dick"])");
+    expectQuery(storeJson, "$..book[?@.category == 'fiction' && !(@.price > 20)].author", R"(["Evelyn Waugh", "Herman Melville"])");
+    expectQuery(storeJson, "$..book[?(@.author >= 'J' || @.price == 8.95)].price", "[8.95, 22.99]");
+    expectQuery(storeJson, "$..book[?(@.missing == @.other)].price", "[8.95, 12.99, 8.99, 22.99]");
+    expectQuery(storeJson, "$..book[?(@.missing != null)].price", "[8.95, 12.99, 8.99, 22.99]");
+    expectQuery(storeJson, "$.store[?(@.color == 'red')].price", "[399]");
+
+    const char* orders = R"({"orders": [{"id": 1, "total": 99.5, "items": [1]}, {"id": 2, "total": 150, "items": [1, 2]},
+                                        {"id": 3, "total": 100, "items": [3, 4]}, {"id": 4, "total": "200"}]})";
+    expectQuery(orders, "$.orders[?(@.total > 100)].id", "[2]");
+    expectQuery(orders, "$.orders[?(@.total >= 100)].id", "[2, 3]");
+    expectQuery(orders, "$.orders[?(@.items[1] == 4)].id", "[3]");
+    expectQuery(orders, "$.orders[?(@.items[-1] == 1)].id", "[1]");
+    expectQuery(orders, "$.orders[?(@.total == 1e2)].id", "[3]");
+    expectQuery(orders, "$.orders[::-1].id", "[4, 3, 2, 1]");
+    expectQuery(orders, "$.orders[?(@.total > 100), 0].id", "[2, 1]");
+}
+
+TEST(JsonQueryTests, ResultsReferToDocument) {
+    JsonValue document = parseJson(storeJson);
+    std::vector<const JsonValue*> results = Query::compile("$.store.bicycle").evaluate(document);
+    ASSERT_EQ(results.size(), 1u);
+    EXPECT_EQ(results[0], &document["store"]["bicycle"]);
+
+    // A compiled query is reused across documents
+    Query query = Query::compile("$[?(@.ok == true)].id");
+    for (int i = 0; i < 3; i++) {
+        JsonValue value = parseJson("[{\"id\": " + std::to_string(i) + ", \"ok\": true}, {\"id\": -1, \"ok\": false}]");
+        results = query.evaluate(value);
+        ASSERT_EQ(results.size(), 1u);
+        EXPECT_EQ(results[0]->toInt(), i);
+    }
+}
+
+TEST(JsonQueryTests, StreamingSkipsAndValidates) {
+    // Unmatched subtrees are skipped, only their brackets have to match
+    Query query = Query::compile("$.a");
+    EXPECT_EQ(query.evaluateJson(R"({"b": [1, {"c": null}], "a": 2})").size(), 1u);
+    EXPECT_THROW(query.evaluateJson(R"({"b": [1, {"c": null]], "a": 2})"), JsonMalformedException);
+    EXPECT_THROW(query.evaluateJson(R"({"b": 1, "a": nul})"), JsonMalformedException);
+    EXPECT_THROW(query.evaluateJson(R"({"a": 2)"), JsonMalformedException);
+    EXPECT_THROW(query.evaluateJson(R"({"a": 2} 3)"), JsonMalformedException);
+}
+
+TEST(JsonQueryTests, RejectsInvalidExpressions) {
+    const char* expressions[] = { "", "store", "$.", "$[", "$[0", "$['a'", "$.1a", "$[01]", "$[-0]", "$[?(@.a == )]", "$[?(1)]",
+                                  "$[?(@.* == 1)]", "$[?(@..a)]", "$[?($.a)]", "$[?(@.a = 1)]", "$[?(@.a == [1])]", "$['\\x']", "$.a b", "$.a ", "$. a" };
+    for (const char* expression : expressions) {
+        EXPECT_THROW(Query::compile(expression), JsonMalformedException) << expression;
+    }
+}
+
+}
@@ -0,0 +1,165 @@
+#include "json/JsonParser.h"
+#include "json/JsonSchema.h"
+#include <gtest/gtest.h>
+
+namespace Json {
+
+static const char* orderSchema = R"({
+    "$defs": {
+        "item": {
+            "type": "object",
+            "properties": {
+                "sku": {"type": "string", "pattern": "^[A-Z]{3}-[0-9]+$"},
+                "quantity": {"type": "integer", "minimum": 1, "maximum": 100},
+                "price": {"type": "number", "exclusiveMinimum": 0, "multipleOf": 0.01}
+            },
+            "required": ["sku", "quantity"],
+            "additionalProperties": false
+        }
+    },
+    "type": "object",
+    "properties": {
+        "id": {"type": "integer"},
+        "status": {"enum": ["open", "paid", "shipped"]},
+        "items": {"type": "array", "items": {"$ref": "#/$defs/item"}, "minItems": 1},
+        "tags": {"type": "array", "uniqueItems": true, "items": {"type": "string", "maxLength": 3}},
+        "note": {"type": ["string", "null"]}
+    },
+    "required": ["id", "items"]
+})";
+
+// Both validation paths have to agree, including the reported position
+static void expectResult(const Schema& schema, const char* json, bool valid, const std::string& path = "") {
+    SchemaError treeError;
+    SchemaError streamError;
+    EXPECT_EQ(schema.validate(parseJson(json), &treeError), valid) << json << ": " << treeError.message;
+    EXPECT_EQ(schema.validateJson(json, &streamError), valid) << json << ": " << streamError.message;
+    EXPECT_EQ(schema.validate(parseJson(json)), valid) << json;
+    ParseOptions layouts;
+    layouts.shareShapes = true;
+    layouts.packNumbers = true;
+    SchemaError layoutError;
+    EXPECT_EQ(schema.validate(parseJson(json, layouts), &layoutError), valid) << json;
+    if (!valid) {
+        EXPECT_EQ(layoutError.path, path) << json;
+        EXPECT_EQ(treeError.path, path) << json;
+        EXPECT_EQ(streamError.path, path) << json;
+        EXPECT_FALSE(treeError.message.empty());
+        EXPECT_EQ(streamError.message, treeError.message) << json;
+    }
+}
+
+TEST(JsonSchemaTests, ValidatesDocument) {
+    Schema schema = Schema::compile(parseJson(orderSchema));
+    expectResult(schema, R"({"id": 1, "status": "paid", "items": [{"sku": "ABC-12", "quantity": 3, "price": 9.99}], "tags": ["a", "b"], "note": null})", true);
+    expectResult(schema, R"({"id": 1, "items": [{"sku": "ABC-12", "quantity": 1}], "extra": {"anything": [1]}})", true);
+
+    expectResult(schema, R"({"items": [{"sku": "ABC-12", "quantity": 1}]})", false);
+    expectResult(schema, R"({"id": "1", "items": [{"sku": "ABC-12", "quantity": 1}]})", false, "/id");
+    expectResult(schema, R"({"id": 1.5, "items": [{"sku": "ABC-12", "quantity": 1}]})", false, "/id");
+    expectResult(schema, R"({"id": 1, "status": "lost", "items": [{"sku": "ABC-12", "quantity": 1}]})", false, "/status");
+    expectResult(schema, R"({"id": 1, "items": []})", false, "/items");
+    expectResult(schema, R"({"id": 1, "items": [{"sku": "ABC-12", "quantity": 1}, {"sku": "abc-12", "quantity": 1}]})", false, "/items/1/sku");
+    expectResult(schema, R"({"id": 1, "items": [{"sku": "ABC-12", "quantity": 101}]})", false, "/items/0/quantity");
+    expectResult(schema, R"({"id": 1, "items": [{"sku": "ABC-12", "quantity": 1, "price": 0}]})", false, "/items/0/price");
+    expectResult(schema, R"({"id": 1, "items": [{"sku": "ABC-12", "quantity": 1, "price": 1.005}]})", false, "/items/0/price");
+    expectResult(schema, R"({"id": 1, "items": [{"sku": "ABC-12", "quantity": 1, "color": "red"}]})", false, "/items/0/color");
+    expectResult(schema, R"({"id": 1, "items": [{"quantity": 1}]})", false, "/items/0");
+    expectResult(schema, R"({"id": 1, "items": [{"sku": "ABC-12", "quantity": 1}], "tags": ["a", "a"]})", false, "/tags");
+    expectResult(schema, R"({"id": 1, "items": [{"sku": "ABC-12", "quantity": 1}], "tags": ["long"]})", false, "/tags/0");
+    expectResult(schema, R"({"id": 1, "items": [{"sku": "ABC-12", "quantity": 1}], "note": 5})", false, "/note");
+    expectResult(schema, "[]", false);
+
+    SchemaError error;
+    EXPECT_FALSE(schema.validate(parseJson(R"({"id": 1, "items": [{"sku": "ABC-12"}]})"), &error));
+    EXPECT_EQ(error.message, "Missing required key \"quantity\"");
+}
+
+TEST(JsonSchemaTests, Combinators) {
+    Schema schema = Schema::compile(parseJson(R"({
+        "anyOf": [{"type": "string", "minLength": 2}, {"type": "integer"}],
+        "not": {"const": 13},
+        "if": {"type": "integer"}, "then": {"minimum": 0}, "else": {"maxLength": 4}
+    })"));
+    expectResult(schema, "12", true);
+    expectResult(schema, R"("abc")", true);
+    expectResult(schema, "13", false);
+    expectResult(schema, "-1", false);
+    expectResult(schema, R"("a")", false);
+    expectResult(schema, R"("abcde")", false);
+    expectResult(schema, "1.5", false);
+
+    Schema exclusive = Schema::compile(parseJson(R"({"oneOf": [{"multipleOf": 3}, {"multipleOf": 5}], "allOf": [{"type": "integer"}]})"));
+    expectResult(exclusive, "9", true);
+    expectResult(exclusive, "15", false);
+    expectResult(exclusive, "7", false);
+
+    Schema contains = Schema::compile(parseJson(R"({"contains": {"const": "x"}, "maxContains": 1, "prefixItems": [{"type": "integer"}]})"));
+    expectResult(contains, R"([1, "x"])", true);
+    expectResult(contains, R"([1, "x", "x"])", false);
+    expectResult(contains, R"(["x"])", false, "/0");
+}
+
+TEST(JsonSchemaTests, NumbersCompareByValueAtEveryDepth) {
+    Schema unique = Schema::compile(parseJson(R"({"uniqueItems": true})"));
+    expectResult(unique, "[1, 2.0, 3.5]", true);
+    expectResult(unique, "[1, 1.0]", false);
+    expectResult(unique, R"([{"a": 1}, {"a": 1.0}])", false);
+    expectResult(unique, "[[1, 2], [1.0, 2]]", false);
+    expectResult(unique, R"([{"a": 1}, {"a": 1, "b": 2}])", true);
+
+    Schema constant = Schema::compile(parseJson(R"({"const": {"a": 1, "b": [2]}})"));
+    expectResult(constant, R"({"b": [2.0], "a": 1.0})", true);
+    expectResult(constant, R"({"a": 1, "b": [3]})", false);
+
+    Schema options = Schema::compile(parseJson(R"({"enum": [[1, {"b": 2}], "x"]})"));
+    expectResult(options, R"([1.0, {"b": 2.0}])", true);
+    expectResult(options, R"([1, {"b": 2.5}])", false);
+
+    Schema both = Schema::compile(parseJson(R"({"enum": [1, 2], "const": 2})"));
+    expectResult(both, "2.0", true);
+    expectResult(both, "1", false);
+    expectResult(both, "3", false);
+    Schema disjoint = Schema::compile(parseJson(R"({"enum": [1], "const": 2})"));
+    expectResult(disjoint, "2", false);
+}
+
+TEST(JsonSchemaTests, RecursiveReferences) {
+    Schema schema = Schema::compile(parseJson(R"({
+        "definitions": {"node": {"type": "object", "properties": {"value": {"type": "integer"}, "children": {"type": "array", "items": {"$ref": "#/definitions/node"}}}}},
+        "$ref": "#/definitions/node"
+    })"));
+    expectResult(schema, R"({"value": 1, "children": [{"value": 2, "children": [{"value": 3}]}]})", true);
+    expectResult(schema, R"({"value": 1, "children": [{"value": 2, "children": [{"value": "3"}]}]})", false, "/children/0/children/0/value");
+
+    Schema patterns = Schema::compile(parseJson(R"({"patternProperties": {"^x-": {"type": "string"}, "-y$": {"maxLength": 1}},
+        "additionalProperties": {"type": "integer"}, "propertyNames": {"maxLength": 5}, "maxProperties": 3})"));
+    expectResult(patterns, R"({"x-a": "s", "b": 1, "x-y": "t"})", true);
+    expectResult(patterns, R"({"x-y": "tt"})", false, "/x-y");
+    expectResult(patterns, R"({"b": "s"})", false, "/b");
+    expectResult(patterns, R"({"toolong": 1})", false, "/toolong");
+    expectResult(patterns, R"({"a": 1, "b": 2, "c": 3, "d": 4})", false);
+}
+
+TEST(JsonSchemaTests, BooleanSchemasAndStreaming) {
+    expectResult(Schema::compile(JsonValue(true)), R"({"any": ["thing"]})", true);
+    expectResult(Schema::compile(JsonValue(false)), "null", false);
+
+    // Streaming stops at the first violation, malformed input before it throws like parseJson
+    Schema schema = Schema::compile(parseJson(R"({"items": {"type": "integer"}})"));
+    EXPECT_FALSE(schema.validateJson(R"([1, "2", this is not json)"));
+    EXPECT_THROW(schema.validateJson("[1, 2"), JsonMalformedException);
+    EXPECT_THROW(schema.validateJson("[1, 2] 3"), JsonMalformedException);
+}
+
+TEST(JsonSchemaTests, RejectsInvalidSchemas) {
+    EXPECT_THROW(Schema::compile(parseJson(R"({"type": "float"})")), JsonMalformedException);
+    EXPECT_THROW(Schema::compile(parseJson(R"({"minLength": -1})")), JsonMalformedException);
+    EXPECT_THROW(Schema::compile(parseJson(R"({"pattern": "(unclosed"})")), JsonMalformedException);
+    EXPECT_THROW(Schema::compile(parseJson(R"({"$ref": "#/missing"})")), JsonMalformedException);
+    EXPECT_THROW(Schema::compile(parseJson(R"({"$ref": "other.json#/a"})")), JsonMalformedException);
+    EXPECT_THROW(Schema::compile(parseJson(R"({"$ref": "#"})")), JsonMalformedException);
+    EXPECT_THROW(Schema::compile(parseJson(R"({"properties": {"a": 1}})")), JsonMalformedException);
+}
+
+}
@@ -0,0 +1,186 @@
+#include "json/JsonParser.h"
+#include <gtest/gtest.h>
+#include <climits>
+#include <cstdio>
+#include <sstream>
+#ifdef JSONPARSER_HAS_POSIX_IO
+#include <unistd.h>
+#endif
+
+namespace Json {
+
+TEST(JsonSerializationTests, AppendsToBuffer) {
+    std::string out = "prefix:";
+    toJsonString(parseJson(R"([1, "two", {"three": 3.5}])"), out);
+    EXPECT_EQ(out, R"(prefix:[1,"two",{"three":3.5}])");
+}
+
+TEST(JsonSerializationTests, ReusedBufferKeepsCapacity) {
+    JsonValue value = parseJson(R"({"items": [1, 2, 3], "name": "some text"})");
+    std::string out;
+    toJsonString(value, out);
+    std::string first = out;
+    size_t capacity = out.capacity();
+
+    out.clear();
+    toJsonString(value, out);
+    EXPECT_EQ(out, first);
+    EXPECT_EQ(out.capacity(), capacity);
+}
+
+TEST(JsonSerializationTests, ExactSizePrePass) {
+    JsonValue value = parseJson(R"({"s": "quote \" slash / tab \t", "n": [-2147483648, 0, 1e300, -0.5, true, null], "o": {}})");
+    std::string expected = toJsonString(value);
+    EXPECT_EQ(serializedSize(value), expected.size());
+
+    std::string out;
+    toJsonString(value, out, true);
+    EXPECT_EQ(out, expected);
+}
+
+TEST(JsonSerializationTests, NumberFormatting) {
+    EXPECT_EQ(toJsonString(JsonValue(INT_MIN)), "-2147483648");
+    EXPECT_EQ(toJsonString(JsonValue(INT_MAX)), "2147483647");
+    EXPECT_EQ(toJsonString(JsonValue(0.1)), "0.1");
+    EXPECT_EQ(toJsonString(JsonValue(1234567.0)), "1.23457e+06");
+    EXPECT_EQ(toJsonString(JsonValue(1e-7)), "1e-07");
+}
+
+TEST(JsonSerializationTests, EscapesAllControlCharacters) {
+    std::string raw;
+    for (int c = 0; c < 0x20; c++) {
+        raw += static_cast<char>(c);
+    }
+    std::string out = toJsonString(JsonValue(raw));
+    EXPECT_EQ(out, "\"\\u0000\\u0001\\u0002\\u0003\\u0004\\u0005\\u0006\\u0007\\b\\t\\n\\u000b\\f\\r\\u000e\\u000f"
+                   "\\u0010\\u0011\\u0012\\u0013\\u0014\\u0015\\u0016\\u0017\\u0018\\u0019\\u001a\\u001b\\u001c\\u001d\\u001e\\u001f\"");
+    EXPECT_EQ(serializedSize(JsonValue(raw)), out.size());
+    EXPECT_EQ(parseJson(out).toString(), raw);
+}
+
+TEST(JsonSerializationTests, EscapesAtEveryPositionOfLongStrings) {
+    // Covers the vectorized scan, its chunk borders and the scalar tail
+    const char specials[] = { '"', '\\', '/', '\x01', '\x1f', '\x7f', 'a' };
+    for (size_t length = 1; length < 80; length += 7) {
+        for (size_t position = 0; position < length; position++) {
+            for (char special : specials) {
+                std::string raw(length, 'x');
+                raw[position] = special;
+                std::string expected = "\"";
+                for (char c : raw) {
+                    switch (c) {
+                        case '"': expected += "\\\""; break;
+                        case '\\': expected += "\\\\"; break;
+                        case '/': expected += "\\/"; break;
+                        case '\x01': expected += "\\u0001"; break;
+                        case '\x1f': expected += "\\u001f"; break;
+                        default: expected += c; break;
+                    }
+                }
+                expected += "\"";
+                ASSERT_EQ(toJsonString(JsonValue(raw)), expected) << "length " << length << " position " << position;
+                ASSERT_EQ(parseJson(expected).toString(), raw);
+            }
+        }
+    }
+}
+
+TEST(JsonSerializationTests, EscapesNonAsciiOnRequest) {
+    JsonValue value(std::string("caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80 bad\xFF!"));
+    EXPECT_EQ(toJsonString(value), "\"caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80 bad\xFF!\""); // Passed through by default
+
+    WriteOptions options;
+    options.escapeNonAscii = true;
+    std::string ascii = toJsonString(value, options);
+    EXPECT_EQ(ascii, "\"caf\\u00e9 \\u20ac \\ud83d\\ude00 bad\\ufffd!\"");
+    EXPECT_EQ(serializedSize(value, options), ascii.size());
+    EXPECT_EQ(parseJson(ascii).toString(), "caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80 bad\xEF\xBF\xBD!");
+
+    JsonObject object;
+    object[std::string("k\xC3\xA9y")] = JsonValue(1);
+    EXPECT_EQ(toJsonString(JsonValue(object), options), "{\"k\\u00e9y\":1}");
+}
+
+TEST(JsonSerializationTests, LayoutsSerializeLikeRegularValues) {
+    ParseOptions options;
+    options.packNumbers = true;
+    JsonValue packed = parseJson("[1, 2.5, -3, 4e10]", options);
+    EXPECT_TRUE(packed.isPacked());
+    EXPECT_EQ(toJsonString(packed), "[1,2.5,-3,4e+10]");
+    EXPECT_EQ(serializedSize(packed), toJsonString(packed).size());
+
+    options.shareShapes = true;
+    JsonValue shaped = parseJson(R"([{"a": "x", "b": [1]}, {"a": "y", "b": []}])", options);
+    EXPECT_EQ(toJsonString(shaped), R"([{"a":"x","b":[1]},{"a":"y","b":[]}])");
+    EXPECT_EQ(serializedSize(shaped), toJsonString(shaped).size());
+}
+
+static JsonValue streamDocument() {
+    JsonArray items;
+    for (int i = 0; i < 200; i++) {
+        items.push_back(parseJson("{\"id\": " + std::to_string(i) + ", \"name\": \"item \\\"" + std::to_string(i) + "\\\"\", \"ratio\": 0.25}"));
+    }
+    JsonObject root;
+    root["items"] = JsonValue(std::move(items));
+    root["blob"] = JsonValue(std::string(10000, 'x')); // Larger than the buffer, bypasses it
+    return JsonValue(std::move(root));
+}
+
+static std::string readFile(std::FILE* file) {
+    std::string content;
+    std::rewind(file);
+    char buffer[4096];
+    size_t read;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        content.append(buffer, read);
+    }
+    return content;
+}
+
+TEST(JsonSerializationTests, StreamsToOstream) {
+    JsonValue value = streamDocument();
+    std::ostringstream os;
+    writeJson(value, os, 64);
+    EXPECT_EQ(os.str(), toJsonString(value));
+
+    std::ostringstream shifted;
+    shifted << value;
+    EXPECT_EQ(shifted.str(), toJsonString(value));
+}
+
+TEST(JsonSerializationTests, StreamsToCallbackInBoundedChunks) {
+    JsonValue value = streamDocument();
+    std::string collected;
+    size_t calls = 0;
+    writeJson(value, [&](const char* data, size_t length) {
+        calls++;
+        collected.append(data, length);
+    }, 256);
+    EXPECT_EQ(collected, toJsonString(value));
+    EXPECT_GT(calls, 1u);
+}
+
+TEST(JsonSerializationTests, StreamsToFile) {
+    JsonValue value = streamDocument();
+    std::FILE* file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    writeJson(value, file, 128);
+    std::fflush(file);
+    EXPECT_EQ(readFile(file), toJsonString(value));
+    std::fclose(file);
+}
+
+#ifdef JSONPARSER_HAS_POSIX_IO
+TEST(JsonSerializationTests, StreamsToFileDescriptor) {
+    JsonValue value = streamDocument();
+    std::FILE* file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    writeJsonToFd(value, fileno(file), 512);
+    EXPECT_EQ(readFile(file), toJsonString(value));
+    std::fclose(file);
+
+    EXPECT_THROW(writeJsonToFd(value, -1), JsonWriteException);
+}
+#endif
+
+}
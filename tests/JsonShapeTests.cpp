@@ -0,0 +1,127 @@
+#include "json/JsonParser.h"
+#include <gtest/gtest.h>
+
+namespace Json {
+
+static ParseOptions shapeOptions() {
+    ParseOptions options;
+    options.shareShapes = true;
+    return options;
+}
+
+TEST(JsonShapeTests, RecordsAreShaped) {
+    JsonValue records = parseJson(R"([{"id": 1, "name": "a"}, {"id": 2, "name": "b"}, {}])", shapeOptions());
+
+    EXPECT_TRUE(records[0].isShaped());
+    EXPECT_TRUE(records[1].isShaped());
+    EXPECT_FALSE(records[2].isShaped());
+    EXPECT_TRUE(records[0].isObject());
+    EXPECT_EQ(records[1].at("id").toInt(), 2);
+    EXPECT_EQ(records[1]["name"].toString(), "b");
+    EXPECT_THROW(records[0].at("missing"), std::out_of_range);
+}
+
+TEST(JsonShapeTests, EqualToRegularObjects) {
+    std::string json = R"({"user": {"id": 123, "roles": ["admin"]}, "active": true})";
+    JsonValue shaped = parseJson(json, shapeOptions());
+    JsonValue regular = parseJson(json);
+
+    EXPECT_EQ(shaped, regular);
+    EXPECT_EQ(regular, shaped);
+    EXPECT_EQ(parseJson(toJsonString(shaped)), regular);
+}
+
+TEST(JsonShapeTests, ConstToObjectMaterializes) {
+    const JsonValue record = parseJson(R"({"a": 1, "b": 2})", shapeOptions());
+    const JsonObject& object = record.toObject();
+
+    EXPECT_EQ(object.size(), 2);
+    EXPECT_EQ(object.at("b").toInt(), 2);
+    EXPECT_EQ(&object, &record.toObject());
+}
+
+TEST(JsonShapeTests, KeysAreDecodedAndValidated) {
+    EXPECT_THROW(parseJson("{\"bad\tkey\": 1}", shapeOptions()), JsonMalformedException);
+    EXPECT_THROW(parseJson(R"({"bad\qkey": 1})", shapeOptions()), JsonMalformedException);
+    EXPECT_TRUE(parseJson(R"([{"esc\"aped": true}, {"esc\"aped": false}])", shapeOptions())[0]["esc\"aped"].toBool());
+}
+
+TEST(JsonShapeTests, NewKeyFallsBackToRegularObject) {
+    JsonValue record = parseJson(R"({"a": 1, "b": 2})", shapeOptions());
+    record["a"] = 10;
+    record.at("b") = 20;
+    EXPECT_TRUE(record.isShaped());
+
+    record["c"] = 3;
+    EXPECT_FALSE(record.isShaped());
+    EXPECT_EQ(record["a"].toInt(), 10);
+    EXPECT_EQ(record["b"].toInt(), 20);
+    EXPECT_EQ(record["c"].toInt(), 3);
+}
+
+TEST(JsonShapeTests, MutableAccessToExistingKeysKeepsShape) {
+    JsonValue records = parseJson(R"([{"id": 1, "score": 5}, {"id": 2, "score": 7}])", shapeOptions());
+    Key score("score");
+    for (size_t i = 0; i < 2; i++) {
+        records[i]["id"] = static_cast<int>(i) + 10;
+        records[i][score] = records[i].at(score).toInt() * 2;
+    }
+
+    EXPECT_TRUE(records[0].isShaped());
+    EXPECT_TRUE(records[1].isShaped());
+    EXPECT_EQ(records[1]["id"].toInt(), 11);
+    EXPECT_EQ(records[1]["score"].toInt(), 14);
+
+    records[0].toObject(); // Non const access to the whole object falls back
+    EXPECT_FALSE(records[0].isShaped());
+    EXPECT_EQ(records[0]["score"].toInt(), 10);
+}
+
+TEST(JsonShapeTests, ForEachMemberReadsInPlace) {
+    const JsonValue record = parseJson(R"({"b": 1, "a": [2]})", shapeOptions());
+    size_t before = memoryUsage(record).totalBytes;
+    std::string keys;
+    record.forEachMember([&keys](const std::string& key, const JsonValue&) {
+        keys += key;
+        return true;
+    });
+    std::string first;
+    record.forEachMember([&first](const std::string& key, const JsonValue&) {
+        first += key;
+        return false;
+    });
+
+    EXPECT_EQ(keys, "ba"); // Shape order
+    EXPECT_EQ(first, "b");
+    EXPECT_EQ(record.size(), 2u);
+    EXPECT_EQ(memoryUsage(record).totalBytes, before);
+    EXPECT_THROW(JsonValue(1).forEachMember([](const std::string&, const JsonValue&) { return true; }), JsonTypeException);
+}
+
+TEST(JsonShapeTests, WritesAfterConstAccessReachMaterializedObject) {
+    JsonValue record = parseJson(R"({"a": 1})", shapeOptions());
+    const JsonObject& view = static_cast<const JsonValue&>(record).toObject();
+
+    record.at("a") = 5;
+    EXPECT_FALSE(record.isShaped());
+    EXPECT_EQ(view.at("a").toInt(), 5);
+}
+
+TEST(JsonShapeTests, CopiesAreIndependent) {
+    JsonValue record = parseJson(R"({"a": 1, "b": [1, 2]})", shapeOptions());
+    JsonValue copy = record;
+    copy["a"] = 2;
+
+    EXPECT_TRUE(copy.isShaped());
+    EXPECT_EQ(record["a"].toInt(), 1);
+    EXPECT_EQ(copy["a"].toInt(), 2);
+    EXPECT_NE(record, copy);
+}
+
+TEST(JsonShapeTests, DuplicateKeysUseRegularObject) {
+    JsonValue record = parseJson(R"({"a": 1, "a": 2})", shapeOptions());
+    EXPECT_FALSE(record.isShaped());
+    EXPECT_EQ(record["a"].toInt(), 1);
+}
+
+}
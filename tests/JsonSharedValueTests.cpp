@@ -0,0 +1,78 @@
+#include "json/JsonParser.h"
+#include <gtest/gtest.h>
+#include <thread>
+
+namespace Json {
+
+TEST(JsonSharedValueTests, ShareKeepsContent) {
+    JsonValue value = parseJson(R"({"name": "base", "limits": {"cpu": 2, "tags": ["a", "b"]}})");
+    JsonValue original = value;
+    value.share();
+
+    EXPECT_TRUE(value.isShared());
+    EXPECT_TRUE(value.isObject());
+    EXPECT_EQ(value, original);
+    EXPECT_EQ(value["limits"]["tags"][1].toString(), "b");
+    EXPECT_EQ(toJsonString(value), toJsonString(original));
+}
+
+TEST(JsonSharedValueTests, CopiesShareStorage) {
+    JsonValue base = parseJson(R"({"a": {"b": 1}})");
+    base.share();
+    JsonValue copy = base;
+
+    EXPECT_TRUE(copy.isShared());
+    EXPECT_EQ(&static_cast<const JsonValue&>(copy).toObject(), &static_cast<const JsonValue&>(base).toObject());
+}
+
+TEST(JsonSharedValueTests, WritesCloneOnlyMutatedPath) {
+    JsonValue base = parseJson(R"({"a": {"b": 1}, "c": {"d": 2}})");
+    base.share();
+    JsonValue copy = base;
+
+    copy["a"]["b"] = 5;
+    EXPECT_FALSE(copy.isShared());
+    EXPECT_FALSE(copy["a"].isShared());
+    EXPECT_EQ(copy["a"]["b"].toInt(), 5);
+    EXPECT_EQ(base["a"]["b"].toInt(), 1);
+
+    // Untouched sibling is still the same shared node
+    const JsonValue& baseC = static_cast<const JsonValue&>(base)["c"];
+    const JsonValue& copyC = static_cast<const JsonValue&>(copy)["c"];
+    EXPECT_TRUE(copyC.isShared());
+    EXPECT_EQ(&baseC.toObject(), &copyC.toObject());
+}
+
+TEST(JsonSharedValueTests, AssignmentReleasesShare) {
+    JsonValue base("text");
+    base.share();
+    JsonValue copy = base;
+    copy = 3;
+    copy = base;
+    copy.toString() += "!";
+
+    EXPECT_EQ(base.toString(), "text");
+    EXPECT_EQ(copy.toString(), "text!");
+}
+
+TEST(JsonSharedValueTests, ConcurrentReadsAndCopies) {
+    JsonValue base = parseJson(R"({"items": [1, 2, 3], "name": "cfg"})");
+    base.share();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&base]() {
+            for (int i = 0; i < 1000; i++) {
+                JsonValue copy = base;
+                copy["items"][0] = i;
+                EXPECT_EQ(static_cast<const JsonValue&>(base)["items"][0].toInt(), 1);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(base["name"].toString(), "cfg");
+}
+
+}
@@ -0,0 +1,118 @@
+#include "json/JsonParser.h"
+#include "json/JsonTape.h"
+#include <gtest/gtest.h>
+#include <fstream>
+#include <sstream>
+
+namespace Json {
+
+static const char* sampleDocument = R"({"id": 42, "name": "widget", "price": 12.75, "tags": ["a", "b", ""], "stock": null, "active": true,
+    "dims": {"w": -3, "h": 1e300, "d": [[], {}, [false]]}, "empty": [], "none": {}})";
+
+// Compares every accessor of the view against the value it was written from
+static void expectSameContent(const ElementView& view, const JsonValue& value) {
+    ASSERT_EQ(view.type(), value.type());
+    switch (value.type()) {
+        case JsonType::Bool: EXPECT_EQ(view.toBool(), value.toBool()); break;
+        case JsonType::Integer: EXPECT_EQ(view.toInt(), value.toInt()); break;
+        case JsonType::Double: EXPECT_EQ(view.toDouble(), value.toDouble()); break;
+        case JsonType::String: EXPECT_EQ(view.toString(), value.toString()); break;
+        case JsonType::Object: {
+            EXPECT_EQ(view.size(), value.toObject().size());
+            size_t members = 0;
+            for (ElementView::Iterator it = view.begin(); it != view.end(); ++it) {
+                expectSameContent(*it, value.at(it.key().toString()));
+                members++;
+            }
+            EXPECT_EQ(members, value.toObject().size());
+            break;
+        }
+        case JsonType::Array: {
+            EXPECT_EQ(view.size(), value.toArray().size());
+            size_t index = 0;
+            for (ElementView element : view) {
+                expectSameContent(element, value.at(index++));
+            }
+            EXPECT_EQ(index, value.toArray().size());
+            break;
+        }
+        default: break;
+    }
+}
+
+TEST(JsonSnapshotTests, ViewMatchesDocument) {
+    ParseOptions shaped;
+    shaped.shareShapes = true;
+    shaped.packNumbers = true;
+    for (const JsonValue& value : { parseJson(sampleDocument), parseJson(sampleDocument, shaped) }) {
+        std::string bytes = toSnapshot(value);
+        Snapshot snapshot = Snapshot::fromBuffer(bytes.data(), bytes.size());
+        EXPECT_EQ(snapshot.sizeBytes(), bytes.size());
+        expectSameContent(snapshot.root(), value);
+    }
+}
+
+TEST(JsonSnapshotTests, Accessors) {
+    std::string bytes = toSnapshot(parseJson(sampleDocument));
+    Snapshot snapshot = Snapshot::fromBuffer(bytes.data(), bytes.size());
+    ElementView root = snapshot.root();
+
+    EXPECT_EQ(root["id"].toInt(), 42);
+    EXPECT_EQ(root.at("price").toDouble(), 12.75);
+    EXPECT_EQ(root[std::string("tags")][1].toString(), "b");
+    EXPECT_EQ(root["tags"].at(2).stringLength(), 0u);
+    EXPECT_STREQ(root["name"].stringData(), "widget");
+    EXPECT_TRUE(root["dims"]["d"][2][0].isBool());
+    EXPECT_FALSE(root["dims"]["d"][2][0].toBool());
+    EXPECT_TRUE(root["empty"].isEmpty());
+    EXPECT_TRUE(root["stock"].isNull());
+
+    EXPECT_THROW(root["missing"], std::out_of_range);
+    EXPECT_THROW(root["tags"][3], std::out_of_range);
+    EXPECT_THROW(root["id"].toString(), JsonTypeException);
+    EXPECT_THROW(root["tags"]["a"], JsonTypeException);
+    EXPECT_THROW(root[0], JsonTypeException);
+}
+
+TEST(JsonSnapshotTests, KeysAreStoredOnce) {
+    // Header, ten tape words and one string entry: 32 bit length, the key and its terminator
+    EXPECT_EQ(toSnapshot(parseJson(R"([{"k": 1}, {"k": 2}])")).size(), 32u + 10 * 8 + 4 + 1 + 1);
+}
+
+TEST(JsonSnapshotTests, OpensMappedFile) {
+    JsonArray records;
+    for (int i = 0; i < 1000; i++) {
+        records.push_back(parseJson(sampleDocument));
+        records.back()["id"] = i;
+    }
+    JsonValue value(records);
+
+    std::string path = testing::TempDir() + "json_snapshot_test.bin";
+    {
+        std::ofstream file(path, std::ios::binary);
+        writeSnapshot(value, file);
+    }
+    {
+        Snapshot snapshot = Snapshot::open(path);
+        Snapshot moved = std::move(snapshot);
+        EXPECT_EQ(moved.root().size(), 1000u);
+        EXPECT_EQ(moved.root()[999]["id"].toInt(), 999);
+        expectSameContent(moved.root(), value);
+    }
+    std::remove(path.c_str());
+
+    std::string streamed;
+    writeSnapshot(value, [&streamed](const char* data, size_t length) { streamed.append(data, length); });
+    EXPECT_EQ(streamed, toSnapshot(value));
+}
+
+TEST(JsonSnapshotTests, RejectsOtherData) {
+    std::string bytes = toSnapshot(parseJson(sampleDocument));
+    EXPECT_THROW(Snapshot::fromBuffer(bytes.data(), bytes.size() - 1), JsonMalformedException);
+    EXPECT_THROW(Snapshot::fromBuffer(bytes.data(), 16), JsonMalformedException);
+    std::string json = toJsonString(parseJson(sampleDocument));
+    EXPECT_THROW(Snapshot::fromBuffer(json.data(), json.size()), JsonMalformedException);
+    EXPECT_THROW(Snapshot::open(testing::TempDir() + "missing_snapshot.bin"), JsonMalformedException);
+}
+
+}
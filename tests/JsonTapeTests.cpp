@@ -0,0 +1,74 @@
+#include "json/JsonParser.h"
+#include "json/JsonTape.h"
+#include <gtest/gtest.h>
+
+namespace Json {
+
+static const char* sampleDocument = R"({"id": 42, "name": "wid\"get é😀", "price": 12.75, "tags": ["a", "b", ""], "stock": null,
+    "active": true, "dims": {"w": -3, "h": 1e300, "d": [[], {}, [false]]}, "empty": [ ], "none": { }, "big": 2147483647, "small": -2147483648})";
+
+TEST(JsonTapeTests, ParsedTapeMatchesParseJson) {
+    Tape tape = parseTape(sampleDocument);
+    EXPECT_EQ(tape.root().toJsonValue(), parseJson(sampleDocument));
+    EXPECT_EQ(tape.root()["name"].toString(), parseJson(sampleDocument)["name"].toString());
+    EXPECT_EQ(Tape(parseJson(sampleDocument)).root().toJsonValue(), parseJson(sampleDocument));
+
+    for (const char* json : { "0", "-0.5", "\"\"", "true", " null ", "[]", "{}", "[[[1]], {\"a\": {\"b\": []}}]", "1.7976931348623157e308" }) {
+        EXPECT_EQ(parseTape(json).root().toJsonValue(), parseJson(json)) << json;
+    }
+}
+
+TEST(JsonTapeTests, Accessors) {
+    Tape tape = parseTape(sampleDocument);
+    ElementView root = tape.root();
+
+    EXPECT_TRUE(root.isObject());
+    EXPECT_EQ(root.size(), 11u);
+    EXPECT_EQ(root["id"].toInt(), 42);
+    EXPECT_EQ(root["small"].toInt(), -2147483648);
+    EXPECT_EQ(root["dims"]["h"].toDouble(), 1e300);
+    EXPECT_EQ(root["tags"].size(), 3u);
+    EXPECT_EQ(root["tags"][1].toString(), "b");
+    EXPECT_TRUE(root["empty"].isEmpty());
+    EXPECT_TRUE(root["none"].isEmpty());
+    EXPECT_EQ(root["dims"]["d"].size(), 3u);
+    EXPECT_FALSE(root["dims"]["d"][2][0].toBool());
+    EXPECT_THROW(root["missing"], std::out_of_range);
+    EXPECT_THROW(root["id"].toDouble(), JsonTypeException);
+
+    // Counts are taken while parsing, iteration skips nested containers in one step
+    std::vector<std::string> keys;
+    for (ElementView::Iterator it = root.begin(); it != root.end(); ++it) {
+        keys.push_back(it.key().toString());
+    }
+    ASSERT_EQ(keys.size(), 11u);
+    EXPECT_EQ(keys.front(), "id");
+    EXPECT_EQ(keys.back(), "small");
+}
+
+TEST(JsonTapeTests, DuplicateKeysKeepFirstLikeParseJson) {
+    Tape tape = parseTape(R"({"a": 1, "a": 2})");
+    EXPECT_EQ(tape.root()["a"].toInt(), 1);
+    EXPECT_EQ(tape.root().toJsonValue(), parseJson(R"({"a": 1, "a": 2})"));
+}
+
+TEST(JsonTapeTests, RejectsMalformedJsonLikeParseJson) {
+    for (const char* json : { "", "   ", "[1, 2", "{\"a\" 1}", "{\"a\": 1,}", "[1 2]", "{1: 2}", "\"open", "tru", "01", "-", "1.", "1e",
+                              "[1] x", "{\"a\": [}", "nul" }) {
+        EXPECT_THROW(parseJson(json), JsonMalformedException) << json;
+        EXPECT_THROW(parseTape(json), JsonMalformedException) << json;
+    }
+    EXPECT_THROW(parseTape("2147483648"), std::out_of_range);
+}
+
+TEST(JsonTapeTests, SnapshotOfParsedTape) {
+    Tape tape = parseTape(sampleDocument);
+    std::string bytes = toSnapshot(tape);
+    JsonValue value = parseJson(sampleDocument);
+    EXPECT_EQ(toSnapshot(Tape(value)), toSnapshot(value));
+    Snapshot snapshot = Snapshot::fromBuffer(bytes.data(), bytes.size());
+    EXPECT_EQ(snapshot.root().toJsonValue(), parseJson(sampleDocument));
+    EXPECT_EQ(snapshot.sizeBytes(), tape.sizeBytes() + 32);
+}
+
+}
@@ -167,4 +167,62 @@ TEST(JsonValueTests, TypeConversionExceptions) {
     EXPECT_THROW(nullValue.toString(), JsonTypeException);
 }
 
+TEST(JsonValueTests, CStringKeyAccess) {
+    JsonValue value = parseJson(R"({"a_rather_long_key_name_beyond_sso": {"id": 7}})");
+    const JsonValue& constValue = value;
+    const char* key = "a_rather_long_key_name_beyond_sso";
+
+    EXPECT_EQ(value[key]["id"].toInt(), 7);
+    EXPECT_EQ(constValue.at(key).at("id").toInt(), 7);
+    EXPECT_THROW(constValue["missing"], std::out_of_range);
+    EXPECT_THROW(value.at("missing"), std::out_of_range);
+    EXPECT_THROW(JsonValue(1)["key"], JsonTypeException);
+
+    value["inserted"] = true;
+    EXPECT_TRUE(value.at(std::string("inserted")).toBool());
+}
+
+TEST(JsonValueTests, CStringKeyAccessShaped) {
+    ParseOptions options;
+    options.shareShapes = true;
+    JsonValue records = parseJson(R"([{"id": 1, "name": "a"}, {"id": 2, "name": "b"}])", options);
+
+    int sum = 0;
+    for (size_t i = 0; i < 2; i++) {
+        sum += records[i]["id"].toInt();
+        EXPECT_FALSE(records[i]["name"].toString().empty());
+    }
+    EXPECT_EQ(sum, 3);
+    EXPECT_TRUE(records[0].isShaped());
+}
+
+TEST(JsonValueTests, SizeOfEveryLayout) {
+    ParseOptions options;
+    options.shareShapes = true;
+    options.packNumbers = true;
+    JsonValue value = parseJson(R"({"records": [{"a": 1, "b": 2}, {"a": 3, "b": 4}], "numbers": [1, 2, 3], "empty": {}})", options);
+
+    EXPECT_EQ(value.size(), 3u);
+    EXPECT_EQ(value["records"].size(), 2u);
+    EXPECT_EQ(value["records"][0].size(), 2u); // Shaped
+    EXPECT_EQ(value["numbers"].size(), 3u); // Packed
+    EXPECT_EQ(value["empty"].size(), 0u);
+    EXPECT_THROW(value["numbers"][0].size(), JsonTypeException);
+
+    value.share();
+    EXPECT_EQ(value.size(), 3u);
+    EXPECT_EQ(value["records"].size(), 2u);
+}
+
+#ifdef JSONPARSER_HAS_STRING_VIEW
+TEST(JsonValueTests, StringViewKeyAccess) {
+    JsonValue value = parseJson(R"({"key": 42})");
+    std::string_view key = "key";
+
+    EXPECT_EQ(value.at(key).toInt(), 42);
+    EXPECT_EQ(value[key].toInt(), 42);
+    EXPECT_TRUE(value[std::string_view("other")].isNull());
+}
+#endif
+
 }
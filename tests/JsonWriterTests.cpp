@@ -0,0 +1,93 @@
+#include "json/JsonWriter.h"
+#include <gtest/gtest.h>
+#include <sstream>
+
+namespace Json {
+
+TEST(JsonWriterTests, WritesNestedDocument) {
+    std::string out;
+    Writer writer(out);
+    writer.beginObject()
+        .key("name").value("Alice \"A\"")
+        .key("age").value(25)
+        .key("scores").beginArray().value(1.5).value(-2).value(true).value(nullptr).endArray()
+        .key("empty").beginObject().endObject()
+    .endObject();
+
+    EXPECT_TRUE(writer.isComplete());
+    EXPECT_EQ(out, R"({"name":"Alice \"A\"","age":25,"scores":[1.5,-2,true,null],"empty":{}})");
+}
+
+TEST(JsonWriterTests, OutputMatchesToJsonString) {
+    JsonValue array = parseJson(R"([0.1, 1234567.0, 1e-7, -0.0, 2147483647, "tab\t/slash", [], [[]], null])");
+    std::string out;
+    Writer writer(out);
+    writer.beginArray();
+    for (const JsonValue& element : array.toArray()) {
+        writer.value(element);
+    }
+    writer.endArray();
+    EXPECT_EQ(out, toJsonString(array));
+
+    std::string scalars;
+    Writer scalarWriter(scalars);
+    scalarWriter.beginArray().value(0.1).value(1234567.0).value(1e-7).value(-0.0).value(2147483647).value("tab\t/slash").endArray();
+    EXPECT_EQ(scalars, toJsonString(parseJson(R"([0.1, 1234567.0, 1e-7, -0.0, 2147483647, "tab\t/slash"])")));
+}
+
+TEST(JsonWriterTests, EmbedsExistingValues) {
+    std::string out;
+    Writer writer(out);
+    writer.beginObject().key("payload").value(parseJson(R"({"inner": [1, 2]})")).key("after").value(false).endObject();
+    EXPECT_EQ(out, R"({"payload":{"inner":[1,2]},"after":false})");
+}
+
+TEST(JsonWriterTests, StreamsThroughSmallBuffer) {
+    std::ostringstream os;
+    std::string expected;
+    {
+        Writer writer(os, 16);
+        Writer reference(expected);
+        writer.beginArray();
+        reference.beginArray();
+        for (int i = 0; i < 500; i++) {
+            writer.value("element " + std::to_string(i));
+            reference.value("element " + std::to_string(i));
+        }
+        writer.endArray();
+        reference.endArray();
+    }
+    EXPECT_EQ(os.str(), expected);
+
+    std::string collected;
+    Writer callbackWriter([&collected](const char* data, size_t length) { collected.append(data, length); }, 8);
+    callbackWriter.beginObject().key("k").value(std::string(100, 'v')).endObject();
+    EXPECT_EQ(collected, "{\"k\":\"" + std::string(100, 'v') + "\"}");
+}
+
+#ifndef NDEBUG
+TEST(JsonWriterTests, DebugChecksNesting) {
+    std::string out;
+    {
+        Writer writer(out);
+        writer.beginObject();
+        EXPECT_THROW(writer.value(1), JsonWriteException); // Missing key
+        EXPECT_THROW(writer.endArray(), JsonWriteException);
+        writer.key("a");
+        EXPECT_THROW(writer.key("b"), JsonWriteException);
+        EXPECT_THROW(writer.endObject(), JsonWriteException);
+        writer.value(1).endObject();
+        EXPECT_THROW(writer.value(2), JsonWriteException); // Second root
+    }
+    {
+        Writer writer(out);
+        EXPECT_THROW(writer.key("top"), JsonWriteException);
+        writer.beginArray();
+        EXPECT_THROW(writer.key("x"), JsonWriteException);
+        EXPECT_THROW(writer.endObject(), JsonWriteException);
+        EXPECT_FALSE(writer.isComplete());
+    }
+}
+#endif
+
+}